@@ -0,0 +1,160 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file BoundsArray.hpp
+ * Declaration of BoundsArray class.
+ */
+
+#ifndef _OF_BOUNDSARRAY_
+#define _OF_BOUNDSARRAY_
+
+#include <OpenFrames/Export.h>
+#include <osg/Group>
+#include <osg/Matrixd>
+#include <osg/Node>
+#include <osg/Referenced>
+#include <osg/Transform>
+#include <osg/ref_ptr>
+#include <utility>
+#include <vector>
+
+namespace OpenFrames
+{
+  class FrameTransform;
+
+  /**
+   * \class BoundsArray
+   *
+   * \brief Flattened array of world-space bounding spheres of a scene.
+   *
+   * The scene is traversed once to find its leaves (drawables, or nodes at the
+   * maximum depth) and the transforms above them. Leaf bounding spheres are then
+   * stored in world space as separate x/y/z/radius arrays, so that frustum tests
+   * and depth computations are simple loops over contiguous memory instead of a
+   * traversal of the scene.
+   *
+   * When transforms change, world-space spheres below them are recomputed from
+   * the stored transforms without traversing the scene. FrameTransforms are
+   * checked with their generation counters, and other static transforms by
+   * comparing their matrices. Changed trajectories update all spheres.
+   *
+   * The scene is only traversed again when its structure changes (child counts
+   * or node masks) or after dirty() is called, e.g. after replacing a child node.
+   * Structure is checked for a limited number of nodes per update, so in very
+   * large scenes a change may take a few updates to be detected. Call dirty()
+   * to apply a change immediately.
+   *
+   * Subgraphs whose bounds depend on the view (cameras, projections, absolute or
+   * eye-following transforms) can't be stored in world space. They are instead
+   * returned as subgraphs that must be traversed separately.
+   */
+  class OF_EXPORT BoundsArray : public osg::Referenced
+  {
+  public:
+    typedef std::pair<double, double> DistancePair;
+    typedef std::vector<DistancePair> PairList;
+
+    /** A view-dependent subgraph, with the world matrix above it */
+    struct Subgraph
+    {
+      osg::ref_ptr<osg::Node> _node;
+      osg::Matrixd _worldMatrix;
+      unsigned int _depth; // Scene depth of the subgraph's node
+    };
+    typedef std::vector<Subgraph> SubgraphList;
+
+    BoundsArray();
+
+    /** Bring the array up to date with the scene. Leaves are nodes at maxDepth,
+        and nodes are included according to the traversal mask and node mask
+        override (see osg::NodeVisitor). Returns true if the scene had to be traversed. */
+    bool update(osg::Node &scene, unsigned int traversalMask, unsigned int nodeMaskOverride,
+                unsigned int maxDepth);
+
+    /** Force a scene traversal at the next update */
+    void dirty() { _valid = false; }
+
+    /** Compute the (near,far) eye distances of spheres that are within the
+        sides of the view frustum, appending them to the given list */
+    void computeDistances(const osg::Matrixd &modelview, const osg::Matrixd &projection,
+                          PairList &pairs) const;
+
+    /** Get the world-space spheres */
+    unsigned int getNumSpheres() const { return _radius.size(); }
+    const double* getCentersX() const { return _centerX.data(); }
+    const double* getCentersY() const { return _centerY.data(); }
+    const double* getCentersZ() const { return _centerZ.data(); }
+    const double* getRadii() const { return _radius.data(); }
+
+    /** Get the view-dependent subgraphs that must be traversed separately */
+    const SubgraphList& getSubgraphs() const { return _subgraphs; }
+
+  protected:
+    virtual ~BoundsArray();
+
+    class Builder; // Traverses the scene to fill the array
+
+    // Whether a node's child count or node mask changed since the last traversal.
+    // Checks a limited number of nodes, continuing from where the last check stopped.
+    bool structureChanged();
+
+    // Sort leaves by the transform above them
+    void sortLeaves();
+
+    // Recompute world matrices of changed transforms and their descendants, or of
+    // all transforms. Returns true if any world matrix was recomputed.
+    bool updateTransforms(bool all);
+
+    // Recompute world-space spheres below changed transforms, or all spheres
+    void updateLeaves(bool all);
+
+    // Nodes visited by the last traversal, with their state at the time
+    std::vector<osg::ref_ptr<osg::Node> > _nodes;
+    std::vector<const osg::Group*> _groups; // Each node as a Group, or NULL
+    std::vector<unsigned int> _nodeMasks;
+    std::vector<unsigned int> _numChildren;
+    unsigned int _nextStructureCheck; // Index of next node to check for changes
+
+    // Transforms above leaves, each after its parent transform
+    std::vector<osg::ref_ptr<osg::Transform> > _transforms;
+    std::vector<const FrameTransform*> _frameTransforms; // Each transform as a FrameTransform, or NULL
+    std::vector<int> _transformParents; // Index of parent transform, or -1 for none
+    std::vector<unsigned int> _transformGenerations; // FrameTransform generations at last update
+    std::vector<osg::Matrixd> _localMatrices; // Matrices of other transforms at last update
+    std::vector<osg::Matrixd> _worldMatrices;
+    std::vector<double> _worldScales; // Largest scale factor of each world matrix
+    std::vector<char> _changedTransforms; // Whether each world matrix changed in the last update
+
+    // Leaves, sorted by the index of the transform above them (-1 for none). Leaves
+    // below transform t are in [_leafRanges[t+1], _leafRanges[t+2]).
+    std::vector<osg::ref_ptr<osg::Node> > _leaves;
+    std::vector<int> _leafTransforms;
+    std::vector<unsigned int> _leafRanges;
+
+    // World-space leaf bounding spheres. Invalid spheres have a negative radius.
+    std::vector<double> _centerX, _centerY, _centerZ, _radius;
+
+    SubgraphList _subgraphs;
+    std::vector<int> _subgraphTransforms; // Index of transform above each subgraph
+
+    bool _valid;
+    unsigned int _traversalMask, _nodeMaskOverride, _maxDepth; // Parameters of the last traversal
+    unsigned int _frameGeneration, _trajectoryGeneration; // Global generations at last update
+  };
+
+} // !namespace OpenFrames
+
+#endif // !define _OF_BOUNDSARRAY_
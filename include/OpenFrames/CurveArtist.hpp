@@ -36,10 +36,23 @@ namespace OpenFrames
    * This class draws a series of Trajectory points connected by lines.
    * The x,y,z components of the points can be independently specified
    * to be any elements of the Trajectory.
+   *
+   * Points are rendered relative to the eye in single precision. By default
+   * each point is split into high and low floats. Alternatively, points can
+   * be grouped into chunks that each have a double-precision center, with
+   * points stored as float offsets from their chunk's center. This halves
+   * vertex memory, at the cost of a precision that depends on chunk size
+   * rather than on distance from the eye.
    */
   class OF_EXPORT CurveArtist : public TrajectoryArtist
   {
   public:
+    /** Encodings of vertex positions */
+    enum VertexEncoding
+    {
+      DOUBLE_SINGLE = 0, // Points split into high and low floats (24 bytes/vertex)
+      CHUNKED_RTC        // Float offsets from chunk centers (12 bytes/vertex)
+    };
 
     CurveArtist(const Trajectory *traj = NULL);
 
@@ -68,6 +81,24 @@ namespace OpenFrames
     void setWidth(float width);
     void setPattern(GLint factor, GLushort pattern);
 
+    /** Set how vertex positions are encoded. Points are recomputed on the
+        next update if the encoding changes. Note that CHUNKED_RTC without a
+        chunk radius (see setChunkRadius) trades precision for memory: chunks
+        are then only limited by their number of points, so a chunk spanning
+        interplanetary distances has errors on the order of meters. */
+    void setVertexEncoding(VertexEncoding encoding);
+    VertexEncoding getVertexEncoding() const { return _vertexEncoding; }
+
+    /** Set the maximum number of points in each chunk, for CHUNKED_RTC encoding */
+    void setChunkSize(unsigned int maxPoints);
+    unsigned int getChunkSize() const { return _chunkSize; }
+
+    /** Set the maximum distance between a point and its chunk's center, for
+        CHUNKED_RTC encoding. Offsets have a precision of about 1e-7 times this
+        radius. Use 0 (default) to only limit the number of points per chunk. */
+    void setChunkRadius(double radius);
+    double getChunkRadius() const { return _chunkRadius; }
+
     /** Data was cleared from or added to the trajectory. Inherited
         from TrajectoryArtist */
     virtual void dataCleared(const Trajectory* traj);
@@ -91,6 +122,10 @@ namespace OpenFrames
 
     mutable bool _dataValid; // If trajectory supports required data
     mutable bool _dataZero; // If we are just drawing at the origin
+
+    VertexEncoding _vertexEncoding; // How vertex positions are encoded
+    unsigned int _chunkSize; // Maximum points per chunk
+    double _chunkRadius; // Maximum distance from chunk center
   };
 
 }
@@ -77,6 +77,13 @@ namespace OpenFrames
   class OF_EXPORT DepthPartitionCallback : public osg::View::Slave::UpdateSlaveCallback
   {
   public:
+    /** How the scene's depth range is rendered */
+    enum DepthMode
+    {
+      PARTITIONED = 0, // Render the scene in multiple depth segments
+      REVERSED_Z       // Render the scene in one pass with a reversed floating-point depth buffer
+    };
+    
     DepthPartitionCallback();
     
     /** Remove all internal slave cameras from current View */
@@ -89,11 +96,70 @@ namespace OpenFrames
     unsigned int getMaxTraversalDepth() const
     { return _distAccumulator->getMaxDepth(); }
     
+    /** Enable incremental partitioning, which reuses the previous frame's results
+        for unchanged parts of the scene and keeps the previous depth segments
+        while they still fit the scene. See DistanceAccumulator for details. */
+    void setIncremental(bool incremental)
+    { _distAccumulator->setIncremental(incremental); }
+    
+    bool getIncremental() const
+    { return _distAccumulator->getIncremental(); }
+    
+    /** Set how much the scene's near/far limits can shrink before depth
+        segments are recomputed in incremental mode, defaults to 0.1 */
+    void setSplitTolerance(double tol)
+    { _distAccumulator->setSplitTolerance(tol); }
+    
+    double getSplitTolerance() const
+    { return _distAccumulator->getSplitTolerance(); }
+    
+    /** Discard results cached by incremental partitioning, e.g. after replacing
+        a child node. Can be called from any thread. */
+    void dirtyCache() { _distAccumulator->dirtyCache(); }
+    
+    /** Use a flattened array of world-space scene bounds instead of traversing
+        the scene every frame. See DistanceAccumulator for details. */
+    void setUseBoundsArray(bool use)
+    { _distAccumulator->setUseBoundsArray(use); }
+    
+    bool getUseBoundsArray() const
+    { return _distAccumulator->getUseBoundsArray(); }
+    
+    /** Set the number of threads that traverse the scene, defaults to 1 */
+    void setNumThreads(unsigned int numThreads)
+    { _distAccumulator->setNumThreads(numThreads); }
+    
+    unsigned int getNumThreads() const
+    { return _distAccumulator->getNumThreads(); }
+    
+    /** Set how the scene's depth range is rendered, defaults to PARTITIONED.
+        REVERSED_Z renders the scene once into a framebuffer object with a 32-bit
+        floating-point depth buffer and a reversed, infinite projection, then draws
+        it over the background. This skips the scene traversal and the extra
+        render passes, but requires OpenGL clip control (4.5 or ARB_clip_control).
+        Partitioning is used instead when that isn't supported, for orthographic
+        projections, or if the CameraManager doesn't support REVERSED_Z (e.g. VR).
+        The scene is blended over the background using its alpha channel, so
+        objects that set their own BlendFunc should accumulate alpha with
+        (ONE, ONE_MINUS_SRC_ALPHA). Objects that set their own depth test function
+        or polygon offset should use a ReversedZStateCallback to flip them. */
+    void setDepthMode(DepthMode mode) { _depthMode = mode; }
+    DepthMode getDepthMode() const { return _depthMode; }
+    
+    /** Check whether the most recent frame was rendered with REVERSED_Z */
+    bool isReversedZActive() const { return _reversedZActive; }
+    
+    /** Check whether the given camera is the one that renders the scene with REVERSED_Z */
+    static bool isReversedZCamera(const osg::Camera* cam);
+    
     /** Define the callback function */
     virtual void updateSlave(osg::View& view, osg::View::Slave& slave);
 
     /** Get the stats text */
     osg::Geode* getStatsGeode() const { return _statsGeode; }
+
+    /** Get the time (seconds) taken by the most recent partitioning */
+    double getPartitionTime() const { return _partitionTime; }
     
     /** Manage cameras for the depth partition callback. */
     struct CameraManager : public virtual osg::Referenced
@@ -112,6 +178,13 @@ namespace OpenFrames
       // Disable all cameras after specified start camera number
       virtual void disableCameras(unsigned int start) = 0;
       
+      // Render the whole scene with a single reversed-z camera. Return false if
+      // this isn't supported, in which case depth partitioning is used instead.
+      virtual bool enableReversedZCamera(osg::Camera* mainCam, const double &zNear) { return false; }
+      
+      // Disable the reversed-z camera, if any
+      virtual void disableReversedZCamera() {}
+      
       // Clear all internal cameras and revert the CameraManger to an unused
       // and empty state
       virtual void reset() = 0;
@@ -137,6 +210,34 @@ namespace OpenFrames
     osg::ref_ptr<osg::Geode> _statsGeode;
     
     unsigned int _numActiveCameras;
+    DepthMode _depthMode;
+    bool _reversedZActive;
+    double _partitionTime; // Time taken by most recent updateSlave()
+  };
+  
+  /**
+   * \class ReversedZStateCallback
+   *
+   * \brief Applies a StateSet to a subgraph when it is rendered with reversed depth.
+   *
+   * This cull callback pushes its StateSet only when the subgraph is culled by the
+   * REVERSED_Z camera of a DepthPartitionCallback. Use it to flip depth functions
+   * and polygon offsets that assume the standard depth range. Attributes in the
+   * StateSet should use OVERRIDE so that they replace the subgraph's own attributes.
+   */
+  class OF_EXPORT ReversedZStateCallback : public osg::NodeCallback
+  {
+  public:
+    ReversedZStateCallback(osg::StateSet *ss) : _stateSet(ss) {}
+    
+    osg::StateSet* getStateSet() const { return _stateSet.get(); }
+    
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+    
+  protected:
+    virtual ~ReversedZStateCallback() {}
+    
+    osg::ref_ptr<osg::StateSet> _stateSet;
   };
   
 } // !namespace OpenFrames
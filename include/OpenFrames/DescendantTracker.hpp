@@ -67,6 +67,9 @@ typedef std::vector<ReferenceFrame*> FramePath;
 	  /** Is the frame tracking a descendant */	
 	inline bool isTrackingDescendant() { return _tracking; }
 
+	  /** Generation counter that is incremented whenever the frame path changes */
+	inline unsigned int getPathGeneration() const { return _pathGeneration; }
+
   protected:
 	virtual ~DescendantTracker();
 
@@ -75,6 +78,7 @@ typedef std::vector<ReferenceFrame*> FramePath;
 
 	FramePath _framePath;
 	bool _tracking;
+	unsigned int _pathGeneration;
   }; // !class DescendantTracker
 
 } // !namespace OpenFrames
@@ -22,10 +22,16 @@
 #define _OF_DISTANCEACCUMULATOR_
 
 #include <OpenFrames/Export.h>
+#include <OpenFrames/BoundsArray.hpp>
+#include <OpenFrames/FrameTransform.hpp>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
 #include <osg/Group>
 #include <osg/NodeVisitor>
 #include <osg/Polytope>
 #include <osg/fast_back_stack>
+#include <map>
 
 namespace OpenFrames
 {
@@ -37,6 +43,30 @@ namespace OpenFrames
    * This class traverses the scene, computes the distance to each
    * visible drawable and splits up the scene if the latter are
    * too far away (in the z direction) from each other.
+   *
+   * In incremental mode, results are reused from the previous traversal:
+   * - The leaf bounds of each FrameTransform subgraph are cached in a BoundsArray,
+   *   relative to the matrix above the subgraph. Distance pairs are computed
+   *   from the cached bounds with the current view, so the cache survives camera
+   *   motion. A subgraph is only traversed again when its structure changes (see
+   *   BoundsArray); moved frames and changed trajectories just update its bounds.
+   *   Nothing is tracked until incremental mode is enabled.
+   * - The previous camera split is kept while it covers all distance pairs and
+   *   the near/far limits stay within a tolerance of the previous ones.
+   * Other changes, e.g. replacing a child node, are not detected; call dirtyCache()
+   * after making them.
+   *
+   * traverseScene() can traverse independent subgraphs in parallel. The top of
+   * the scene is first split into subgraphs, which are then claimed by worker
+   * threads as they become idle. Each thread has its own matrix/frustum stacks
+   * and distance pairs, which are merged once all subgraphs are traversed.
+   *
+   * Alternatively, traverseScene() can use a BoundsArray, which stores the
+   * scene's leaf bounds in world space. Distance pairs are then computed by a
+   * loop over the array, and the scene is only traversed when its structure
+   * changes. View-dependent subgraphs are still traversed. This replaces the
+   * incremental and parallel modes, and like incremental mode, other changes
+   * must be signalled with dirtyCache().
    */
   class OF_EXPORT DistanceAccumulator : public osg::NodeVisitor
   {
@@ -59,6 +89,14 @@ namespace OpenFrames
     // Reset visitor before a new traversal
     virtual void reset();
     
+    // Traverse the scene, collecting near/far distances. Call after reset().
+    void traverseScene(osg::Node &scene);
+    
+    // Set the number of threads used by traverseScene(), including the
+    // calling thread. Defaults to 1, i.e. the scene is not traversed in parallel.
+    void setNumThreads(unsigned int numThreads);
+    inline unsigned int getNumThreads() const { return _numThreads; }
+    
     // Create a (near,far) distance pair for each camera of the specified
     // distance pair list and distance limits.
     void computeCameraPairs();
@@ -77,13 +115,41 @@ namespace OpenFrames
     inline double getNearFarRatio() const { return _nearFarRatio; }
     
     // Set the max traversal depth into the scene graph
-    inline void setMaxDepth(unsigned int depth) { _maxDepth = depth; }
+    inline void setMaxDepth(unsigned int depth)
+    {
+      if(depth != _maxDepth) { _maxDepth = depth; dirtyCache(); }
+    }
     inline unsigned int getMaxDepth() const { return _maxDepth; }
     
     // Set the minimum allowable near plane. Zero means no minimum.
-    inline void setMinZNear(double minZNear) { if(minZNear >= 0.0) _minZNear = minZNear; }
+    inline void setMinZNear(double minZNear)
+    {
+      if((minZNear >= 0.0) && (minZNear != _minZNear)) { _minZNear = minZNear; dirtyCache(); }
+    }
     inline double getMinZNear() { return _minZNear; }
     
+    // Enable reuse of results from the previous traversal
+    void setIncremental(bool incremental);
+    inline bool getIncremental() const { return _incremental; }
+    
+    // Set the relative amount by which the near/far limits can shrink
+    // before the previous camera split is recomputed. Defaults to 0.1.
+    inline void setSplitTolerance(double tol) { if(tol >= 0.0) _splitTolerance = tol; }
+    inline double getSplitTolerance() const { return _splitTolerance; }
+    
+    // Discard cached results at the next reset. Can be called from any thread.
+    inline void dirtyCache() { _cacheDirty.exchange(1); }
+    
+    // Use a flattened array of world-space bounds instead of traversing the scene
+    void setUseBoundsArray(bool use);
+    inline bool getUseBoundsArray() const { return _boundsArray.valid(); }
+    
+    // Number of FrameTransform subgraphs reused by the most recent traversal
+    inline unsigned int getNumReusedSubtrees() const { return _numReusedSubtrees; }
+    
+    // Whether the most recent computeCameraPairs() kept the previous camera split
+    inline bool getSplitReused() const { return _splitReused; }
+    
   protected:
     virtual ~DistanceAccumulator();
     
@@ -91,6 +157,49 @@ namespace OpenFrames
     void pushDistancePair(double zNear, double zFar);
     bool shouldContinueTraversal(osg::Node &node);
     
+    // Traverse a Transform, with its matrix applied
+    void traverseTransform(osg::Transform &transform);
+    
+    // Add the distance pairs of a FrameTransform subgraph from its cached bounds,
+    // which are updated or rebuilt as needed
+    void applyCached(FrameTransform &xform);
+    
+    // Whether the previous camera split covers all distance pairs
+    bool previousSplitCovers() const;
+    
+    // Compute distance pairs from the bounds array
+    void traverseBoundsArray(osg::Node &scene);
+    
+    /** A subgraph to be traversed, with the state above it */
+    struct TraversalTask
+    {
+      osg::Node *_node;
+      osg::Matrix _viewMatrix, _projectionMatrix;
+      unsigned int _depth;
+    };
+    typedef std::vector<TraversalTask> TaskList;
+    
+    class TraversalThread; // Traverses subgraphs in parallel with the calling thread
+    
+    // Split the top of the scene into subgraphs to be traversed in parallel
+    void splitScene(osg::Node &scene);
+    
+    // Store node as a new task if it is at the split depth
+    bool deferToTask(osg::Node &node);
+    
+    // Traverse a task's subgraph
+    void runTask(const TraversalTask &task);
+    
+    // Traverse unclaimed tasks of the given accumulator until none are left
+    void runTasks(DistanceAccumulator &owner);
+    
+    // Prepare a worker thread's accumulator to run the given accumulator's tasks
+    void beginTasks(DistanceAccumulator &owner);
+    
+    // Start/stop worker threads
+    void startThreads();
+    void stopThreads();
+    
     // Stack of matrices accumulated during traversal
     osg::fast_back_stack<osg::Matrix> _viewMatrices;
     osg::fast_back_stack<osg::Matrix> _projectionMatrices;
@@ -122,6 +231,47 @@ namespace OpenFrames
     
     // Minimum zNear value
     double _minZNear;
+    
+    // Cached bounds of a FrameTransform subgraph. The BoundsArray references the
+    // subgraph, which prevents its address from being reused while cached.
+    struct SubtreeCache : public osg::Referenced
+    {
+      SubtreeCache() : _bounds(new BoundsArray), _traversalNum(0) {}
+      osg::ref_ptr<BoundsArray> _bounds;
+      unsigned int _traversalNum; // Most recent traversal that used this subgraph
+      OpenThreads::Mutex _mutex; // Protects bounds if the subgraph is shared by several parents
+    };
+    typedef std::map<const FrameTransform*, osg::ref_ptr<SubtreeCache> > SubtreeCacheMap;
+    SubtreeCacheMap _subtreeCache;
+    
+    // Incremental mode state
+    bool _incremental;
+    bool _useCache; // Whether the cache can be used in the current traversal
+    double _splitTolerance;
+    OpenThreads::Atomic _cacheDirty;
+    unsigned int _traversalNum; // Incremented by each reset()
+    PairList _prevCameraPairs; // Camera split from previous traversal
+    unsigned int _numReusedSubtrees;
+    bool _splitReused;
+    
+    // Flattened scene bounds, if used
+    osg::ref_ptr<BoundsArray> _boundsArray;
+    PairList _boundsPairs; // Distance pairs computed from the bounds array
+    
+    // Parallel traversal state
+    unsigned int _numThreads;
+    DistanceAccumulator *_owner; // Accumulator whose tasks and cache are used by this worker
+    TaskList _tasks; // Subgraphs to be traversed in parallel
+    TaskList *_newTasks; // Receives tasks while splitting the scene
+    unsigned int _splitDepth; // Depth at which nodes become tasks
+    OpenThreads::Atomic _nextTask; // Index of next unclaimed task
+    std::vector<TraversalThread*> _threads;
+    unsigned int _batchNum; // Incremented to start worker threads on new tasks
+    unsigned int _numBusyThreads; // Worker threads that haven't finished all tasks
+    bool _stopRequested; // Tells worker threads to exit
+    OpenThreads::Mutex _threadMutex;
+    OpenThreads::Condition _threadCond; // Signals new tasks or finished threads
+    OpenThreads::Mutex _cacheMutex; // Protects the subgraph cache from worker threads
   };
   
 }
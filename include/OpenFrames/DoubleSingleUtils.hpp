@@ -22,8 +22,10 @@
 #define _OF_DOUBLESINGLEUTILS_
 
 #include <OpenFrames/Export.h>
+#include <osg/Array>
 #include <osg/Vec3d>
 #include <osg/Vec3f>
+#include <vector>
 
 /***********************************************************
  * Ravi Mathur
@@ -41,6 +43,26 @@ namespace OpenFrames
     low  = point - high;
   }
 
+  // Split an array of doubles into arrays of high and low floats, as DS_Split()
+  // does for each Vec3d component. Uses SIMD instructions where available.
+  OF_EXPORT void DS_Split(const double *values, unsigned int numValues, float *high, float *low);
+
+  // Split an array of Vec3d into arrays of high and low Vec3f
+  static inline void DS_Split(const osg::Vec3d *points, unsigned int numPoints, osg::Vec3f *high, osg::Vec3f *low)
+  {
+    if(numPoints > 0) DS_Split(points->ptr(), 3*numPoints, high->ptr(), low->ptr());
+  }
+
+  // Split Vec3d points and append them to arrays of high and low Vec3f
+  static inline void DS_Append(const std::vector<osg::Vec3d> &points, osg::Vec3Array &high, osg::Vec3Array &low)
+  {
+    if(points.empty()) return;
+    unsigned int offset = high.size();
+    high.resize(offset + points.size());
+    low.resize(offset + points.size());
+    DS_Split(&points[0], points.size(), &high[offset], &low[offset]);
+  }
+
   // Perform a - b, where a and b are pairs of Vec3f
   static inline void DS_Subtract(const osg::Vec3f &a_high,
                                  const osg::Vec3f &a_low,
@@ -0,0 +1,153 @@
+/***********************************
+   Copyright 2019 Ravishankar Mathur
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+***********************************/
+
+/** \file FollowerGroup.hpp
+ * Declaration of FollowerGroup class.
+ */
+
+#ifndef _OF_FOLLOWERGROUP_
+#define _OF_FOLLOWERGROUP_
+
+#include <OpenFrames/Export.h>
+#include <OpenFrames/FrameTransform.hpp>
+#include <OpenFrames/Trajectory.hpp>
+#include <OpenFrames/TrajectoryFollower.hpp>
+#include <osg/Callback>
+#include <osg/ref_ptr>
+#include <osg/Quat>
+#include <osg/Vec3d>
+#include <OpenThreads/Barrier>
+#include <OpenThreads/Mutex>
+#include <map>
+#include <vector>
+
+namespace OpenFrames
+{
+  /**
+   * \class FollowerGroup
+   *
+   * \brief Updates many FrameTransform objects from Trajectory objects in one pass.
+   *
+   * This class is an alternative to attaching a separate TrajectoryFollower to
+   * each of a large number of FrameTransforms. It should be added as an update
+   * callback to a node that is traversed before the followed transforms are
+   * culled, e.g. rootFrame->getTransform()->addUpdateCallback(followerGroup).
+   * Each follower follows a single trajectory using its standard X/Y/Z position
+   * and attitude. All follower state is stored in contiguous arrays, and the
+   * new positions/attitudes are computed in one pass that can optionally be
+   * split across multiple threads. The results are then applied to the
+   * followed transforms from the update thread.
+   */
+  class OF_EXPORT FollowerGroup : public osg::Callback, public OpenFrames::TrajectorySubscriber
+  {
+  public:
+    FollowerGroup();
+
+    // Don't allow copying from another FollowerGroup, but still initialize
+    // members in case META_Object's clone() is called
+    FollowerGroup(const FollowerGroup &fg, const osg::CopyOp &copyop) : FollowerGroup() {}
+
+    META_Object(OpenFrames, FollowerGroup);
+
+    // Make the given transform follow the given trajectory. If the transform
+    // is already in this group, then its trajectory and follow type are replaced.
+    // See TrajectoryFollower for the meaning of data and mode. Followers use
+    // linear/slerp interpolation, and EXTRAPOLATE mode is treated as LIMIT.
+    void addFollower(FrameTransform *xform, Trajectory *traj,
+                     unsigned int data = TrajectoryFollower::POSITION + TrajectoryFollower::ATTITUDE,
+                     TrajectoryFollower::FollowMode mode = TrajectoryFollower::LOOP);
+
+    // Stop updating the given transform
+    void removeFollower(FrameTransform *xform);
+
+    // Stop updating all transforms
+    void removeAllFollowers();
+
+    inline unsigned int getNumFollowers() const { return _xforms.size(); }
+
+    // Time managment functions, which apply to all followers in the group
+    // - Offset from the global simulation time (set by WindowProxy)
+    // - Custom simulation time
+    void setTime(double time); // Custom simulation time
+    void setOffsetTime(double offsetTime); // Offset from global simulation time
+    inline bool isFollowingTime() const
+    { return _followTime; } // True for global sim time, false for custom sim time
+
+    // Set number of threads used to compute follower states, including the
+    // update thread. Values of 0 or 1 compute all states in the update thread.
+    void setNumThreads(unsigned int numThreads);
+    inline unsigned int getNumThreads() const { return _numThreads; }
+
+    /** Inherited from osg::Callback, implements the callback. */
+    virtual bool run(osg::Object* object, osg::Object* data);
+
+    /** Inherited from OpenFrames::TrajectorySubscriber
+        Functions that inform about Trajectory changes */
+    virtual void dataCleared(const Trajectory* traj) { _needsUpdate = true; }
+    virtual void dataAdded(const Trajectory* traj) { _needsUpdate = true; }
+
+  protected:
+    virtual ~FollowerGroup();
+
+    class WorkerThread; // Computes follower states for a range of followers
+
+    // Compute states for followers in the range [begin, end)
+    void _computeStates(unsigned int begin, unsigned int end);
+
+    // Get range of followers whose states are computed by the given thread
+    void _getThreadRange(unsigned int threadNum, unsigned int &begin, unsigned int &end) const;
+
+    // Stop and delete all worker threads
+    void _stopWorkers();
+
+    // Subscribe/unsubscribe to a trajectory used by any number of followers
+    void _refTrajectory(Trajectory *traj);
+    void _unrefTrajectory(Trajectory *traj);
+
+    typedef std::map<const FrameTransform*, unsigned int> FollowerIndexMap;
+    typedef std::map<const Trajectory*, unsigned int> TrajRefCountMap;
+
+    // Follower state, each array has one element per follower
+    std::vector<osg::ref_ptr<FrameTransform> > _xforms; // Followed transforms
+    std::vector<osg::ref_ptr<Trajectory> > _trajs;      // Trajectory followed by each transform
+    std::vector<unsigned int> _followData;               // Whether to follow position and/or attitude
+    std::vector<TrajectoryFollower::FollowMode> _followModes; // Mode in which to follow trajectory
+    std::vector<int> _timeIndices;                       // Most recent time index, used as search hint
+    std::vector<osg::Vec3d> _positions;                  // Most recently computed positions
+    std::vector<osg::Quat> _attitudes;                   // Most recently computed attitudes
+    std::vector<unsigned int> _computedData;             // Whether position and/or attitude were computed
+
+    FollowerIndexMap _followerIndices; // Array index of each followed transform
+    TrajRefCountMap _trajRefCounts;    // Number of followers using each trajectory
+
+    // Time control variables
+    bool _needsUpdate, _followTime;
+    double _timeVal;     // Time value to use (offset if following time, constant otherwise)
+    double _lastSimTime; // Simulation time at most recent update
+    double _currTime;    // Time at which follower states are being computed
+
+    // Worker threads and barriers used to synchronize them with the update thread
+    std::vector<WorkerThread*> _workers;
+    unsigned int _numThreads; // Number of worker threads plus the update thread
+    OpenThreads::Barrier _startBarrier, _endBarrier;
+    bool _stopRequested; // Tells worker threads to exit
+
+    OpenThreads::Mutex _mutex; // For adding/removing followers
+  };
+
+} // !namespace OpenFrames
+
+#endif // !define _OF_FOLLOWERGROUP_
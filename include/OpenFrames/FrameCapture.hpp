@@ -0,0 +1,235 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file FrameCapture.hpp
+ * Declaration of FrameCapture class.
+ */
+
+#ifndef _OF_FRAMECAPTURE_
+#define _OF_FRAMECAPTURE_
+
+#include <OpenFrames/Export.h>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+#include <osg/GL>
+#include <osg/GLExtensions>
+#include <osg/GraphicsContext>
+#include <osg/Image>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace OpenFrames
+{
+  /**
+   * \class FrameCapture
+   *
+   * \brief Captures rendered frames without stalling the rendering thread.
+   *
+   * Frames are read from the framebuffer into a ring of pixel buffer objects
+   * (PBOs), so that the GPU copies pixels asynchronously. Each PBO is mapped a
+   * few frames later, when its copy has completed, and the pixels are handed to
+   * a pool of worker threads that encode them with an Encoder.
+   *
+   * The number of frames waiting to be encoded is limited. If that limit is
+   * reached, new frames are dropped (and counted) so that capturing never slows
+   * down interactive rendering. Alternatively, rendering can be made to wait for
+   * the encoders, e.g. when rendering offscreen where every frame is needed.
+   */
+  class OF_EXPORT FrameCapture : public osg::Referenced
+  {
+  public:
+    /** Encodes captured frames. Called from worker threads. */
+    class OF_EXPORT Encoder : public osg::Referenced
+    {
+    public:
+      /** Encode a captured frame. Image rows are ordered from bottom to top. */
+      virtual bool encode(const osg::Image &image, unsigned int frameNum) = 0;
+
+      /** Whether frames must be encoded one at a time in capture order */
+      virtual bool isOrdered() const { return false; }
+
+      /** Called after all frames of a capture have been encoded, e.g. to close files */
+      virtual void finish() {}
+
+    protected:
+      virtual ~Encoder() {}
+    };
+
+    /** Writes each frame to a sequentially numbered image file fname_N.fext.
+        Image types can be anything supported by OSG (png, jpg, bmp, tiff, etc.),
+        or "raw" for unformatted RGBA bytes. */
+    class OF_EXPORT ImageFileEncoder : public Encoder
+    {
+    public:
+      ImageFileEncoder(const std::string &fname, const std::string &fext);
+      virtual bool encode(const osg::Image &image, unsigned int frameNum);
+
+    protected:
+      virtual ~ImageFileEncoder() {}
+
+      std::string _fname, _fext;
+    };
+
+    /** Writes raw RGBA frames, ordered from top to bottom, to the standard input of an
+        external process, e.g. "ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i - out.mp4" */
+    class OF_EXPORT PipeEncoder : public Encoder
+    {
+    public:
+      PipeEncoder(const std::string &command);
+      virtual bool encode(const osg::Image &image, unsigned int frameNum);
+      virtual bool isOrdered() const { return true; }
+
+      /** Close the pipe so the process sees the end of its input. The
+          process is started again if another capture begins. */
+      virtual void finish();
+
+    protected:
+      virtual ~PipeEncoder();
+
+      std::string _command;
+      FILE *_pipe;
+    };
+
+    FrameCapture();
+
+    /** Set the encoder for captured frames. Returns false and does nothing while capturing. */
+    bool setEncoder(Encoder *encoder);
+    Encoder* getEncoder() const;
+
+    /** Set the number of PBOs used for readback, i.e. the number of frames between
+        reading and encoding a frame. 1 reads pixels synchronously. Only applies
+        while not capturing. */
+    void setNumPBOs(unsigned int numPBOs);
+    unsigned int getNumPBOs() const { return _numPBOs; }
+
+    /** Set the number of worker threads that encode frames. Ordered encoders
+        always use one thread. Only applies while not capturing. */
+    void setNumThreads(unsigned int numThreads);
+    unsigned int getNumThreads() const { return _numThreads; }
+
+    /** Set the maximum number of frames waiting to be encoded */
+    void setMaxQueuedFrames(unsigned int maxFrames);
+    unsigned int getMaxQueuedFrames() const { return _maxQueuedFrames; }
+
+    /** Set whether frames are dropped (default) or rendering waits when the
+        maximum number of frames are waiting to be encoded */
+    void setDropFrames(bool drop);
+    bool getDropFrames() const { return _dropFrames; }
+
+    /** Start capturing the given number of frames, or all frames if negative */
+    bool start(int numFrames = -1);
+
+    /** Stop capturing. Frames that have already been read are still encoded, after
+        which the encoder is finished. Can be called from any thread. */
+    void stop();
+    bool isCapturing() const;
+
+    /** Whether capture() still has work to do: capturing, or frames that were
+        captured but not yet queued or finished. Called from the rendering thread. */
+    bool hasPendingFrames() const { return isCapturing() || (_numPending > 0) || _finishPending; }
+
+    /** Wait until all captured frames have been encoded or dropped */
+    void waitForEncoding();
+
+    /** Frame counts: read from the framebuffer, encoded, failed to encode, and
+        dropped because too many frames were waiting to be encoded */
+    unsigned int getNumCaptured() const { return _numCaptured; }
+    unsigned int getNumEncoded() const { return _numEncoded; }
+    unsigned int getNumFailed() const { return _numFailed; }
+    unsigned int getNumDropped() const { return _numDropped; }
+
+    /** Capture the current frame of the given context. Called from the rendering
+        thread, with the context current, before its buffers are swapped. */
+    void capture(osg::GraphicsContext *gc);
+
+    /** Delete PBOs used by the given context, which must be current */
+    void releaseGLObjects(osg::GraphicsContext *gc);
+
+  protected:
+    virtual ~FrameCapture();
+
+    class EncoderThread; // Encodes queued frames
+
+    /** A frame waiting to be encoded. A frame without an image finishes its encoder
+        once all frames before it are encoded. */
+    struct QueuedFrame
+    {
+      osg::ref_ptr<osg::Image> _image;
+      unsigned int _frameNum;
+      osg::ref_ptr<Encoder> _encoder; // Encoder at the time the frame was captured
+    };
+
+    // Encode queued frames until worker threads are stopped
+    void _encodeFrames();
+
+    // Start/stop worker threads
+    void _startThreads(unsigned int numThreads);
+    void _stopThreads();
+
+    // Get an image to copy a frame into, or NULL if the frame should be dropped
+    osg::ref_ptr<osg::Image> _acquireImage(int width, int height);
+
+    // Queue a frame for encoding, or finish the encoder if image is NULL
+    void _queueFrame(osg::Image *image, unsigned int frameNum);
+
+    // Copy a PBO's pixels into an image and queue it for encoding
+    void _readPBO(osg::GLExtensions *ext, unsigned int index);
+
+    // Read all PBOs that hold frames, from oldest to newest
+    void _readPendingPBOs(osg::GLExtensions *ext);
+
+    // Settings and capture state shared with the rendering thread, protected by _captureMutex
+    osg::ref_ptr<Encoder> _encoder;
+    unsigned int _numPBOs, _numThreads;
+    bool _capturing;
+    int _numFramesLeft; // Frames left to capture, negative for unlimited
+    mutable OpenThreads::Mutex _captureMutex;
+
+    // Rendering thread state
+    osg::ref_ptr<Encoder> _captureEncoder; // Encoder of the current capture
+    bool _finishPending; // Whether _captureEncoder must be finished after its frames
+    unsigned int _frameNum; // Number of next captured frame
+    int _width, _height; // Size of captured frames
+    std::vector<GLuint> _pbos; // Ring of PBOs
+    std::vector<unsigned int> _pboFrameNums; // Frame number stored in each PBO
+    std::vector<bool> _pboPending; // Whether each PBO holds a frame that wasn't read yet
+    unsigned int _numPending; // Number of PBOs that hold a frame
+    unsigned int _nextPBO; // Index of next PBO to read pixels into
+
+    // Frames waiting to be encoded, and images that can be reused, protected by _queueMutex
+    unsigned int _maxQueuedFrames;
+    bool _dropFrames;
+    std::deque<QueuedFrame> _queue;
+    std::vector<osg::ref_ptr<osg::Image> > _freeImages;
+    unsigned int _numBusy; // Number of frames being encoded
+    OpenThreads::Mutex _queueMutex;
+    OpenThreads::Condition _queueCond; // Signals changes to queue or free list
+
+    std::vector<EncoderThread*> _threads;
+    bool _stopRequested; // Tells worker threads to exit
+
+    OpenThreads::Atomic _numCaptured, _numEncoded, _numFailed, _numDropped;
+  };
+
+} // !namespace OpenFrames
+
+#endif // !define _OF_FRAMECAPTURE_
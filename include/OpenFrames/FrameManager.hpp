@@ -23,9 +23,15 @@
 
 #include <OpenFrames/Export.h>
 #include <OpenFrames/ReferenceFrame.hpp>
+#include <OpenFrames/Utilities.hpp>
+#include <OpenThreads/Atomic>
 #include <OpenThreads/Mutex>
+#include <osg/Quat>
 #include <osg/Referenced>
+#include <osg/Vec3d>
+#include <osg/Vec4>
 #include <osg/ref_ptr>
+#include <unordered_map>
 
 namespace OpenFrames
 {
@@ -48,11 +54,28 @@ namespace OpenFrames
    * Approach summary: Data mutex D, Next-access mutex N, low-priority mutex L
    *  Low-priority Thread: lock L -> lock N -> lock D -> unlock N -> (...work...) -> unlock D -> unlock L
    *  High-priority Thread: lock N -> lock D -> unlock N -> (...work...) -> unlock D.
+   *
+   * Frame states (position, attitude, visibility, color) can also be staged with the
+   * stage*() functions. If double buffering is enabled, staged states are stored in a
+   * back buffer that writers fill without locking the scene. Rendering threads swap it
+   * with the front buffer and apply its states at the start of each frame, so bursts of
+   * state updates never make rendering wait. Rendering threads also don't take the lock
+   * of a double-buffered scene, so low-priority clients never delay rendering. Instead,
+   * high-priority clients wait for frames being drawn to finish and keep new frames
+   * from being drawn while they hold the lock, so they can still change the scene.
+   * If double buffering is disabled, staged states are applied immediately while
+   * holding the high-priority lock.
+   *
+   * Lock statistics (acquisitions, wait times, and hold times) can optionally be
+   * recorded for each priority, to find out whether lock contention is delaying
+   * rendering or other clients.
    */
   class OF_EXPORT FrameManager : public osg::Referenced
   {
   public:
-	FrameManager(ReferenceFrame *frame = NULL) : _frame(frame) {}
+	FrameManager(ReferenceFrame *frame = NULL)
+	: _frame(frame), _generation(0), _doubleBuffered(false), _statesStaged(0),
+	  _renderExcluded(false), _statsEnabled(false), _holdStart(0) {}
   
   enum Priority
   {
@@ -76,35 +99,160 @@ namespace OpenFrames
 
   inline int lock(Priority priority = HIGH_PRIORITY)
   {
+    osg::Timer_t startTick = _statsEnabled ? osg::Timer::instance()->tick() : 0;
     if(priority == LOW_PRIORITY) _mutexLP.lock();
     _mutexNext.lock();
     int val = _mutexData.lock();
     _mutexNext.unlock();
+    _excludeRendering(priority);
+    if(startTick != 0) _beginHold(priority, startTick);
     return val;
   }
   
   /// Users must specify the same priority as they did for lock/trylock
   inline int unlock(Priority priority = HIGH_PRIORITY)
   {
+    if(_holdStart != 0) _endHold(priority);
+    if(priority == HIGH_PRIORITY) ++_generation; // Scene may have been modified
+    if(_renderExcluded && (priority == HIGH_PRIORITY))
+    {
+      _renderExcluded = false;
+      _mutexRender.writeUnlock();
+    }
     int val = _mutexData.unlock();
     if(priority == LOW_PRIORITY) _mutexLP.unlock();
     return val;
   }
+
+  /// Generation counter that is incremented whenever the scene may have changed,
+  /// i.e. after each high-priority lock and each staged state. Used to determine
+  /// whether the scene has to be redrawn.
+  inline unsigned int getGeneration() const { return _generation; }
   
   inline int trylock(Priority priority = HIGH_PRIORITY)
   {
+    osg::Timer_t startTick = _statsEnabled ? osg::Timer::instance()->tick() : 0;
     if(priority == LOW_PRIORITY) _mutexLP.lock();
     _mutexNext.lock();
     int val = _mutexData.trylock();
     _mutexNext.unlock();
+    if(val != 0)
+    {
+      if(priority == LOW_PRIORITY) _mutexLP.unlock(); // Caller won't unlock on failure
+    }
+    else
+    {
+      _excludeRendering(priority); // Waits for frames being drawn to finish
+      if(startTick != 0) _beginHold(priority, startTick);
+    }
     return val;
   }
+
+  /// Enable/disable recording of lock statistics (disabled by default)
+  void setLockStatsEnabled(bool enable);
+  inline bool getLockStatsEnabled() const { return _statsEnabled; }
+
+  /// Get a copy of the lock statistics for the given priority
+  LockStats getLockStats(Priority priority) const;
+
+  /// Clear lock statistics for all priorities
+  void resetLockStats();
   
+  /// Enable/disable double buffering of staged frame states
+  void setDoubleBuffered(bool doubleBuffered);
+  inline bool isDoubleBuffered() const { return _doubleBuffered; }
+
+  /// Stage a frame's position, attitude, visibility, or color. Staged states
+  /// replace any earlier staged states of the same type for the same frame.
+  /// Do not call these while holding this FrameManager's lock.
+  void stagePosition(ReferenceFrame *frame, const osg::Vec3d &pos);
+  void stageAttitude(ReferenceFrame *frame, const osg::Quat &att);
+  void stageVisibility(ReferenceFrame *frame, bool visible);
+  void stageColor(ReferenceFrame *frame, const osg::Vec4 &color);
+
+  /// Begin drawing the scene. Called by rendering threads at the start of each frame.
+  /// If double buffered, staged states are swapped in and applied, and the scene isn't
+  /// locked. Otherwise the scene is locked with low priority.
+  /// Returns whether the scene was locked, which must be passed to endRender().
+  bool beginRender();
+
+  /// Finish drawing the scene, so that it can be modified again
+  void endRender(bool locked);
+
   protected:
 	virtual ~FrameManager() {}
 
+	// Swap in and apply staged states. Writers only hold the staging mutex while
+	// storing a single state, so the swap never waits long, and states staged
+	// before the swap are always applied. Called while excluding other renderers.
+	void _applyStagedStates();
+
+	// Keep double-buffered scenes from being drawn while a high-priority client
+	// holds the lock. Called while holding the data mutex.
+	inline void _excludeRendering(Priority priority)
+	{
+	  if(_doubleBuffered && (priority == HIGH_PRIORITY))
+	  {
+	    _mutexRender.writeLock();
+	    _renderExcluded = true;
+	  }
+	}
+
+	// Staged states of a single frame
+	struct FrameState
+	{
+	  enum StateType
+	  {
+	    POSITION = 1,
+	    ATTITUDE = 2,
+	    VISIBILITY = 4,
+	    COLOR = 8
+	  };
+
+	  FrameState() : _staged(0), _visible(true) {}
+
+	  osg::ref_ptr<ReferenceFrame> _frame; // Keeps frame alive until states are applied
+	  unsigned int _staged; // StateTypes that have been staged
+	  osg::Vec3d _position;
+	  osg::Quat _attitude;
+	  bool _visible;
+	  osg::Vec4 _color;
+	};
+	typedef std::unordered_map<const ReferenceFrame*, FrameState> FrameStateMap;
+
+	// Get staged state for the given frame, or NULL if it should be applied
+	// immediately. Locks either the staging mutex or the high-priority lock,
+	// which must be released by _endStaging().
+	FrameState* _beginStaging(ReferenceFrame *frame);
+	void _endStaging(FrameState *state);
+
+	// Apply all staged states of a frame
+	static void _applyState(const FrameState &state);
+
+	// Record lock wait time and start/end of lock hold time.
+	// Called while holding the data mutex.
+	void _beginHold(Priority priority, osg::Timer_t startTick);
+	void _endHold(Priority priority);
+
 	osg::ref_ptr<ReferenceFrame> _frame;
 	OpenThreads::Mutex _mutexData, _mutexNext, _mutexLP;
+	OpenThreads::Atomic _generation; // See getGeneration()
+
+	bool _doubleBuffered;
+	FrameStateMap _backStates;  // Filled by writers
+	FrameStateMap _frontStates; // Applied by rendering threads
+	OpenThreads::Mutex _mutexStaging; // Protects back buffer
+	OpenThreads::Atomic _statesStaged; // Whether back buffer has states to apply
+
+	// Read-locked by threads drawing a double-buffered scene, and write-locked to
+	// apply staged states or by high-priority clients
+	ReadWriteMutex _mutexRender;
+	bool _renderExcluded; // Whether the lock holder has write-locked _mutexRender
+
+	bool _statsEnabled;
+	osg::Timer_t _holdStart; // Time the data mutex was acquired
+	LockStats _lockStats[2]; // One per priority
+	mutable OpenThreads::Mutex _mutexStats; // Protects lock stats
   };
 
 }
@@ -0,0 +1,118 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file FrameTimingStats.hpp
+ * Declaration of FrameTimingStats class.
+ */
+
+#ifndef _OF_FRAMETIMINGSTATS_
+#define _OF_FRAMETIMINGSTATS_
+
+#include <OpenFrames/Export.h>
+#include <OpenThreads/Atomic>
+#include <osg/Referenced>
+#include <string>
+#include <vector>
+
+namespace OpenFrames
+{
+  /**
+   * \class FrameTimingStats
+   *
+   * \brief Stores the time taken by each phase of recent frames.
+   *
+   * Frame timings are stored in a fixed-size ring buffer that holds the most
+   * recent frames. Timings are added by a single thread (the rendering thread),
+   * and can be read by any thread. Each slot has a sequence counter that is odd
+   * while the slot is being written, so readers skip slots that were modified
+   * while being copied. The rendering thread never waits for readers.
+   */
+  class OF_EXPORT FrameTimingStats : public osg::Referenced
+  {
+  public:
+    /** Phases of a frame. Phase times sum to the total frame time. */
+    enum Phase
+    {
+      THROTTLE = 0,    // Sleep to achieve the desired framerate
+      LOCK,            // Wait to lock all scenes
+      EVENT,           // Event traversal
+      UPDATE,          // Update traversal, excluding depth partitioning
+      DEPTH_PARTITION, // Depth partitioning (computing near/far planes)
+      CULL,            // Cull traversal of all cameras
+      DRAW,            // Draw traversal of all cameras, excluding swap
+      SWAP,            // Swap buffers
+      OTHER,           // Remaining time not in any of the above phases
+      TOTAL,           // Total frame time
+      NUM_PHASES
+    };
+
+    /** Phase times for a single frame, in seconds */
+    struct FrameTiming
+    {
+      FrameTiming() : _frameNumber(0) { for(unsigned int i = 0; i < NUM_PHASES; ++i) _times[i] = 0.0; }
+
+      unsigned int _frameNumber;
+      double _times[NUM_PHASES];
+    };
+
+    /** Create stats that store the given maximum number of recent frames */
+    FrameTimingStats(unsigned int capacity = 1024);
+
+    /** Get name of a phase, e.g. for CSV/JSON headers */
+    static const char* getPhaseName(Phase phase);
+
+    /** Add timing of the most recent frame. Only call from one thread. */
+    void addFrame(const FrameTiming &timing);
+
+    /** Discard all stored frames */
+    void reset();
+
+    /** Get the maximum number of stored frames */
+    inline unsigned int getCapacity() const { return _frames.size(); }
+
+    /** Get a copy of stored frames, from oldest to newest */
+    void getFrames(std::vector<FrameTiming> &frames) const;
+
+    /** Compute the given percentiles (0-100) of a phase's time over the stored frames.
+        Returns false if no frames are stored. */
+    bool getPercentiles(Phase phase, double p50Pct, double p95Pct, double p99Pct,
+                        double &p50, double &p95, double &p99) const;
+
+    /** Get the 50th, 95th, and 99th percentiles of a phase's time */
+    inline bool getPercentiles(Phase phase, double &p50, double &p95, double &p99) const
+    { return getPercentiles(phase, 50.0, 95.0, 99.0, p50, p95, p99); }
+
+    /** Get a multi-line summary of percentiles of each phase, in milliseconds */
+    std::string getSummary() const;
+
+    /** Write stored frames to a CSV file (one row per frame, times in seconds) */
+    bool writeCSV(const std::string &filename) const;
+
+    /** Write percentiles and stored frames to a JSON file (times in seconds) */
+    bool writeJSON(const std::string &filename) const;
+
+  protected:
+    virtual ~FrameTimingStats();
+
+    std::vector<FrameTiming> _frames;  // Ring buffer of frame timings
+    OpenThreads::Atomic *_sequences;   // Sequence counter of each slot, odd while writing
+    OpenThreads::Atomic _numAdded;     // Number of frames added so far
+    OpenThreads::Atomic _resetCount;   // Number of frames added at last reset
+  };
+
+} // !namespace OpenFrames
+
+#endif // !define _OF_FRAMETIMINGSTATS_
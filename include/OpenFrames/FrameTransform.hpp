@@ -23,6 +23,7 @@
 
 #include <OpenFrames/Export.h>
 #include <osg/Transform>
+#include <OpenThreads/Atomic>
 
 namespace OpenFrames
 {
@@ -50,11 +51,11 @@ namespace OpenFrames
 
 	// Set whether this frame should follow the viewer's eye point.
 	// This is used, e.g., for a SkyBox.
-	inline void setFollowEye(bool f) { _followEye = f; }
+	inline void setFollowEye(bool f) { _followEye = f; _dirtyTransform(); }
 	inline bool getFollowEye() const { return _followEye; }
 
 	// Set whether this frame applies its transform or not.
-	inline void setDisabled(bool d) { _disabled = d; }
+	inline void setDisabled(bool d) { _disabled = d; _dirtyTransform(); }
 	inline bool isDisabled() const { return _disabled; }
 
 	// Set position wrt parent frame
@@ -78,6 +79,14 @@ namespace OpenFrames
 	void setPivot(const double &px, const double &py, const double &pz);
 	void getPivot(double &px, double &py, double &pz);
 
+	// Generation counter that is incremented whenever this transform changes.
+	// Used to detect when cached transformation matrices must be recomputed.
+	// Can be read from any thread.
+	inline unsigned int getGeneration() const { return _generation; }
+
+	// Generation counter that is incremented whenever any FrameTransform changes
+	static unsigned int getGlobalGeneration();
+
 	// Inherited functions to compute transformation matrix
 	virtual bool computeLocalToWorldMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const;
 	virtual bool computeWorldToLocalMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const;
@@ -85,6 +94,9 @@ namespace OpenFrames
   protected:
 	virtual ~FrameTransform();
 
+	// Increment generation counters and dirty bounds after a change
+	void _dirtyTransform();
+
 	osg::Vec3d _position; // Position relative to parent frame's origin
 	osg::Quat _attitude;  // Attitude relative to parent frame
 	osg::Vec3d _scale;    // Scale in addition to parent frame's scale
@@ -96,6 +108,8 @@ namespace OpenFrames
 	// Allows frame to follow the current eye point. Only effective
 	// if the reference frame is of type RELATIVE_RF.
 	bool _followEye;
+
+	OpenThreads::Atomic _generation; // Incremented on each change, see getGeneration()
   };
 
 } // !namespace OpenFrames
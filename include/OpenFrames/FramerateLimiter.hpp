@@ -22,6 +22,7 @@
 #define _OF_FRAMERATELIMITER_
 
 #include <OpenFrames/Export.h>
+#include <OpenThreads/Mutex>
 #include <osg/Timer>
 
 namespace OpenFrames
@@ -33,6 +34,14 @@ namespace OpenFrames
    *
    * Implements a simple framerate-limiting algorithm that waits the necessary amount of time
    * between frames, thereby achieving the desired framerate for any given workload.
+   *
+   * In SLEEP mode, the remaining frame time is slept, so frame intervals are only as precise
+   * as the OS scheduler. In HYBRID mode, frames are scheduled against absolute deadlines that
+   * don't drift, and the limiter sleeps until shortly before each deadline then yields the
+   * processor until the deadline is reached. This gives much steadier frame intervals at the
+   * cost of some CPU time.
+   *
+   * Statistics of the interval between frames are recorded in both modes.
    */
   class OF_EXPORT FramerateLimiter
   {
@@ -50,16 +59,55 @@ namespace OpenFrames
     // Get the measured framerate for the last frame
     double getFramerate() const { return 1.0 / _currSPF; }
 
+    // How to wait until the next frame
+    enum PacingMode
+    {
+      SLEEP = 0, // Sleep for the remaining frame time (default)
+      HYBRID     // Sleep, then yield until an absolute deadline
+    };
+
+    void setPacingMode(PacingMode mode);
+    PacingMode getPacingMode() const { return _pacingMode; }
+
+    // Set/get the time before each deadline at which HYBRID mode stops sleeping and
+    // starts yielding. Should exceed the OS sleep granularity. Default is 2ms.
+    void setSpinTime(double spinTime) { _spinTime = (spinTime > 0.0) ? spinTime : 0.0; }
+    double getSpinTime() const { return _spinTime; }
+
+    // Get statistics of intervals between frames since the last reset, in seconds.
+    // Jitter is the standard deviation of intervals, and maxError is the largest
+    // difference between an interval and the desired interval.
+    // Returns the number of measured intervals.
+    unsigned int getIntervalStats(double &mean, double &jitter, double &minInterval,
+                                  double &maxInterval, double &maxError) const;
+    void resetIntervalStats();
+
     // Indicates the start of a frame
     void frame();
 
   private:
+    // Wait until the next deadline in HYBRID mode
+    void _waitForDeadline();
+
+    // Add an interval to the interval statistics
+    void _addInterval(double interval);
+
     double _desiredSPF; // Desired seconds/frame (inverse of fps)
     double _currSPF;  // Current measured seconds/frame
 
+    PacingMode _pacingMode;
+    double _spinTime; // Time before deadline to stop sleeping in HYBRID mode
+
     const osg::Timer &_timer; // Timer for framerate control
     osg::Timer_t _startTick, _endTick; // Workload start/end times
     osg::Timer_t _prevStartTick; // Used to measure framerate
+    osg::Timer_t _deadlineTick; // Start of next workload in HYBRID mode
+
+    // Interval statistics
+    unsigned int _numIntervals;
+    double _sumInterval, _sumSqInterval;
+    double _minInterval, _maxInterval, _maxError;
+    mutable OpenThreads::Mutex _statsMutex;
   };
   
 } // !namespace OpenFrames
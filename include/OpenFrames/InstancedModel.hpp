@@ -0,0 +1,162 @@
+/***********************************
+   Copyright 2019 Ravishankar Mathur
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+***********************************/
+
+/** \file InstancedModel.hpp
+ * Declaration of InstancedModel class.
+ */
+
+#ifndef _OF_INSTANCEDMODEL_
+#define _OF_INSTANCEDMODEL_
+
+#include <OpenFrames/Export.h>
+#include <OpenFrames/ReferenceFrame.hpp>
+#include <osg/BoundingBox>
+#include <osg/Geometry>
+#include <osg/Image>
+#include <osg/Matrixd>
+#include <osg/Texture2D>
+#include <osg/Uniform>
+#include <osg/ref_ptr>
+#include <osgUtil/CullVisitor>
+#include <OpenThreads/Mutex>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenFrames
+{
+  /**
+   * \class InstancedModel
+   *
+   * \brief A ReferenceFrame that draws one 3D model at the location of many other frames.
+   *
+   * Each instance of the model is placed using the transform from an instance frame
+   * to this frame. Instance frames are typically plain ReferenceFrames with hidden
+   * axes and labels that share this frame's parent, and are positioned by e.g. a
+   * FollowerGroup. More generally, an instance frame must share an ancestor with this
+   * frame, where ancestors are found through each frame's first parent. Other
+   * instances, and instances with a hidden frame between them and that ancestor,
+   * are not drawn. All instances are drawn using a single instanced draw call per
+   * model drawable.
+   *
+   * Instance transforms are gathered during the update traversal. During each
+   * camera's cull traversal, instances are culled in bulk against the view frustum
+   * and dropped if smaller than a minimum pixel size. The eye-space transforms of the
+   * remaining instances are packed into a floating-point texture that is read by the
+   * vertex shader, and only those instances are drawn using a per-camera copy of the
+   * model's primitive sets. Instances are lit by the first light source using the model's
+   * material, and use texture unit 0 for any model textures.
+   */
+  class OF_EXPORT InstancedModel : public ReferenceFrame
+  {
+  public:
+    InstancedModel( const std::string &name );
+    InstancedModel( const std::string &name, const osg::Vec3 &color );
+    InstancedModel( const std::string &name, const osg::Vec4 &color );
+    InstancedModel( const std::string &name , float r, float g, float b, float a = 1.0 );
+
+    /** Set the model that should be drawn for each instance */
+    bool setModel( const std::string& filename );
+    osg::Node* getModel() const { return _model.get(); }
+
+    /** Draw an instance of the model using the given frame's transform. The frame
+        should not be an ancestor of this frame. */
+    void addInstance( ReferenceFrame* frame );
+
+    /** Stop drawing the instance that uses the given frame's transform */
+    void removeInstance( ReferenceFrame* frame );
+
+    /** Stop drawing all instances */
+    void removeAllInstances();
+
+    inline unsigned int getNumInstances() const { return _instanceFrames.size(); }
+
+    /** Set/get the minimum size in pixels of drawn instances. Smaller instances are
+        not drawn, in addition to OSG's small feature culling. */
+    void setMinPixelSize( double size ) { _minPixelSize = size; }
+    double getMinPixelSize() const { return _minPixelSize; }
+
+    /** Inherited function to compute the bounds of the model instances */
+    virtual const osg::BoundingSphere& getBound() const;
+
+    /// Inherited
+    virtual std::string frameInfo() const { return "InstancedModel"; }
+
+  protected:
+    virtual ~InstancedModel();
+
+    class InstanceUpdateCallback;    // Gathers instance transforms
+    class InstanceCullCallback;      // Culls instances for each camera
+    class InstanceBoundCallback;     // Computes bounds of all instances
+
+    void _init();
+
+    // Gather instance transforms and bounds from instance frames
+    void _updateInstances();
+
+    struct CameraInstances;
+
+    // Cull instances and pack their eye-space transforms for the given camera.
+    // Returns the camera's packed transforms and copy of the model.
+    CameraInstances* _cullInstances( osgUtil::CullVisitor* cv );
+
+    /** Instances of the model, including its instancing shader */
+    osg::ref_ptr<osg::Group> _instanceGroup;
+
+    /** 3D model drawn for each instance */
+    osg::ref_ptr<osg::Node> _model;
+    osg::BoundingSphere _modelBound; // Bounds of a single instance of the model
+
+    /** Model geometries that are drawn with instancing */
+    std::vector<osg::ref_ptr<osg::Geometry> > _instancedGeoms;
+
+    /** Frames whose transforms place each instance */
+    typedef std::vector<osg::ref_ptr<ReferenceFrame> > InstanceFrameList;
+    typedef std::map<const ReferenceFrame*, unsigned int> InstanceIndexMap;
+    InstanceFrameList _instanceFrames;
+    InstanceIndexMap _instanceIndices;
+    OpenThreads::Mutex _instanceMutex; // For adding/removing instances
+
+    /** Instance data computed during the update traversal, one element per instance */
+    std::vector<osg::Matrixd> _instanceMatrices; // Instance to this frame's transform
+    std::vector<osg::BoundingSphere> _instanceBounds; // Instance bounds in this frame
+    osg::BoundingBox _instanceBox; // Bounds of all instances in this frame
+
+    /** Packed instance transforms and model copy used by each camera */
+    struct CameraInstances
+    {
+      CameraInstances() : _numVisible(0) {}
+
+      osg::ref_ptr<osg::StateSet> _stateSet;
+      osg::ref_ptr<osg::Image> _image;
+      osg::ref_ptr<osg::Texture2D> _texture;
+      osg::ref_ptr<osg::Uniform> _dataSize;
+
+      osg::ref_ptr<osg::Node> _source; // Model that was copied
+      osg::ref_ptr<osg::Node> _model;  // Copy of model with its own primitive sets
+      std::vector<osg::ref_ptr<osg::Geometry> > _geoms; // Instanced geometries in copy
+      unsigned int _numVisible; // Number of instances drawn by each geometry in copy
+    };
+    typedef std::map<const osg::Camera*, CameraInstances> CameraInstancesMap;
+    CameraInstancesMap _cameraInstances;
+    OpenThreads::Mutex _cameraMutex; // Cameras may be culled in parallel
+
+    double _minPixelSize;
+  };
+
+} // !namespace OpenFrames
+
+#endif // !define _OF_INSTANCEDMODEL_
@@ -312,6 +312,125 @@ OF_EXPORT void OF_FCN(ofwin_settimescale)(double *tscale);
  */
 OF_EXPORT void OF_FCN(ofwin_gettimescale)(double *tscale);
 
+/*
+ * \brief Set the fixed simulation time step.
+ *
+ * If positive, simulation time advances by this step (times the time scale) at each
+ * frame instead of following the wall clock, so that animations do not depend on
+ * rendering speed. Set to 0 (default) to follow the wall clock.
+ * This applies to the current active WindowProxy.
+ *
+ * \param dt Simulation time step per frame.
+ */
+OF_EXPORT void OF_FCN(ofwin_setfixedtimestep)(double *dt);
+
+/*
+ * \brief Render to an offscreen pixel buffer instead of an on-screen window.
+ *
+ * Offscreen rendering is not throttled to a desired framerate, so frames are rendered
+ * as fast as possible. Use window capture functions to save rendered frames.
+ * Must be called before ofwin_start(), and does not apply to embedded or VR windows.
+ * This applies to the current active WindowProxy.
+ *
+ * \param offscreen True to render offscreen, false to render to a window.
+ */
+OF_EXPORT void OF_FCN(ofwin_setoffscreen)(bool *offscreen);
+
+/*
+ * \brief Stop animating after the given number of frames.
+ *
+ * This applies to the current active WindowProxy.
+ *
+ * \param maxFrames Number of frames to render, or 0 (default) for no limit.
+ */
+OF_EXPORT void OF_FCN(ofwin_setmaxframes)(unsigned int *maxFrames);
+
+/*
+ * \brief Only render frames when something may have changed.
+ *
+ * Frames are rendered when time advances, input events arrive, the scene is modified
+ * while holding a FrameManager lock, trajectories or frame positions/attitudes change,
+ * or the camera is animating. Otherwise an idle window only polls for input events.
+ * Call ofwin_requestredraw after other changes. Disabled by default.
+ * This applies to the current active WindowProxy.
+ *
+ * \param onDemand True to render on demand, false to render continuously.
+ */
+OF_EXPORT void OF_FCN(ofwin_setrenderondemand)(bool *onDemand);
+
+/*
+ * \brief Render the next frame even if nothing has changed.
+ *
+ * This applies to the current active WindowProxy.
+ */
+OF_EXPORT void OF_FCN(ofwin_requestredraw)();
+
+/*
+ * \brief Set how rendering work is distributed across threads.
+ *
+ * Multithreaded models overlap cull and draw of consecutive frames, or cull each
+ * camera in parallel. Embedded and VR windows always render single-threaded.
+ * This applies to the current active WindowProxy.
+ *
+ * \param model 0 = single threaded (default), 1 = cull/draw thread per context,
+ *              2 = draw thread per context, 3 = cull thread per camera and draw
+ *              thread per context. Sets intVal to 1 if the model is invalid.
+ */
+OF_EXPORT void OF_FCN(ofwin_setthreadingmodel)(int *model);
+
+/*
+ * \brief Set whether depth partitioning reuses the previous frame's results.
+ *
+ * Incremental partitioning caches the bounds of each frame's subgraph, only traversing
+ * subgraphs whose structure changed, and keeps the previous depth segments while they
+ * fit the scene. Call ofwin_requestredraw after changes that aren't detected, e.g.
+ * replacing an object's model. This applies to the current active WindowProxy.
+ *
+ * \param row         Row in the grid to set.
+ * \param col         Column in the grid to set.
+ * \param incremental True to enable incremental partitioning, false otherwise.
+ */
+OF_EXPORT void OF_FCN(ofwin_setdepthpartitionincremental)(unsigned int *row, unsigned int *col, bool *incremental);
+
+/*
+ * \brief Set the number of threads used to traverse the scene for depth partitioning.
+ *
+ * Independent parts of the scene, e.g. separate planets, are traversed in parallel.
+ * This applies to the current active WindowProxy.
+ *
+ * \param row        Row in the grid to set.
+ * \param col        Column in the grid to set.
+ * \param numThreads Number of threads, including the rendering thread. Defaults to 1.
+ */
+OF_EXPORT void OF_FCN(ofwin_setdepthpartitionthreads)(unsigned int *row, unsigned int *col, unsigned int *numThreads);
+
+/*
+ * \brief Set whether depth partitioning uses a flattened array of scene bounds.
+ *
+ * The array stores the world-space bounds of scene objects, so that the scene is only
+ * traversed when its structure changes. Call ofwin_requestredraw after changes that
+ * don't move a frame or add/remove objects. This applies to the current active WindowProxy.
+ *
+ * \param row Row in the grid to set.
+ * \param col Column in the grid to set.
+ * \param use True to use the bounds array, false to traverse the scene every frame.
+ */
+OF_EXPORT void OF_FCN(ofwin_setdepthpartitionboundsarray)(unsigned int *row, unsigned int *col, bool *use);
+
+/*
+ * \brief Set how scenes with large depth ranges are rendered.
+ *
+ * Depth partitioning (mode 0, the default) renders the scene in multiple depth segments.
+ * Reversed-Z (mode 1) renders the scene in one pass with a floating-point depth buffer,
+ * and falls back to depth partitioning if the graphics card doesn't support it or in VR.
+ * This applies to the current active WindowProxy.
+ *
+ * \param row  Row in the grid to set.
+ * \param col  Column in the grid to set.
+ * \param mode Depth mode: 0 for depth partitioning, 1 for reversed-Z.
+ */
+OF_EXPORT void OF_FCN(ofwin_setdepthmode)(unsigned int *row, unsigned int *col, int *mode);
+
 // Default lighting control.
 // This can be overridden by enabling light from at least one ReferenceFrame.
 
@@ -577,6 +696,39 @@ OF_EXPORT void OF_FCN(ofwin_mousemotion)(float *x, float *y);
  */
 OF_EXPORT void OF_FCN(ofwin_setdesiredframerate)(double *fps);
 
+/*
+ * \brief Set how the window waits between frames to achieve the desired framerate.
+ *
+ * Mode 0 sleeps for the remaining frame time (default), so frame intervals are only as
+ * precise as the OS scheduler. Mode 1 schedules frames at fixed deadlines, sleeping until
+ * shortly before each deadline then yielding the processor until it is reached.
+ * This applies to the current active WindowProxy.
+ *
+ * \param mode     Pacing mode (0 = sleep, 1 = hybrid sleep/yield).
+ * \param spinTime Time before each deadline at which mode 1 stops sleeping (seconds).
+ */
+OF_EXPORT void OF_FCN(ofwin_setframepacing)(int *mode, double *spinTime);
+
+/*
+ * \brief Get statistics of intervals between frames since they were last reset.
+ *
+ * This applies to the current active WindowProxy.
+ *
+ * \param numIntervals Number of measured frame intervals.
+ * \param mean         Mean frame interval (seconds).
+ * \param jitter       Standard deviation of frame intervals (seconds).
+ * \param maxError     Largest difference from the desired frame interval (seconds).
+ */
+OF_EXPORT void OF_FCN(ofwin_getframeintervals)(unsigned int *numIntervals, double *mean,
+                                               double *jitter, double *maxError);
+
+/*
+ * \brief Reset statistics of intervals between frames.
+ *
+ * This applies to the current active WindowProxy.
+ */
+OF_EXPORT void OF_FCN(ofwin_resetframeintervals)();
+
 // Control views in any given grid position.
 
 /*
@@ -663,6 +815,126 @@ OF_EXPORT void OF_FCN(ofwin_setwindowcapturefile)(OF_CHARARG(fname),
  */
 OF_EXPORT void OF_FCN(ofwin_setwindowcapturekey)(int *key);
 
+/*
+ * \brief Enable or disable collection of per-frame timing statistics.
+ *
+ * Statistics are kept for the most recent 1024 frames. Collection is disabled by default.
+ * This applies to the currently active WindowProxy.
+ *
+ * \param enable True to collect frame timing statistics, false otherwise.
+ */
+OF_EXPORT void OF_FCN(ofwin_setframetimingenabled)(bool *enable);
+
+/*
+ * \brief Show or hide frame timing statistics on the HUD of the specified grid position.
+ *
+ * This applies to the currently active WindowProxy.
+ *
+ * \param row  Row in the grid to set.
+ * \param col  Column in the grid to set.
+ * \param show True to show frame timing statistics, false to hide them.
+ */
+OF_EXPORT void OF_FCN(ofwin_showframetiming)(unsigned int *row, unsigned int *col, bool *show);
+
+/*
+ * \brief Get percentiles of the time taken by a phase of recent frames.
+ *
+ * Phases are 0 = throttle, 1 = scene lock, 2 = event, 3 = update, 4 = depth partition,
+ * 5 = cull, 6 = draw, 7 = swap, 8 = other, 9 = total frame time.
+ * All times are in seconds. Returns an error if no frames have been timed.
+ * This applies to the currently active WindowProxy.
+ *
+ * \param phase Phase of frame.
+ * \param p50   50th percentile (median) time.
+ * \param p95   95th percentile time.
+ * \param p99   99th percentile time.
+ */
+OF_EXPORT void OF_FCN(ofwin_getframetiming)(int *phase, double *p50, double *p95, double *p99);
+
+/*
+ * \brief Write timing statistics of recent frames to a file.
+ *
+ * The file is written in JSON format if its name ends with .json, and CSV format otherwise.
+ * This applies to the currently active WindowProxy.
+ *
+ * \param fname File name.
+ */
+OF_EXPORT void OF_FCN(ofwin_writeframetiming)(OF_CHARARG(fname));
+
+/*
+ * \brief Capture rendered frames to sequentially numbered image files.
+ *
+ * Files are named fname_N.fext, where N is the frame number. The extension determines
+ * the image type, or use "raw" for unformatted RGBA bytes. Frames are read back
+ * asynchronously and written by background threads, so capturing does not slow down
+ * rendering. Sets intVal to 1 if currently capturing. This applies to the currently active WindowProxy.
+ *
+ * \param fname File name (without extension).
+ * \param fext  File extension (determines image type).
+ */
+#if defined(IFORT_CALLS)
+OF_EXPORT void OF_FCN(ofwin_setcapturefile)(const char *fname,
+                                            const char *fext,
+                                            unsigned int fnamelen,
+                                            unsigned int fextlen);
+#else
+OF_EXPORT void OF_FCN(ofwin_setcapturefile)(OF_CHARARG(fname),
+                                            OF_CHARARG(fext));
+#endif
+
+/*
+ * \brief Capture rendered frames by writing them to the standard input of an external process.
+ *
+ * Frames are written as raw RGBA bytes ordered from top to bottom, e.g. for
+ * "ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r 30 -i - out.mp4". The process is
+ * started by the first captured frame, and its input is closed once capturing stops
+ * and all frames are written. Sets intVal to 1 if currently capturing.
+ * This applies to the currently active WindowProxy.
+ *
+ * \param command Command that starts the process.
+ */
+OF_EXPORT void OF_FCN(ofwin_setcapturepipe)(OF_CHARARG(command));
+
+/*
+ * \brief Start capturing rendered frames.
+ *
+ * Call ofwin_setcapturefile or ofwin_setcapturepipe first. Returns an error if no
+ * capture destination was set. This applies to the currently active WindowProxy.
+ *
+ * \param numFrames Number of frames to capture, or negative to capture until stopped.
+ */
+OF_EXPORT void OF_FCN(ofwin_startcapture)(int *numFrames);
+
+/*
+ * \brief Stop capturing rendered frames. Frames already captured are still written.
+ *
+ * This applies to the currently active WindowProxy.
+ */
+OF_EXPORT void OF_FCN(ofwin_stopcapture)();
+
+/*
+ * \brief Set whether frames are dropped (default) or rendering waits when too many
+ * captured frames are waiting to be written.
+ *
+ * Waiting is useful when rendering offscreen, where every frame should be captured.
+ * This applies to the currently active WindowProxy.
+ *
+ * \param drop True to drop frames, false to wait.
+ */
+OF_EXPORT void OF_FCN(ofwin_setcapturedropframes)(bool *drop);
+
+/*
+ * \brief Get the number of frames that were captured, written, and dropped.
+ *
+ * This applies to the currently active WindowProxy.
+ *
+ * \param numCaptured Number of frames read from the window.
+ * \param numEncoded  Number of frames written.
+ * \param numDropped  Number of frames dropped because too many were waiting to be written.
+ */
+OF_EXPORT void OF_FCN(ofwin_getcapturestats)(unsigned int *numCaptured, unsigned int *numEncoded,
+                                             unsigned int *numDropped);
+
 /******************************************************************
 	FrameManger Functions
 ******************************************************************/
@@ -707,6 +979,119 @@ OF_EXPORT void OF_FCN(offm_lock)();
  */
 OF_EXPORT void OF_FCN(offm_unlock)();
 
+/*
+ * \brief Enable or disable double buffering of staged frame states.
+ *
+ * If enabled, states staged with the offm_stage* functions are applied by rendering
+ * threads at the start of their next frame, so staging never waits for rendering.
+ * Rendering threads also don't take the lock of a double-buffered FrameManager, but
+ * offm_lock() still waits for frames being drawn and keeps new frames from being drawn
+ * until offm_unlock(), so the scene can be modified as usual. If disabled (default),
+ * staged states are applied immediately.
+ * This applies to the current active FrameManager.
+ *
+ * \param enable True to enable double buffering, false otherwise.
+ */
+OF_EXPORT void OF_FCN(offm_setdoublebuffered)(bool *enable);
+
+/*
+ * \brief Stage the position of the current frame.
+ *
+ * Do not call this while the current FrameManager is locked with offm_lock().
+ * This applies to the current active FrameManager and ReferenceFrame.
+ *
+ * \param x X component of the position.
+ * \param y Y component of the position.
+ * \param z Z component of the position.
+ */
+OF_EXPORT void OF_FCN(offm_stageposition)(double *x, double *y, double *z);
+
+/*
+ * \brief Stage the attitude of the current frame.
+ *
+ * Do not call this while the current FrameManager is locked with offm_lock().
+ * This applies to the current active FrameManager and ReferenceFrame.
+ *
+ * \param rx    X component of the rotation quaternion.
+ * \param ry    Y component of the rotation quaternion.
+ * \param rz    Z component of the rotation quaternion.
+ * \param angle Angle component of the rotation quaternion.
+ */
+OF_EXPORT void OF_FCN(offm_stageattitude)(double *rx, double *ry, double *rz, double *angle);
+
+/*
+ * \brief Stage the visibility of the current frame.
+ *
+ * Do not call this while the current FrameManager is locked with offm_lock().
+ * This applies to the current active FrameManager and ReferenceFrame.
+ *
+ * \param visible True to show the frame, false to hide it.
+ */
+OF_EXPORT void OF_FCN(offm_stagevisibility)(bool *visible);
+
+/*
+ * \brief Stage the color of the current frame.
+ *
+ * Do not call this while the current FrameManager is locked with offm_lock().
+ * This applies to the current active FrameManager and ReferenceFrame.
+ *
+ * \param r Red component of the color.
+ * \param g Green component of the color.
+ * \param b Blue component of the color.
+ * \param a Alpha component of the color.
+ */
+OF_EXPORT void OF_FCN(offm_stagecolor)(float *r, float *g, float *b, float *a);
+
+/*
+ * \brief Enable or disable recording of lock statistics for the current FrameManager.
+ *
+ * Statistics are recorded separately for low-priority (rendering) and high-priority
+ * (user) lock acquisitions. Recording is disabled by default.
+ * This applies to the current active FrameManager.
+ *
+ * \param enable True to record lock statistics, false otherwise.
+ */
+OF_EXPORT void OF_FCN(offm_setlockstatsenabled)(bool *enable);
+
+/*
+ * \brief Get lock statistics of the current FrameManager.
+ *
+ * Wait time is measured from a lock request until the lock is acquired, and hold
+ * time from acquisition until release. All times are in seconds.
+ * This applies to the current active FrameManager.
+ *
+ * \param priority         0 for low-priority (rendering) locks, 1 for high-priority (user) locks.
+ * \param numAcquisitions  Number of times the lock was acquired.
+ * \param totalWait        Total time spent waiting for the lock.
+ * \param maxWait          Longest time spent waiting for the lock.
+ * \param totalHold        Total time the lock was held.
+ * \param maxHold          Longest time the lock was held.
+ */
+OF_EXPORT void OF_FCN(offm_getlockstats)(int *priority, unsigned int *numAcquisitions,
+                                         double *totalWait, double *maxWait,
+                                         double *totalHold, double *maxHold);
+
+/*
+ * \brief Get lock wait and hold time histograms of the current FrameManager.
+ *
+ * Each histogram has 32 bins. Bin 0 counts times under 1 microsecond, bin i>0
+ * counts times in [2^(i-1), 2^i) microseconds, and the last bin also counts
+ * all longer times.
+ * This applies to the current active FrameManager.
+ *
+ * \param priority  0 for low-priority (rendering) locks, 1 for high-priority (user) locks.
+ * \param waitHist  Array of 32 elements that receives wait time counts.
+ * \param holdHist  Array of 32 elements that receives hold time counts.
+ */
+OF_EXPORT void OF_FCN(offm_getlockhistograms)(int *priority, unsigned int waitHist[], unsigned int holdHist[]);
+
+/*
+ * \brief Clear lock statistics of the current FrameManager.
+ *
+ * This applies to the current active FrameManager.
+ */
+OF_EXPORT void OF_FCN(offm_resetlockstats)();
+
 /******************************************************************
 	ReferenceFrame Functions
 ******************************************************************/
@@ -996,7 +1381,7 @@ OF_EXPORT void OF_FCN(offrame_followtrajectory)(OF_CHARARG(name));
  * This applies to the current active ReferenceFrame.
  *
  * \param data Set whether to follow position and/or velocity (see OpenFrames::TrajectoryFollower::FollowData).
- * \param mode Set the follow mode to loop repeatedly or to limit to the times added to the trajectory (see OpenFrames::TrajectoryFollower::FollowMode).
+ * \param mode Set the follow mode to loop repeatedly, limit to the times added to the trajectory, or extrapolate past the last time (see OpenFrames::TrajectoryFollower::FollowMode).
  */
 OF_EXPORT void OF_FCN(offrame_followtype)(int *data, int *mode);
 
@@ -1654,6 +2039,56 @@ OF_EXPORT void OF_FCN(oftraj_informartists)();
  */
 OF_EXPORT void OF_FCN(oftraj_autoinformartists)(bool *autoinform);
 
+/*
+ * \brief Enable or disable recording of data lock statistics for the current Trajectory.
+ *
+ * Statistics are recorded separately for readers (e.g. artists) and writers
+ * (e.g. adding data). Recording is disabled by default.
+ * This applies to the current active Trajectory.
+ *
+ * \param enable True to record lock statistics, false otherwise.
+ */
+OF_EXPORT void OF_FCN(oftraj_setlockstatsenabled)(bool *enable);
+
+/*
+ * \brief Get data lock statistics of the current Trajectory.
+ *
+ * Wait time is measured from a lock request until the lock is acquired, and hold
+ * time from acquisition until release. Reader hold time is measured from when the
+ * first reader acquires the lock until the last reader releases it. All times are
+ * in seconds.
+ * This applies to the current active Trajectory.
+ *
+ * \param lockType         0 for read locks, 1 for write locks.
+ * \param numAcquisitions  Number of times the lock was acquired.
+ * \param totalWait        Total time spent waiting for the lock.
+ * \param maxWait          Longest time spent waiting for the lock.
+ * \param totalHold        Total time the lock was held.
+ * \param maxHold          Longest time the lock was held.
+ */
+OF_EXPORT void OF_FCN(oftraj_getlockstats)(int *lockType, unsigned int *numAcquisitions,
+                                           double *totalWait, double *maxWait,
+                                           double *totalHold, double *maxHold);
+
+/*
+ * \brief Get data lock wait and hold time histograms of the current Trajectory.
+ *
+ * See offm_getlockhistograms() for a description of the histogram bins.
+ * This applies to the current active Trajectory.
+ *
+ * \param lockType  0 for read locks, 1 for write locks.
+ * \param waitHist  Array of 32 elements that receives wait time counts.
+ * \param holdHist  Array of 32 elements that receives hold time counts.
+ */
+OF_EXPORT void OF_FCN(oftraj_getlockhistograms)(int *lockType, unsigned int waitHist[], unsigned int holdHist[]);
+
+/*
+ * \brief Clear data lock statistics of the current Trajectory.
+ *
+ * This applies to the current active Trajectory.
+ */
+OF_EXPORT void OF_FCN(oftraj_resetlockstats)();
+
 /******************************************************************
 	TrajectoryArtist Functions
 A TrajectoryArtist graphically interprets the data contained in a
@@ -1768,6 +2203,21 @@ OF_EXPORT void OF_FCN(ofcurveartist_setwidth)(float *width);
 */
 OF_EXPORT void OF_FCN(ofcurveartist_setpattern)(int *factor, unsigned short *pattern);
 
+/*
+* \brief Set how the current curve artist encodes vertex positions.
+*
+* This applies to the current active CurveArtist.
+*
+* With chunked relative-to-center encoding, points are grouped into chunks and
+* stored as float offsets from each chunk's center, which uses half the vertex
+* memory of the default high/low float encoding.
+*
+* \param encoding    0 for high/low floats (default), 1 for chunked relative-to-center.
+* \param chunkSize   Maximum number of points per chunk.
+* \param chunkRadius Maximum distance between a point and its chunk's center, 0 for no limit.
+*/
+OF_EXPORT void OF_FCN(ofcurveartist_setvertexencoding)(int *encoding, unsigned int *chunkSize, double *chunkRadius);
+
 /*****************************************************************
 	SegmentArtist Functions
 A SegmentArtist is a type of TrajectoryArtist that allows arbitrary
@@ -34,6 +34,8 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 /** \namespace OpenFrames
  * This namespace contains all OpenFrames code / functionality.
@@ -321,7 +323,7 @@ class Trajectory;
      * 
      * \param str String to set as the axis label.
      */
-    inline void setXLabel(const std::string &str) { _xLabel->setText(str); }
+    void setXLabel(const std::string &str);
 
     /*
      * Set the text displayed for the y-axis label.
@@ -330,7 +332,7 @@ class Trajectory;
      *
      * \param str String to set as the axis label.
      */
-    inline void setYLabel(const std::string &str) { _yLabel->setText(str); }
+    void setYLabel(const std::string &str);
 
     /*
      * Set the text displayed for the z-axis label.
@@ -339,7 +341,7 @@ class Trajectory;
      *
      * \param str String to set as the axis label.
      */
-    inline void setZLabel(const std::string &str) { _zLabel->setText(str); }
+    void setZLabel(const std::string &str);
 
     /**
      * Set the font used for labels
@@ -387,7 +389,7 @@ class Trajectory;
      *
      * \return Integer character size (maximum size for axes labels)
      */
-    unsigned int getLabelSize() const { return _nameLabel->getCharacterHeight(); }
+    unsigned int getLabelSize() const { return _labelSize; }
     
     /*
      * \brief Add a ReferenceFrame as a child to this one.
@@ -400,6 +402,18 @@ class Trajectory;
      */
     bool addChild(ReferenceFrame* frame);
 
+    /*
+     * \brief Add multiple ReferenceFrames as children to this one.
+     *
+     * This is equivalent to calling addChild() for each frame, but checks for
+     * loops in the tree structure more efficiently when adding many children.
+     *
+     * \param frames Children to add.
+     *
+     * \return Number of frames that are children of this frame after the call.
+     */
+    unsigned int addChildren(const std::vector<ReferenceFrame*> &frames);
+
     /*
      * \brief Remove a ReferenceFrame from the children of this one.
      *
@@ -570,8 +584,27 @@ class Trajectory;
     mutable osg::ref_ptr<osgText::Text> _yLabel; ///< Y-Axes label
     mutable osg::ref_ptr<osgText::Text> _zLabel; ///< Z-Axes label
     mutable osg::ref_ptr<osgText::Text> _nameLabel; ///< Name of reference frame that is displayed
-	osg::ref_ptr<osg::Geode> _axes; ///< x,y,z axes together
-    osg::ref_ptr<osg::Geode> _labels; ///< axes and name labels
+	mutable osg::ref_ptr<osg::Geode> _axes; ///< x,y,z axes together
+    mutable osg::ref_ptr<osg::Geode> _labels; ///< axes and name labels
+
+    // Axes and labels are only created when they are first used, so their
+    // properties are stored here and applied when they are created
+    struct AxisParams
+    {
+      osg::Vec3d _base;   ///< Position of axis vector base
+      double _length;     ///< Total length of axis vector
+      double _headRatio;  ///< Length of vector head relative to total length
+      double _bodyRadius; ///< Radius of vector body
+      double _headRadius; ///< Radius of vector head
+    };
+    mutable AxisParams _axisParams[3]; ///< x, y, z axis vector geometry
+    osg::Vec4 _color;               ///< Color of axes and labels
+    unsigned int _axesShown;        ///< AxesType of shown axes
+    unsigned int _axesLabelsShown;  ///< AxesType of shown axes labels
+    bool _nameLabelShown;           ///< Whether name label is shown
+    std::string _axesLabelText[3];  ///< x, y, z axes label text
+    std::string _labelFont;         ///< Font name or path used by labels
+    unsigned int _labelSize;        ///< Font resolution used by labels
 
 	mutable osg::BoundingSphere _bound; ///< Frame's bounding sphere
 
@@ -579,12 +612,47 @@ class Trajectory;
     osg::ref_ptr<osgShadow::ShadowedScene> _shadowedSceneRoot;
 
   private:
+    typedef std::unordered_set<const ReferenceFrame*> FrameSet;
+    typedef std::unordered_map<const ReferenceFrame*, int> FrameIndexMap;
+    typedef std::unordered_map<const FrameTracker*, int> TrackerIndexMap;
+
+    class DecorationCallback; // Creates axes and labels on first use
+
     void _init( const std::string &name, const osg::Vec4& c );
-    void _resetTextGlyphs();
+    void _resetTextGlyphs() const;
+
+    // Create or remove the axes and labels geodes based on what is shown
+    void _updateDecorations();
+
+    // Create axes vectors and label text, and apply their stored properties
+    void _createAxes() const;
+    void _createLabels() const;
+
+    // Apply stored properties to axes and labels that have been created
+    void _moveAxis(unsigned int axis, const osg::Vec3d &base, double len, double headRatio, double bodyRadius, double headRadius) const;
+    void _applyAxis(unsigned int axis) const;
+    void _applyLabelVisibility() const;
+    void _applyLabelPositions() const;
+    void _applyLabelFont() const;
+    void _applyLabelSize() const;
+
+    osg::ref_ptr<osg::Callback> _decorationCallback;
+
+    // Add a child, given the set of this frame's ancestors (including itself)
+    // which is used to prevent loops in the tree structure
+    bool _addChild( ReferenceFrame* child, const FrameSet &ancestors );
+
+    // Get this frame and all of its ancestors
+    void _getAncestors( FrameSet &ancestors ) const;
 
 	ParentList _parents;  ///< All direct parents of this frame
 	ChildList _children;  ///< All direct children of this frame
 	TrackerList _trackers; ///< All trackers of this frame
+
+    // Index of each parent, child, and tracker in the above lists
+    FrameIndexMap _parentIndices;
+    FrameIndexMap _childIndices;
+    TrackerIndexMap _trackerIndices;
   };
 
 }  // !namespace OpenFrames
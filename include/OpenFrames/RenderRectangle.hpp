@@ -29,9 +29,12 @@
 #include <OpenFrames/View.hpp>
 #include <OpenFrames/VRUtils.hpp>
 #include <osg/Camera>
+#include <osg/Geode>
 #include <osg/Referenced>
 #include <osg/ref_ptr>
+#include <osgText/Text>
 #include <osgViewer/View>
+#include <string>
 #include <vector>
 
 namespace OpenFrames
@@ -95,6 +98,26 @@ namespace OpenFrames
     
     /** Enable/disable the automatic depth partitioner */
     void setDepthPartitioningEnabled(bool enable) {}
+
+    /** Set how scenes with large depth ranges are rendered: in multiple depth
+        segments (default), or in one pass with a reversed-z depth buffer.
+        See DepthPartitionCallback::setDepthMode() for details. */
+    void setDepthMode(DepthPartitionCallback::DepthMode mode)
+    { _depthPartitioner->getCallback()->setDepthMode(mode); }
+    DepthPartitionCallback::DepthMode getDepthMode() const
+    { return _depthPartitioner->getCallback()->getDepthMode(); }
+
+    /** Get the automatic depth partitioner */
+    DepthPartitioner* getDepthPartitioner() const { return _depthPartitioner.get(); }
+
+    /** Show/hide frame timing statistics on the HUD. The WindowProxy that
+        contains this RenderRectangle updates the statistics text. */
+    void setShowFrameTiming(bool show);
+    bool getShowFrameTiming() const
+    { return (_timingGeode.valid() && (_timingGeode->getNodeMask() != 0x0)); }
+
+    /** Set the frame timing statistics text */
+    void setFrameTimingText(const std::string &text);
     
     /** Add/remove a view to the view list that can be iterated through */
     void addView(View *view);    // Adds view to the end of the view list
@@ -153,6 +176,8 @@ namespace OpenFrames
     bool _useVR;
     
     osg::ref_ptr<osg::Geode> _borderGeode; // The border rectangle
+    osg::ref_ptr<osg::Geode> _timingGeode; // Frame timing text, created on first use
+    osg::ref_ptr<osgText::Text> _timingText;
     osg::ref_ptr<SkySphere> _skySphere; // The background sky
     
     // Manager for access to the ReferenceFrame scene
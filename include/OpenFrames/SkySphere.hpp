@@ -24,7 +24,7 @@
 #include <OpenFrames/Export.h>
 #include <OpenFrames/Sphere.hpp>
 
-#include <array>
+#include <vector>
 
 namespace OpenFrames
 {
@@ -37,6 +37,15 @@ namespace OpenFrames
    * and/or stars from a star catalog. Textures are widely
    * available online. Star Catalogs must be text files with the
    * following format: (TBD).
+   *
+   * Stars are grouped into a hierarchy of tiles: a quadtree on each face of
+   * a cube superscribed on the star unit sphere. Stars are sorted by
+   * magnitude and placed in the coarsest tile along their quadtree path
+   * that has room for them, so each tile holds the brightest stars in its
+   * region that its ancestors don't. Finer tiles, and therefore fainter
+   * stars, are only drawn when their parent tile is large on screen, so
+   * narrow fields of view can show large catalogs without drawing the
+   * whole sky.
    */
   class OF_EXPORT SkySphere : public OpenFrames::Sphere
   {
@@ -84,44 +93,104 @@ namespace OpenFrames
     bool setStarData(const std::string &catalogName, float minMag, float maxMag, unsigned int maxNumStars,
                      float minPixSize, float maxPixSize, float minDimRatio);
 
+    ///
+    /// Set whether processed stars are cached in a binary file, which is
+    /// loaded instead of the star catalog if the catalog and star parameters
+    /// have not changed. Enabled by default.
+    void setUseStarCache(bool useCache) { _useStarCache = useCache; }
+    bool getUseStarCache() const { return _useStarCache; }
+
+    ///
+    /// Set the directory that contains star cache files. By default (empty
+    /// string) the cache is stored in a per-user cache directory, e.g.
+    /// $XDG_CACHE_HOME/OpenFrames or %LOCALAPPDATA%\OpenFrames. If the cache
+    /// can't be written then stars are loaded from the catalog each time.
+    void setStarCacheDirectory(const std::string &dir) { _starCacheDirectory = dir; }
+    const std::string& getStarCacheDirectory() const { return _starCacheDirectory; }
+
     ///
     /// Convert a Star to a XYZ position, RGB color, and size (in color[3])
     static void StarToPoint(const Star &star, osg::Vec3 &pos, osg::Vec4 &color);
 
-    // Get the Geometry bin to which a star should be assigned
-    static unsigned int getStarBin(const osg::Vec3 &p);
+    ///
+    /// Set the maximum depth of the star tile quadtrees (0 = one tile per
+    /// cube face), and the maximum number of stars in each tile above that
+    /// depth. Applies the next time star data is set.
+    void setStarTileLimits(unsigned int maxLevel, unsigned int maxStarsPerTile);
+    unsigned int getMaxStarTileLevel() const { return _maxStarTileLevel; }
+    unsigned int getMaxStarsPerTile() const { return _maxStarsPerTile; }
+
+    ///
+    /// Set the on-screen diameter (pixels) above which a star tile's child
+    /// tiles are also drawn. Smaller values draw fainter stars at wider
+    /// fields of view.
+    void setStarTileRefinePixels(float pixels) { _starTileRefinePixels = pixels; }
+    float getStarTileRefinePixels() const { return _starTileRefinePixels; }
+
+    // Get the cube face (0-5) containing a star, and its coordinates [0-1]
+    // on that face
+    static void getStarFaceCoords(const osg::Vec3 &p, unsigned int &face, float &s, float &t);
 
   protected:
     virtual ~SkySphere(); // Must be allocated on heap using 'new'
 
     bool processStars(); // Load and set up all star data
 
+    // Statistics of processed stars
+    struct StarStats
+    {
+      unsigned int numStars;
+      float minMag, maxMag; // Smallest/largest magnitudes
+      float minSize, maxSize; // Smallest/largest pixel sizes
+    };
+
+    // Read stars from the star catalog text file
+    bool readStarCatalog(const std::string &fullFile, StarStats &stats);
+
+    // Get the star cache file for a star catalog, or empty string if the cache is not used
+    std::string getStarCacheFile(const std::string &fullFile) const;
+
+    // Read/write processed stars from/to a star cache file
+    bool readStarCache(const std::string &cacheFile, const std::string &fullFile, StarStats &stats);
+    bool writeStarCache(const std::string &cacheFile, const std::string &fullFile, const StarStats &stats) const;
+
     // Clear all stars
     void clearStars();
 
+    // Get a star tile's index, creating the tile and its ancestors if needed
+    unsigned int getOrCreateStarTile(unsigned int face, unsigned int level, unsigned int s, unsigned int t);
+
+    // Add a star to the coarsest tile on its quadtree path that has room for it
+    void addStarToTiles(const osg::Vec3 &pos, const osg::Vec4 &color);
+
     std::string _starCatalogFile; // File containing star catalog
     float _minMag, _maxMag; // Range of drawn star magnitudes
     unsigned int _maxNumStars; // Maximum number of drawn stars
     float _minPixSize, _maxPixSize; // Limits on final star pixel size
     float _minDimRatio; // Minimum dimming ratio for any star
+    bool _useStarCache; // Whether processed stars are cached
+    std::string _starCacheDirectory; // Directory containing star cache files
 
-    // Stars are grouped by position into star bins. Bins are arranged
-    // in a cube superscribed on the star unit sphere. Each cube face
-    // contains bins arranged in a square grid.
-    // Note that each bin does not have an equal number of stars, since
-    // the sphere->cube mapping is not evenly spaced and stars are not
-    // uniformly distributed in the sky
-
-    // Number of bin rows (and columns) per cube face
-    static const unsigned int _starBinSpacing = 2;
+    // A tile of stars, covering a square region of a cube face
+    struct StarTile
+    {
+      unsigned int _face, _level, _s, _t; // Tile's face, level, and position at its level
+      int _children[4]; // Indices of child tiles, or -1 if they don't exist
+      osg::ref_ptr<osg::Group> _group; // Contains this tile's geode and its child tiles
+      osg::Geometry* _geom; // Draws this tile's stars
+      osg::Vec3Array* _vertices;
+      osg::Vec4Array* _colors;
+      osg::DrawArrays* _drawArrays;
+    };
 
-    // Total number of bins for a 6-sided cube
-    static const unsigned int _starBinCount = _starBinSpacing*_starBinSpacing*6;
+    unsigned int _maxStarTileLevel; // Maximum quadtree depth
+    unsigned int _maxStarsPerTile; // Maximum stars per tile above the maximum depth
+    float _starTileRefinePixels; // Tile size at which child tiles are drawn
 
-    // Star bins containing each set of stars
-    typedef std::array<osg::ref_ptr<osg::Geometry>, _starBinCount> StarBins;
-    StarBins _starBinGeoms;
-    osg::ref_ptr<osg::Geode> _starGeode; // Contains all StarBins
+    std::vector<StarTile> _starTiles; // All tiles, parents before children
+    int _starFaceTiles[6]; // Index of each cube face's top-level tile, or -1
+    osg::ref_ptr<osg::StateSet> _starStateSet; // Shared by all tiles
+    osg::ref_ptr<osg::Group> _starTileRoot; // Contains all top-level tiles
 
   private:
     void _init();
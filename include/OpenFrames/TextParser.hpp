@@ -0,0 +1,100 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+
+/** \file TextParser.hpp
+ * Declaration of TextParser class.
+ */
+
+#ifndef _OF_TEXTPARSER_
+#define _OF_TEXTPARSER_
+
+#include <OpenFrames/Export.h>
+#include <string>
+
+namespace OpenFrames
+{
+  /**
+   * \class TextParser
+   *
+   * \brief Parses line-based text files in parallel.
+   *
+   * The whole file is read into memory with a single read, then split into
+   * chunks on line boundaries. Each chunk is parsed by a ChunkParser in its
+   * own thread. Chunks are numbered in file order, so that parsers can store
+   * per-chunk results and merge them in file order afterwards.
+   *
+   * Static functions are provided to step through lines and parse numbers
+   * without copying text into strings or streams.
+   */
+  class OF_EXPORT TextParser
+  {
+  public:
+    /** Parses the lines of each chunk. parseChunk() is called from multiple threads. */
+    class OF_EXPORT ChunkParser
+    {
+    public:
+      virtual ~ChunkParser() {}
+
+      /** Called before any chunks are parsed, with the number of chunks */
+      virtual void beginChunks(unsigned int numChunks) {}
+
+      /** Parse the text [begin, end), which contains whole lines */
+      virtual void parseChunk(unsigned int chunkNum, const char *begin, const char *end) = 0;
+    };
+
+    TextParser();
+    ~TextParser();
+
+    /** Read a file into memory. Returns false if the file can't be read. */
+    bool readFile(const std::string &fileName);
+
+    /** Get the text that was read */
+    inline const char* begin() const { return _text.data(); }
+    inline const char* end() const { return _text.data() + _text.size(); }
+
+    /** Set the maximum number of threads used to parse chunks. 0 (default)
+        uses one thread per processor. */
+    void setNumThreads(unsigned int numThreads) { _numThreads = numThreads; }
+    unsigned int getNumThreads() const { return _numThreads; }
+
+    /** Set the minimum number of bytes per chunk, so that small files are
+        not split across many threads */
+    void setMinChunkSize(unsigned int size) { _minChunkSize = size; }
+    unsigned int getMinChunkSize() const { return _minChunkSize; }
+
+    /** Split the text [begin, end) into chunks and parse them in parallel.
+        Returns the number of chunks. */
+    unsigned int parseChunks(const char *begin, const char *end, ChunkParser &parser) const;
+
+    /** Get the line that starts at pos, excluding its line ending, and move
+        pos to the start of the next line. Returns false if pos is at end. */
+    static bool nextLine(const char *&pos, const char *end, const char *&lineBegin, const char *&lineEnd);
+
+    /** Parse a whitespace-separated number that starts at or after pos, and move
+        pos past it. Returns false if there is no valid number before end. */
+    static bool parseNumber(const char *&pos, const char *end, double &value);
+    static bool parseNumber(const char *&pos, const char *end, float &value);
+
+  protected:
+    std::string _text; // Contents of file
+    unsigned int _numThreads; // Maximum parsing threads
+    unsigned int _minChunkSize; // Minimum bytes per chunk
+  };
+
+} // !namespace OpenFrames
+
+#endif // !define _OF_TEXTPARSER_
@@ -211,6 +211,10 @@ namespace OpenFrames
   virtual void removeSubscriber(TrajectorySubscriber* subscriber) const;
   virtual void informSubscribers();
   inline void autoInformSubscribers(bool autoinform) { _autoInformSubscribers = autoinform; }
+
+  /** Generation counter that is incremented whenever any Trajectory informs its
+      subscribers of a change */
+  static unsigned int getGlobalGeneration();
   
   enum DataLockType
   {
@@ -223,6 +227,17 @@ namespace OpenFrames
 	virtual void lockData(DataLockType lockType = READ_LOCK) const;   // Block the data from being changed
 	virtual void unlockData(DataLockType lockType = READ_LOCK) const; // Allow the data to be changed
 
+  /** Enable/disable recording of data lock statistics (disabled by default) */
+  inline void setLockStatsEnabled(bool enable) { _readWriteMutex.setStatsEnabled(enable); }
+  inline bool getLockStatsEnabled() const { return _readWriteMutex.getStatsEnabled(); }
+
+  /** Get a copy of the data lock statistics for the given lock type */
+  inline LockStats getLockStats(DataLockType lockType) const
+  { return _readWriteMutex.getStats((lockType == READ_LOCK) ? ReadWriteMutex::READ : ReadWriteMutex::WRITE); }
+
+  /** Clear data lock statistics */
+  inline void resetLockStats() { _readWriteMutex.resetStats(); }
+
   protected:
 	virtual ~Trajectory();
 
@@ -64,11 +64,17 @@ namespace OpenFrames
         implemented by derived classes. */
     virtual void dataAdded(const Trajectory* traj) = 0;
 
+    /** Get the GLSL program for rendering relative to center (RTC). Vertices are
+        float offsets from a chunk center, whose high/low parts are given by the
+        of_ChunkCenterHigh and of_ChunkCenterLow uniforms. */
+    osg::Program* getRTCProgram();
+
   protected:
     virtual ~TrajectoryArtist();
 
     osg::ref_ptr<const Trajectory> _traj; // Trajectory to be drawn
     osg::ref_ptr<osg::Program> _program; // GLSL program
+    osg::ref_ptr<osg::Program> _rtcProgram; // GLSL program for RTC, created when needed
   };
 
 }
@@ -29,6 +29,8 @@
 #include <osg/Quat>
 #include <osg/Vec3d>
 #include <OpenThreads/Mutex>
+#include <map>
+#include <set>
 
 namespace OpenFrames
 {
@@ -48,6 +50,9 @@ namespace OpenFrames
    *  If t not within time of {T}, then wrap t to time of {T} (based on follow mode)
    *  If t within time of {T} but not within any T_i, then follow closest T_i
    *  If t within time of T_i, then follow T_i.
+   * Followed trajectories are indexed by their time ranges, so choosing which
+   * trajectory to follow takes O(log N) time for N non-overlapping trajectories,
+   * and only the chosen trajectory is locked while its data is read.
    */
   class OF_EXPORT TrajectoryFollower : public osg::Callback, public OpenFrames::TrajectorySubscriber
   {
@@ -60,7 +65,8 @@ namespace OpenFrames
 	enum FollowMode 
 	{
 	  LOOP = 0, // Loop around repeatedly
-	  LIMIT     // Limit the frame to the ends of the followed trajectory
+	  LIMIT,    // Limit the frame to the ends of the followed trajectory
+	  EXTRAPOLATE // Like LIMIT, but predict past the last point (see ExtrapolationType)
 	};
 
 	/** Specifies which of position or attitude we want to follow. */
@@ -70,6 +76,32 @@ namespace OpenFrames
 	  ATTITUDE = 2
 	};
 
+  /** Specifies how positions are interpolated between trajectory points.
+      Higher-order methods allow trajectories to be sampled more sparsely
+      while still producing smooth motion. */
+  enum PositionInterpolation
+  {
+    LINEAR = 0, // Linear interpolation between adjacent points
+    HERMITE,    // Cubic Hermite interpolation using velocities stored in an optional
+    LAGRANGE    // Lagrange polynomial interpolation of configurable order
+  };
+
+  /** Specifies how state is predicted past a trajectory's last point in
+      EXTRAPOLATE mode. This hides latency of live data feeds, since the
+      followed object keeps moving until new points arrive. */
+  enum ExtrapolationType
+  {
+    VELOCITY_EXTRAPOLATION = 0, // Use last velocity (optional if available, otherwise last two points)
+    POLYNOMIAL_EXTRAPOLATION    // Use Lagrange polynomial through the last points (see setLagrangeOrder)
+  };
+
+  /** Specifies how attitudes are interpolated between trajectory points. */
+  enum AttitudeInterpolation
+  {
+    SLERP = 0, // Spherical linear interpolation between adjacent attitudes
+    SQUAD      // Spherical cubic interpolation, smooth across trajectory points
+  };
+
 	TrajectoryFollower(Trajectory *traj = NULL);
 
 	// Don't allow copying from another TrajectoryFollower
@@ -102,6 +134,40 @@ namespace OpenFrames
 	  mode = _mode;
 	}
 
+  // Set how positions are interpolated between trajectory points
+  // HERMITE requires position components to come from POSOPT or ZERO sources,
+  // and falls back to LINEAR otherwise
+  void setPositionInterpolation(PositionInterpolation interp);
+  inline PositionInterpolation getPositionInterpolation() const { return _posInterp; }
+
+  // Set optional (1...NOPT) that contains velocities for HERMITE interpolation
+  // The velocity uses the same element and scale as each position component
+  void setVelocityOptional(unsigned int opt);
+  inline unsigned int getVelocityOptional() const { return _velOpt; }
+
+  // Set polynomial order used for LAGRANGE interpolation, which uses order+1
+  // points around the current time. Order 1 is the same as LINEAR.
+  void setLagrangeOrder(unsigned int order);
+  inline unsigned int getLagrangeOrder() const { return _lagrangeOrder; }
+
+  // Set how EXTRAPOLATE mode predicts state past the last trajectory point
+  void setExtrapolationType(ExtrapolationType type);
+  inline ExtrapolationType getExtrapolationType() const { return _extrapType; }
+
+  // Set max time past the last point to extrapolate, after which the
+  // state is held constant as in LIMIT mode
+  void setExtrapolationHorizon(double horizon);
+  inline double getExtrapolationHorizon() const { return _extrapHorizon; }
+
+  // Set time over which the extrapolated state is blended back to the
+  // trajectory when new points arrive. Zero means snap to the new state.
+  void setExtrapolationBlendTime(double blendTime);
+  inline double getExtrapolationBlendTime() const { return _extrapBlendTime; }
+
+  // Set how attitudes are interpolated between trajectory points
+  void setAttitudeInterpolation(AttitudeInterpolation interp);
+  inline AttitudeInterpolation getAttitudeInterpolation() const { return _attInterp; }
+
 	// Set source for each each position component
 	bool setXData(const Trajectory::DataSource &src);
 	bool setYData(const Trajectory::DataSource &src);
@@ -131,8 +197,8 @@ namespace OpenFrames
   
   /** Inherited from OpenFrames::TrajectorySubscriber
       Functions that inform about Trajectory changes */
-  virtual void dataCleared(const Trajectory* traj) { _needsUpdate = true; }
-  virtual void dataAdded(const Trajectory* traj) { _needsUpdate = true; }
+  virtual void dataCleared(const Trajectory* traj);
+  virtual void dataAdded(const Trajectory* traj);
 
   protected:
 	virtual ~TrajectoryFollower();
@@ -145,6 +211,42 @@ namespace OpenFrames
   
   // Update position & orientation based on adjusted time and chosen trajectory
 	bool _updateState(double time, FollowData data);
+
+  // Higher-order interpolation between points index and index+1 of the
+  // followed trajectory. Return false if interpolation could not be done,
+  // in which case the linearly interpolated state should be used.
+  bool _interpolateHermite(int index, double time, const Trajectory::DataArray &times);
+  bool _interpolateLagrange(int index, double time, unsigned int numPoints, const Trajectory::DataArray &times);
+  void _interpolateSquad(int index, double frac, unsigned int numPoints);
+
+  // Get sources for velocity, which use the same elements as position but
+  // come from the velocity optional. Returns false if velocity is unavailable.
+  bool _getVelocitySource(Trajectory::DataSource velSource[]) const;
+
+  // Evaluate the Lagrange polynomial through numInterp points beginning at
+  // start. Returns false if points have repeated times.
+  bool _evaluateLagrange(int start, int numInterp, double time, const Trajectory::DataArray &times);
+
+  // Predict state past the last of numPoints points in EXTRAPOLATE mode
+  // Returns false if state could not be extrapolated, in which case
+  // the last point should be used.
+  bool _extrapolate(double time, unsigned int numPoints, const Trajectory::DataArray &times, FollowData data);
+
+  // Blend state from previous extrapolated state when new points arrive
+  void _blendExtrapolation(double time, unsigned int numPoints, bool extrapolated, FollowData data);
+
+  /** Previous state of position or attitude in EXTRAPOLATE mode */
+  struct ExtrapolationState
+  {
+    ExtrapolationState()
+      : _extrapolated(false), _numPoints(0), _time(0.0), _blendStart(0.0)
+    {}
+
+    bool _extrapolated;      // Whether previous state was extrapolated
+    unsigned int _numPoints; // Number of trajectory points used for previous state
+    double _time;            // Time of previous state
+    double _blendStart;      // Time at which most recent blend started
+  };
   
   // Check if all followed trajectories support necessary data sources
   bool _verifyDataSources() const
@@ -157,13 +259,66 @@ namespace OpenFrames
     return true;
   }
   
+  /** Time range of a followed trajectory. The time index is a list of these
+      intervals sorted by start time, which allows the trajectory for a given
+      time to be found with a binary search. */
+  struct TimeInterval
+  {
+    double _t0, _tf;    // Trajectory time range, with _t0 <= _tf
+    double _maxTf;      // Max end time of this and all preceding intervals
+    unsigned int _maxTfIndex; // Index of interval whose end time is _maxTf
+    Trajectory* _traj;  // Trajectory with this time range
+  };
+  typedef std::vector<TimeInterval> TimeIndex;
+  typedef std::map<const Trajectory*, double> TrajStartTimes;
+  typedef std::set<const Trajectory*> TrajSet;
+
+  // Recreate time index from all followed trajectories
+  void _rebuildTimeIndex();
+
+  // Update time index for trajectories that have changed since last update
+  void _updateTimeIndex();
+
+  // Read a trajectory's time range, returns false if trajectory is empty
+  bool _readTimeInterval(Trajectory *traj, TimeInterval &interval) const;
+
+  // Add/remove a trajectory to/from the time index. Both return the index
+  // of the added/removed interval, or UINT_MAX if nothing was changed.
+  unsigned int _insertTimeInterval(Trajectory *traj);
+  unsigned int _removeTimeInterval(const Trajectory *traj);
+
+  // Find a trajectory's interval in the time index, or UINT_MAX if not found
+  unsigned int _findTimeInterval(const Trajectory *traj) const;
+
+  // Recompute max end times for all intervals starting at given index
+  void _updateMaxTimes(unsigned int start);
+
   typedef std::vector<osg::ref_ptr<Trajectory> > TrajList;
 
   TrajList _trajList; // All followed trajectories
+  TimeIndex _timeIndex; // Nonempty followed trajectories sorted by start time
+  TrajStartTimes _startTimes; // Start time of each followed trajectory (DBL_MAX if not in time index)
+  TrajSet _changedTrajs; // Trajectories changed since last time index update
+  OpenThreads::Mutex _changedMutex; // For modifying changed trajectories
   osg::observer_ptr<Trajectory> _follow; // Currently followed trajectory
 	FollowMode _mode; // Mode in which to follow trajectory
 	unsigned int _data; // Whether to follow position and/or attitude
 
+  // Interpolation settings
+  PositionInterpolation _posInterp;
+  AttitudeInterpolation _attInterp;
+  unsigned int _velOpt; // Optional containing velocity for HERMITE interpolation
+  unsigned int _lagrangeOrder; // Polynomial order for LAGRANGE interpolation
+
+  // Extrapolation settings and state
+  ExtrapolationType _extrapType;
+  double _extrapHorizon;   // Max time to extrapolate past last point
+  double _extrapBlendTime; // Time to blend from extrapolated to new state
+  ExtrapolationState _posExtrap, _attExtrap;
+  osg::Vec3d _extrapVel; // Velocity used for most recent position extrapolation
+  osg::Vec3d _prevPos, _prevVel, _posOffset; // Previous position, its velocity, and blend offset
+  osg::Quat _prevAtt, _attOffset; // Previous attitude and blend offset
+
 	  // Specifies which data to follow in the trajectory
 	Trajectory::DataSource _dataSource[3];
 	bool _dataValid; // Test if Trajectory supports needed data
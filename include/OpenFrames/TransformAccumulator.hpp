@@ -28,6 +28,7 @@
 #include <osg/NodeVisitor>
 #include <osg/Referenced>
 #include <osg/ref_ptr>
+#include <vector>
 
 namespace OpenFrames
 {
@@ -73,6 +74,11 @@ namespace OpenFrames
    * of its ancestor frames. To use, just specify the root frame and the target
    * frame then call the getLocalToWorld() or getWorldToLocal() method. The
    * accumulated transform between root & target frames is returned.
+   *
+   * Accumulated transforms are cached along with the generation counter of each
+   * FrameTransform in the path. Repeated calls return the cached transform if no
+   * FrameTransform has changed, and otherwise only recompute the part of the path
+   * at and below the first changed FrameTransform.
    */
   class OF_EXPORT TransformAccumulator : public osg::Referenced
   {
@@ -106,6 +112,24 @@ namespace OpenFrames
 
 	  // NodeVisitor that computes the transform from root to origin
 	osg::ref_ptr<TransformVisitor> _transformVisitor;
+
+	  // Cached transforms accumulated along the frame path
+	struct TransformCache
+	{
+	  TransformCache() : _pathGeneration(0), _globalGeneration(0), _valid(false) {}
+
+	  std::vector<osg::Matrixd> _matrices;    // Accumulated transform at each path frame
+	  std::vector<unsigned int> _generations; // Generation of each path frame's transform
+	  unsigned int _pathGeneration;           // Frame path generation when cached
+	  unsigned int _globalGeneration;         // Global transform generation when cached
+	  bool _valid;
+	};
+
+	  // Update the given cache and return its accumulated transform
+	const osg::Matrixd& _accumulate(TransformCache &cache, TransformVisitor::CoordMode mode);
+
+	TransformCache _localToWorld, _worldToLocal;
+	osg::Matrixd _matrix; // Most recently requested transform
   }; // !class TransformAccumulator
 
 }  // !namespace OpenFrames
@@ -21,9 +21,11 @@
 #ifndef _OF_UTILITIES_
 #define _OF_UTILITIES_
 
+#include <OpenFrames/Export.h>
 #include <OpenThreads/Condition>
 #include <OpenThreads/Mutex>
 #include <osg/Matrixd>
+#include <osg/Timer>
 #include <osg/View>
 
 namespace OpenFrames {
@@ -31,21 +33,92 @@ namespace OpenFrames {
   /** OpenFrames function that updates a projection matrix with specified near/far plane */
   void updateProjectionMatrix(osg::Matrix& proj, const double &zNear, const double &zfar);
   
+  /** Convert a perspective projection matrix to a reversed-z projection with the specified
+      near plane and an infinite far plane. Window depth is 1 at the near plane and 0 at
+      infinity, which requires a [0,1] clip-space depth range (see osg::ClipControl).
+      Returns false if the projection is orthographic. */
+  bool makeReversedZProjection(osg::Matrix& proj, const double &zNear);
+  
   /** Get the osg::View's viewport by searching its master camera then slave cameras */
   osg::Viewport* getMainViewport(osg::View *view);
   
   /** Get the osg::View's graphics context by searching its master camera then slave cameras */
   osg::GraphicsContext* getMainGraphicsContext(osg::View *view);
   
+  /** Contention statistics for one class of lock acquisitions (e.g. one priority).
+      Wait time is measured from the lock request until the lock is acquired, and
+      hold time from acquisition until release. Times are in seconds, and are also
+      binned into histograms with logarithmically spaced bins: bin 0 contains times
+      under 1 microsecond, bin i>0 contains times in [2^(i-1), 2^i) microseconds, and
+      the last bin also contains all longer times.
+   */
+  class OF_EXPORT LockStats
+  {
+  public:
+    enum { NUM_BINS = 32 };
+
+    LockStats() { reset(); }
+
+    /// Clear all statistics
+    void reset();
+
+    /// Record the wait time of one acquisition
+    void addWait(double t);
+
+    /// Record the hold time of one acquisition
+    void addHold(double t);
+
+    inline unsigned int getNumAcquisitions() const { return _numAcquisitions; }
+    inline unsigned int getNumHolds() const { return _numHolds; }
+    inline double getTotalWaitTime() const { return _totalWait; }
+    inline double getMaxWaitTime() const { return _maxWait; }
+    inline double getTotalHoldTime() const { return _totalHold; }
+    inline double getMaxHoldTime() const { return _maxHold; }
+
+    /// Number of waits/holds in the given histogram bin
+    inline unsigned int getWaitCount(unsigned int bin) const { return _waitHist[bin]; }
+    inline unsigned int getHoldCount(unsigned int bin) const { return _holdHist[bin]; }
+
+    /// Estimate the given percentile (0-100) of wait/hold times from the histograms.
+    /// Returns the upper limit of the bin that contains the percentile.
+    double getWaitPercentile(double p) const { return _getPercentile(_waitHist, _numAcquisitions, p); }
+    double getHoldPercentile(double p) const { return _getPercentile(_holdHist, _numHolds, p); }
+
+    /// Get the histogram bin that contains the given time (seconds)
+    static unsigned int getBin(double t);
+
+    /// Get the upper limit (seconds) of the given histogram bin
+    static double getBinLimit(unsigned int bin);
+
+  protected:
+    static double _getPercentile(const unsigned int hist[], unsigned int count, double p);
+
+    unsigned int _numAcquisitions, _numHolds;
+    double _totalWait, _maxWait, _totalHold, _maxHold;
+    unsigned int _waitHist[NUM_BINS];
+    unsigned int _holdHist[NUM_BINS];
+  };
+
   /** Implements a reader-writer mutex that is biased towards writers.
       Algorithm comes from https://github.com/angrave/SystemProgramming/wiki/Synchronization,-Part-7:-The-Reader-Writer-Problem
+      Lock statistics can optionally be recorded for readers and writers. Since
+      multiple readers can hold the lock at once, reader hold time is measured from
+      when the first reader enters the critical section until the last reader
+      leaves it, i.e. the time during which readers exclude writers.
    */
-  class ReadWriteMutex
+  class OF_EXPORT ReadWriteMutex
   {
   public:
     ReadWriteMutex()
-    : _writerWaitCount(0), _writerCount(0), _readerCount(0)
+    : _writerWaitCount(0), _writerCount(0), _readerCount(0),
+      _statsEnabled(false), _readHoldStart(0), _writeHoldStart(0)
     {}
+
+    enum LockType
+    {
+      READ,
+      WRITE
+    };
     
     /// Acquire the read lock
     /// This gives preference to waiting writers
@@ -59,6 +132,16 @@ namespace OpenFrames {
     
     /// Release the write lock
     int writeUnlock();
+
+    /// Enable/disable recording of lock statistics (disabled by default)
+    void setStatsEnabled(bool enable);
+    inline bool getStatsEnabled() const { return _statsEnabled; }
+
+    /// Get a copy of the lock statistics for readers or writers
+    LockStats getStats(LockType type) const;
+
+    /// Clear lock statistics for readers and writers
+    void resetStats();
     
   protected:
     int _writerWaitCount; // Number of writers waiting to enter the critical section
@@ -67,7 +150,12 @@ namespace OpenFrames {
     // Note that if _readerCount > 0 then _writerCount must be 0 (and vice versa)
     
     OpenThreads::Condition _turnCond; // Wait for a turn to enter critical section
-    OpenThreads::Mutex _countLock;    // Lock while updating counters
+    mutable OpenThreads::Mutex _countLock; // Lock while updating counters and stats
+
+    bool _statsEnabled;
+    osg::Timer_t _readHoldStart;  // Time first reader entered critical section
+    osg::Timer_t _writeHoldStart; // Time writer entered critical section
+    LockStats _readStats, _writeStats;
   };
   
 } // !namespace OpenFrames
@@ -23,8 +23,12 @@
 
 #include <OpenFrames/Export.h>
 #include <OpenFrames/RenderRectangle.hpp>
+#include <OpenFrames/FrameCapture.hpp>
 #include <OpenFrames/FramerateLimiter.hpp>
+#include <OpenFrames/FrameTimingStats.hpp>
 #include <OpenFrames/OpenVRDevice.hpp>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Block>
 #include <OpenThreads/Thread>
 #include <osg/FrameStamp>
 #include <osg/Timer>
@@ -46,6 +50,7 @@
 namespace OpenFrames
 {
   class FrameManager;
+  class TimedSwapCallback;
   class WindowProxy;
   
   /**
@@ -194,6 +199,45 @@ namespace OpenFrames
     unsigned int getWindowHeight() const;
     
     bool isEmbedded() const { return _isEmbedded; }
+
+    /** Render to an offscreen pixel buffer instead of an on-screen window, e.g. to
+        generate images or videos on machines without a display. Offscreen windows
+        are not throttled by the FramerateLimiter, so they animate as fast as possible.
+        Must be set before animation starts, and does not apply to embedded or VR windows. */
+    void setOffscreen(bool offscreen);
+    bool isOffscreen() const { return _isOffscreen; }
+
+    /** Stop animating after the given number of frames. 0 (default) means no limit. */
+    void setMaxFrames(unsigned int maxFrames) { _maxFrames = maxFrames; }
+    unsigned int getMaxFrames() const { return _maxFrames; }
+
+    /** Set the threading model used to update, cull, and draw all RenderRectangles.
+        SingleThreaded (default) does everything in this WindowProxy's thread. Other
+        models cull and/or draw in separate threads, e.g. DrawThreadPerContext
+        overlaps drawing one frame with updating and culling the next, and
+        CullThreadPerCameraDrawThreadPerContext also culls each camera in parallel.
+        With models that draw in a separate thread, FrameManagers stay locked until
+        the frame has been drawn and swapped, so that scenes can be modified while
+        unlocked as usual. This limits overlap between drawing one frame and
+        updating the next to the time the scenes are unlocked.
+        Frame timing phases other than the total are only exact when single-threaded.
+        Takes effect at the next frame. Embedded and VR windows are always single-threaded. */
+    void setThreadingModel(osgViewer::ViewerBase::ThreadingModel model);
+    osgViewer::ViewerBase::ThreadingModel getThreadingModel() const { return _threadingModel; }
+
+    /** Only render a frame when something may have changed: simulation time advances,
+        an input event arrives, a scene's FrameManager is unlocked after a high-priority
+        lock or has staged states, a Trajectory informs its subscribers, a FrameTransform
+        changes, a camera manipulator is animating, or frames are being captured.
+        Otherwise the window sleeps until requestRedraw() is called, waking to poll for
+        the above changes at a rate that drops to 10 Hz while idle. Disabled by default.
+        Call requestRedraw() after other changes, e.g. to colors or views. */
+    void setRenderOnDemand(bool onDemand);
+    bool getRenderOnDemand() const { return _renderOnDemand; }
+
+    /** Render the next frame even if nothing has changed, and discard results cached by
+        incremental depth partitioning. Can be called from any thread. */
+    void requestRedraw() { _redrawRequested.exchange(1); _partitionsDirty.exchange(1); _redrawBlock.release(); }
     
     /** These functions should be called when keyboard/mouse input is
 	    recieved from your own Window Manager, or if you want to simulate
@@ -211,7 +255,7 @@ namespace OpenFrames
     void setupGrid(unsigned int width, unsigned int height);
     
     /** Shut down the WindowProxy entirely. */
-    void shutdown() { _viewer->setDone(true); }
+    void shutdown() { _viewer->setDone(true); _redrawBlock.release(); }
     
     /** Time control */
     void setTime(double time);
@@ -238,6 +282,12 @@ namespace OpenFrames
       if(_timeSyncWinProxy.valid()) return _timeSyncWinProxy->getTimeScale();
       else return _timeScale;
     }
+
+    /** Advance simulation time by a fixed step (times the time scale) at each
+        frame instead of following the wall clock. This makes animations
+        independent of rendering speed. 0 (default) means follow the wall clock. */
+    void setFixedTimeStep(double dt);
+    double getFixedTimeStep() const { return _fixedTimeStep; }
     
     /** Synchronize time with another WindowProxy
         This causes all time control to be forwarded to the other WindowProxy
@@ -281,6 +331,22 @@ namespace OpenFrames
     void resetAnimationState() { if(doneAnimating()) _animationState = IDLE; }
     
     FramerateLimiter* getFramerateLimiter() { return &_frameThrottle; }
+
+    /** Enable/disable collection of per-frame timing statistics (disabled by default).
+        Statistics can be read from any thread while animating, and shown on a
+        RenderRectangle's HUD with RenderRectangle::setShowFrameTiming(). */
+    void setFrameTimingEnabled(bool enable) { _frameTimingEnabled = enable; }
+    bool getFrameTimingEnabled() const { return _frameTimingEnabled; }
+    FrameTimingStats* getFrameTimingStats() const { return _frameTiming.get(); }
+
+    /** Write frame timing statistics to a JSON file if the filename ends
+        with .json, or to a CSV file otherwise */
+    bool writeFrameTiming(const std::string& fname) const;
+
+    /** Get the capturer that records every rendered frame of this window, e.g. to
+        image files or a video encoder. Frames are read back asynchronously and
+        encoded on background threads. Use FrameCapture::start()/stop(). */
+    FrameCapture* getFrameCapture() const { return _frameCapture.get(); }
     
     osgViewer::CompositeViewer* getViewer() const { return _viewer.get(); }
     
@@ -385,6 +451,23 @@ namespace OpenFrames
     bool setupWindow();
     void collectScenes();
     void frame();
+
+    // Compute simulation time of the next frame
+    double computeFrameTime() const;
+
+    // Determine whether the next frame has to be rendered in render-on-demand mode.
+    // Polls the windowing system for events, so call from the rendering thread.
+    bool checkNeedToDoFrame();
+
+    // Sum of generation counters of all scenes
+    unsigned int getScenesGeneration() const;
+
+    // Process events, then update, cull, and draw all scenes while recording
+    // the time taken by each phase
+    void timedViewerFrame(FrameTimingStats::FrameTiming &timing);
+
+    // Show latest frame timing statistics on RenderRectangles that display them
+    void updateFrameTimingText();
     
     /** ID of this window. This will be used to identify this window to all
 	    user-defined callback functions */
@@ -393,6 +476,15 @@ namespace OpenFrames
     unsigned int _nRow, _nCol; // Number of rows/columns in this window's grid
     
     bool _isEmbedded; // True if the user wants to provide their own OpenGL window
+    bool _isOffscreen; // True if rendering to an offscreen pixel buffer
+    unsigned int _maxFrames; // Number of frames to render before stopping
+
+    /** Render-on-demand state */
+    bool _renderOnDemand;
+    OpenThreads::Atomic _redrawRequested;
+    OpenThreads::Block _redrawBlock; // Released by requestRedraw() to wake an idle window
+    OpenThreads::Atomic _partitionsDirty; // Whether depth partition caches should be discarded
+    unsigned int _scenesGeneration, _transformGeneration, _trajectoryGeneration; // As of last frame
     
     /** The CompositeViewer handles drawing several scenes onto a single drawing surface (a window). */
     osg::ref_ptr<osgViewer::CompositeViewer> _viewer;
@@ -402,6 +494,7 @@ namespace OpenFrames
     
     typedef std::set<FrameManager*> SceneSet;
     SceneSet _scenes; // Set of all unique scenes
+    std::vector<bool> _scenesLocked; // Whether each scene was locked for the current frame
     
     /** The GraphicsWindow is the actual window that is drawn onto */
     osg::ref_ptr<osgViewer::GraphicsWindow> _window;
@@ -420,6 +513,16 @@ namespace OpenFrames
 
     FramerateLimiter _frameThrottle; // Controls animation framerate
 
+    /** Captures rendered frames to files or an external encoder */
+    osg::ref_ptr<FrameCapture> _frameCapture;
+
+    /** Frame timing statistics */
+    osg::ref_ptr<FrameTimingStats> _frameTiming;
+    bool _frameTimingEnabled;
+    double _throttleTime; // Time spent in framerate limiter before current frame
+    osg::ref_ptr<TimedSwapCallback> _swapCallback; // Captures and swaps finished frames
+    osg::Timer_t _timingTextTick; // Time when frame timing text was last updated
+
     /** Time control variables */
     AnimationState _animationState; // Current animation state
     bool _pauseAnimation;           // Indicate that animation should be paused
@@ -427,9 +530,12 @@ namespace OpenFrames
     osg::Timer_t _Tref;
     double _currTime, _offsetTime, _timeScale;
     double _minTime, _maxTime;
+    double _fixedTimeStep; // Simulation time step per frame, 0 to follow wall clock
+    unsigned int _numTimeSteps; // Number of fixed time steps since time was last set
     osg::observer_ptr<WindowProxy> _timeSyncWinProxy;
     
     bool _useVR; // Whether to use VR rendering
+    osgViewer::ViewerBase::ThreadingModel _threadingModel; // Requested threading model
     osg::ref_ptr<OpenVRDevice> _ovrDevice; // OpenVR interface
     osg::ref_ptr<VRTextureBuffer> _vrTextureBuffer; // VR texture buffers
   };
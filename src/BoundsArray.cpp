@@ -0,0 +1,389 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file BoundsArray.cpp
+ * BoundsArray-class function definitions.
+ */
+
+#include <OpenFrames/BoundsArray.hpp>
+#include <OpenFrames/FrameTransform.hpp>
+#include <OpenFrames/Trajectory.hpp>
+#include <osg/NodeVisitor>
+#include <osg/Projection>
+#include <algorithm>
+#include <cmath>
+
+namespace OpenFrames
+{
+  /** Maximum number of nodes checked for structural changes per update */
+  static const unsigned int maxStructureChecks = 4096;
+  
+  /** Largest factor by which a matrix scales lengths, assuming no shear */
+  static double getMaxScale(const osg::Matrixd &mat)
+  {
+    double sx = mat(0,0)*mat(0,0) + mat(0,1)*mat(0,1) + mat(0,2)*mat(0,2);
+    double sy = mat(1,0)*mat(1,0) + mat(1,1)*mat(1,1) + mat(1,2)*mat(1,2);
+    double sz = mat(2,0)*mat(2,0) + mat(2,1)*mat(2,1) + mat(2,2)*mat(2,2);
+    return std::sqrt(std::max(sx, std::max(sy, sz)));
+  }
+  
+  /** Traverses the scene, storing its leaves, the transforms above them, and
+   view-dependent subgraphs */
+  class BoundsArray::Builder : public osg::NodeVisitor
+  {
+  public:
+    Builder(BoundsArray &bounds, unsigned int maxDepth)
+    : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN),
+    _bounds(bounds), _maxDepth(maxDepth), _depth(0), _transform(-1)
+    {}
+    
+    // Store a node's state, which is checked for structural changes
+    void record(osg::Node &node)
+    {
+      osg::Group *group = node.asGroup();
+      _bounds._nodes.push_back(&node);
+      _bounds._groups.push_back(group);
+      _bounds._nodeMasks.push_back(node.getNodeMask());
+      _bounds._numChildren.push_back(group ? group->getNumChildren() : 0);
+    }
+    
+    virtual void apply(osg::Node &node)
+    {
+      osg::Group *group = node.asGroup();
+      
+      // Nodes without children, and nodes at the maximum depth, are leaves.
+      // Like DistanceAccumulator, continue past the maximum depth if culling is disabled.
+      if(!group || ((_depth >= _maxDepth) && node.isCullingActive()))
+      {
+        _bounds._leaves.push_back(&node);
+        _bounds._leafTransforms.push_back(_transform);
+      }
+      else traverseGroup(*group);
+    }
+    
+    virtual void apply(osg::Projection &proj)
+    {
+      addSubgraph(proj); // Changes the view frustum
+    }
+    
+    virtual void apply(osg::Transform &transform)
+    {
+      // Only transforms whose matrices don't depend on the view can be stored.
+      // Changes to their matrices are detected by update().
+      FrameTransform *xform = dynamic_cast<FrameTransform*>(&transform);
+      bool isStatic = (transform.getReferenceFrame() == osg::Transform::RELATIVE_RF) &&
+        (xform ? !xform->getFollowEye() :
+         (transform.asMatrixTransform() || transform.asPositionAttitudeTransform()));
+      if(!isStatic) 
+      {
+        addSubgraph(transform);
+        return;
+      }
+      
+      if((_depth >= _maxDepth) && transform.isCullingActive())
+      {
+        apply(static_cast<osg::Node&>(transform));
+        return;
+      }
+      
+      // Children of this transform use its world matrix
+      int parent = _transform;
+      _transform = _bounds._transforms.size();
+      _bounds._transforms.push_back(&transform);
+      _bounds._frameTransforms.push_back(xform);
+      _bounds._transformParents.push_back(parent);
+      traverseGroup(transform);
+      _transform = parent;
+    }
+    
+  protected:
+    // Record all children (including hidden ones) before traversing visible ones
+    void traverseGroup(osg::Group &group)
+    {
+      for(unsigned int i = 0; i < group.getNumChildren(); ++i)
+      {
+        record(*group.getChild(i));
+      }
+      
+      ++_depth;
+      traverse(group);
+      --_depth;
+    }
+    
+    void addSubgraph(osg::Node &node)
+    {
+      Subgraph subgraph;
+      subgraph._node = &node;
+      subgraph._depth = _depth;
+      _bounds._subgraphs.push_back(subgraph);
+      _bounds._subgraphTransforms.push_back(_transform);
+    }
+    
+    BoundsArray &_bounds;
+    unsigned int _maxDepth, _depth;
+    int _transform; // Index of current transform, or -1 for none
+  };
+  
+  /*******************************************************/
+  BoundsArray::BoundsArray()
+  : _nextStructureCheck(0), _valid(false), _traversalMask(0), _nodeMaskOverride(0), _maxDepth(0),
+  _frameGeneration(0), _trajectoryGeneration(0)
+  {}
+  
+  /*******************************************************/
+  BoundsArray::~BoundsArray() {}
+  
+  /*******************************************************/
+  bool BoundsArray::update(osg::Node &scene, unsigned int traversalMask, unsigned int nodeMaskOverride,
+                           unsigned int maxDepth)
+  {
+    bool rebuild = !_valid || (traversalMask != _traversalMask) ||
+      (nodeMaskOverride != _nodeMaskOverride) || (maxDepth != _maxDepth) ||
+      _nodes.empty() || (_nodes[0] != &scene) || structureChanged();
+    
+    if(rebuild)
+    {
+      _nodes.clear();
+      _groups.clear();
+      _nodeMasks.clear();
+      _numChildren.clear();
+      _transforms.clear();
+      _frameTransforms.clear();
+      _transformParents.clear();
+      _leaves.clear();
+      _leafTransforms.clear();
+      _subgraphs.clear();
+      _subgraphTransforms.clear();
+      
+      Builder builder(*this, maxDepth);
+      builder.setTraversalMask(traversalMask);
+      builder.setNodeMaskOverride(nodeMaskOverride);
+      builder.record(scene);
+      scene.accept(builder);
+      sortLeaves();
+      
+      _valid = true;
+      _traversalMask = traversalMask;
+      _nodeMaskOverride = nodeMaskOverride;
+      _maxDepth = maxDepth;
+      _nextStructureCheck = 0;
+    }
+    
+    // Moved transforms change the leaf bounds below them, and changed
+    // trajectories can change any leaf bounds
+    unsigned int trajectoryGeneration = Trajectory::getGlobalGeneration();
+    bool allLeaves = rebuild || (trajectoryGeneration != _trajectoryGeneration);
+    _trajectoryGeneration = trajectoryGeneration;
+    if(updateTransforms(rebuild) || allLeaves) updateLeaves(allLeaves);
+    
+    return rebuild;
+  }
+  
+  /*******************************************************/
+  bool BoundsArray::structureChanged()
+  {
+    // Large scenes are checked over several updates, to avoid scanning every node each frame
+    const unsigned int numNodes = _nodes.size();
+    const unsigned int numChecks = std::min(numNodes, maxStructureChecks);
+    for(unsigned int n = 0; n < numChecks; ++n)
+    {
+      const unsigned int i = _nextStructureCheck;
+      if(++_nextStructureCheck >= numNodes) _nextStructureCheck = 0;
+      
+      if(_nodes[i]->getNodeMask() != _nodeMasks[i]) return true;
+      
+      const osg::Group *group = _groups[i];
+      if((group ? group->getNumChildren() : 0) != _numChildren[i]) return true;
+    }
+    
+    return false;
+  }
+  
+  /*******************************************************/
+  void BoundsArray::sortLeaves()
+  {
+    // Counting sort, where leaves without a transform come first
+    const unsigned int numLeaves = _leaves.size();
+    const unsigned int numRanges = _transforms.size() + 1;
+    _leafRanges.assign(numRanges + 1, 0);
+    for(unsigned int i = 0; i < numLeaves; ++i)
+    {
+      ++_leafRanges[_leafTransforms[i] + 2];
+    }
+    for(unsigned int r = 1; r <= numRanges; ++r)
+    {
+      _leafRanges[r] += _leafRanges[r-1];
+    }
+    
+    std::vector<unsigned int> next(_leafRanges.begin(), _leafRanges.end() - 1);
+    std::vector<osg::ref_ptr<osg::Node> > leaves(numLeaves);
+    std::vector<int> leafTransforms(numLeaves);
+    for(unsigned int i = 0; i < numLeaves; ++i)
+    {
+      const unsigned int pos = next[_leafTransforms[i] + 1]++;
+      leaves[pos] = _leaves[i];
+      leafTransforms[pos] = _leafTransforms[i];
+    }
+    _leaves.swap(leaves);
+    _leafTransforms.swap(leafTransforms);
+  }
+  
+  /*******************************************************/
+  bool BoundsArray::updateTransforms(bool all)
+  {
+    const unsigned int numTransforms = _transforms.size();
+    _worldMatrices.resize(numTransforms);
+    _worldScales.resize(numTransforms);
+    _transformGenerations.resize(numTransforms);
+    _localMatrices.resize(numTransforms);
+    _changedTransforms.assign(numTransforms, 0);
+    
+    // FrameTransforms only need to be checked if any of them changed
+    unsigned int frameGeneration = FrameTransform::getGlobalGeneration();
+    bool checkFrames = all || (frameGeneration != _frameGeneration);
+    _frameGeneration = frameGeneration;
+    
+    bool anyChanged = false;
+    osg::Matrixd local;
+    for(unsigned int i = 0; i < numTransforms; ++i)
+    {
+      bool changed = all;
+      if(_frameTransforms[i])
+      {
+        if(checkFrames)
+        {
+          unsigned int generation = _frameTransforms[i]->getGeneration();
+          if(generation != _transformGenerations[i]) changed = true;
+          _transformGenerations[i] = generation;
+        }
+      }
+      else
+      {
+        // Other transforms don't count their changes, so compare their matrices
+        local.makeIdentity();
+        _transforms[i]->computeLocalToWorldMatrix(local, NULL);
+        if(local != _localMatrices[i]) changed = true;
+        _localMatrices[i] = local;
+      }
+      
+      // Parents are stored before their children, so their world matrices are ready
+      int parent = _transformParents[i];
+      if(!changed && ((parent < 0) || !_changedTransforms[parent])) continue;
+      osg::Matrixd matrix = (parent < 0) ? osg::Matrixd::identity() : _worldMatrices[parent];
+      _transforms[i]->computeLocalToWorldMatrix(matrix, NULL);
+      _worldMatrices[i] = matrix;
+      _worldScales[i] = getMaxScale(matrix);
+      _changedTransforms[i] = 1;
+      anyChanged = true;
+    }
+    
+    for(unsigned int i = 0; i < _subgraphs.size(); ++i)
+    {
+      int xform = _subgraphTransforms[i];
+      if(xform < 0) _subgraphs[i]._worldMatrix.makeIdentity();
+      else if(_changedTransforms[xform]) _subgraphs[i]._worldMatrix = _worldMatrices[xform];
+    }
+    
+    return anyChanged;
+  }
+  
+  /*******************************************************/
+  void BoundsArray::updateLeaves(bool all)
+  {
+    const unsigned int numLeaves = _leaves.size();
+    _centerX.resize(numLeaves);
+    _centerY.resize(numLeaves);
+    _centerZ.resize(numLeaves);
+    _radius.resize(numLeaves);
+    
+    // Leaves are sorted by transform, so each changed transform updates one range
+    const unsigned int numRanges = _transforms.size() + 1;
+    for(unsigned int r = 0; r < numRanges; ++r)
+    {
+      const int xform = (int)r - 1;
+      if(!all && ((xform < 0) || !_changedTransforms[xform])) continue;
+      
+      for(unsigned int i = _leafRanges[r]; i < _leafRanges[r+1]; ++i)
+      {
+        osg::BoundingSphere bs = _leaves[i]->getBound();
+        if(!bs.valid())
+        {
+          _radius[i] = -1.0;
+          continue;
+        }
+        
+        osg::Vec3d center = bs._center;
+        double radius = bs._radius;
+        if(xform >= 0)
+        {
+          center = center * _worldMatrices[xform];
+          radius *= _worldScales[xform];
+        }
+        
+        _centerX[i] = center.x();
+        _centerY[i] = center.y();
+        _centerZ[i] = center.z();
+        _radius[i] = radius;
+      }
+    }
+  }
+  
+  /*******************************************************/
+  void BoundsArray::computeDistances(const osg::Matrixd &modelview, const osg::Matrixd &projection,
+                                     PairList &pairs) const
+  {
+    // Side planes of the view frustum in world space, from the columns of the
+    // world-to-clip matrix: -w <= x <= w and -w <= y <= w
+    const osg::Matrixd mvp = modelview*projection;
+    double planes[4][4];
+    for(unsigned int p = 0; p < 4; ++p)
+    {
+      const unsigned int col = p/2; // x or y
+      const double sign = (p%2) ? -1.0 : 1.0;
+      for(unsigned int j = 0; j < 4; ++j)
+      {
+        planes[p][j] = mvp(j,3) + sign*mvp(j,col);
+      }
+      
+      // Normalize so that plane distances can be compared with radii
+      double len = std::sqrt(planes[p][0]*planes[p][0] + planes[p][1]*planes[p][1] + planes[p][2]*planes[p][2]);
+      if(len > 0.0) for(unsigned int j = 0; j < 4; ++j) planes[p][j] /= len;
+    }
+    
+    // Eye distance is along the view direction, i.e. the negative eye-space z axis
+    const double zx = -modelview(0,2), zy = -modelview(1,2), zz = -modelview(2,2), zw = -modelview(3,2);
+    const double viewScale = getMaxScale(modelview);
+    
+    const double *cx = _centerX.data(), *cy = _centerY.data(), *cz = _centerZ.data(), *r = _radius.data();
+    const unsigned int numSpheres = _radius.size();
+    for(unsigned int i = 0; i < numSpheres; ++i)
+    {
+      // Skip invalid spheres and spheres outside any side plane
+      const double negRadius = -r[i];
+      bool visible = (negRadius <= 0.0);
+      for(unsigned int p = 0; p < 4; ++p)
+      {
+        visible &= (planes[p][0]*cx[i] + planes[p][1]*cy[i] + planes[p][2]*cz[i] + planes[p][3] >= negRadius);
+      }
+      if(!visible) continue;
+      
+      const double dist = zx*cx[i] + zy*cy[i] + zz*cz[i] + zw;
+      const double rad = r[i]*viewScale;
+      pairs.push_back(DistancePair(dist - rad, dist + rad));
+    }
+  }
+  
+} // !namespace OpenFrames
@@ -220,7 +220,8 @@ bool CoordinateAxes::setTickImage(const std::string &fname)
           // Set up alpha blending for texture
           osg::BlendFunc *fn = new osg::BlendFunc();
           fn->setFunction(osg::BlendFunc::SRC_ALPHA,
-              osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
+              osg::BlendFunc::ONE_MINUS_SRC_ALPHA,
+              osg::BlendFunc::ONE, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
           ss->setAttributeAndModes(fn);
 
           // Fragment shader to draw the marker texture
@@ -22,16 +22,43 @@
 #include <OpenFrames/DoubleSingleUtils.hpp>
 #include <osg/Geometry>
 #include <climits>
+#include <algorithm>
 
 namespace OpenFrames
 {
 
+/** Computes the bounding box of a chunk whose vertices are offsets from its center. */
+class ChunkBoundingBoxCallback : public osg::Drawable::ComputeBoundingBoxCallback
+{
+public:
+  ChunkBoundingBoxCallback(const osg::Vec3d &center) : _center(center) {}
+
+  virtual osg::BoundingBox computeBound(const osg::Drawable &drawable) const
+  {
+    osg::BoundingBox bb;
+    const osg::Geometry *geom = drawable.asGeometry();
+    const osg::Vec3Array *vertices = geom ? static_cast<const osg::Vec3Array*>(geom->getVertexArray()) : NULL;
+    if (vertices)
+    {
+      for (unsigned int i = 0; i < vertices->size(); ++i)
+      {
+        bb.expandBy(osg::Vec3d((*vertices)[i]) + _center);
+      }
+    }
+    return bb;
+  }
+
+private:
+  osg::Vec3d _center;
+};
+
 /** Updates a CurveArtist's internal geometry when its target Trajectory changes. */
 class CurveArtistUpdateCallback : public osg::Callback
 {
 public:
   CurveArtistUpdateCallback()
-    : _dataAdded(true), _dataCleared(true), _batchSize(1000), _lastUpdateTime(0.0), _lastRunTime(0.0)
+    : _dataAdded(true), _dataCleared(true), _batchSize(1000), _lastUpdateTime(0.0), _lastRunTime(0.0),
+    _encoding(CurveArtist::DOUBLE_SINGLE), _numPoints(0), _firstDirtyChunk(0)
   {}
 
   void dataAdded() { _dataAdded = true; }
@@ -56,6 +83,16 @@ public:
     _vertexLow = static_cast<osg::Vec3Array*>(_geom->getVertexAttribArray(TrajectoryArtist::OF_VERTEXLOW));
     _drawArrays = static_cast<osg::DrawArrays*>(_geom->getPrimitiveSet(0));
 
+    // Recompute all points if the vertex encoding changed
+    if (_encoding != _ca->getVertexEncoding())
+    {
+      clearVertexData();
+      _vertexHigh->asVector().shrink_to_fit();
+      _vertexLow->asVector().shrink_to_fit();
+      _encoding = _ca->getVertexEncoding();
+      _dataCleared = true;
+    }
+
     // Clear data if it is invalid or all points are zero
     if (!_ca->isDataValid() || _ca->isDataZero())
     {
@@ -86,7 +123,8 @@ public:
 
         // Process trajectory points
         unsigned int newNumPoints = _traj->getNumPoints(_ca->getDataSource());
-        processPoints(newNumPoints);
+        if (_encoding == CurveArtist::CHUNKED_RTC) processChunks(newNumPoints);
+        else processPoints(newNumPoints);
 
         // Unlock trajectory
         _traj->unlockData();
@@ -118,6 +156,12 @@ private:
     _vertexHigh->clear();
     _vertexLow->clear();
     _drawArrays->setCount(0);
+
+    // Remove all chunks, which are drawn after the double-single geometry
+    if (_ca->getNumDrawables() > 1) _ca->removeDrawables(1, _ca->getNumDrawables() - 1);
+    _chunks.clear();
+    _numPoints = 0;
+    _firstDirtyChunk = 0;
   }
 
   void dirtyVertexData()
@@ -127,6 +171,17 @@ private:
     _vertexLow->dirty();
     _drawArrays->dirty();
     _geom->dirtyBound();
+
+    // Dirty chunks that have changed
+    for (unsigned int i = _firstDirtyChunk; i < _chunks.size(); ++i)
+    {
+      Chunk &chunk = _chunks[i];
+      chunk._vertices->dirty();
+      chunk._drawArrays->setCount(chunk._vertices->size());
+      chunk._drawArrays->dirty();
+      chunk._geom->dirtyBound();
+    }
+    _firstDirtyChunk = _chunks.size();
   }
 
   void processPoints(unsigned int newNumPoints)
@@ -140,21 +195,98 @@ private:
       _vertexLow->resize(newSize);
     }
 
-    // Process each new point
-    osg::Vec3d newPoint;
-    osg::Vec3f high, low;
-    for (unsigned int i = _drawArrays->getCount(); i < newNumPoints; ++i)
+    // Process new points in batches: gather each batch of points, then split
+    // them into high and low portions to support GPU-based RTE rendering
+    unsigned int start = _drawArrays->getCount();
+    while (start < newNumPoints)
     {
-      _traj->getPoint(i, _ca->getDataSource(), newPoint._v); // Get current point
-
-      // Split point into high and low portions to support GPU-based RTE rendering
-      OpenFrames::DS_Split(newPoint, high, low);
-      (*_vertexHigh)[i] = high;
-      (*_vertexLow)[i] = low;
+      unsigned int count = std::min(newNumPoints - start, _batchSize);
+      _points.resize(count);
+      for (unsigned int i = 0; i < count; ++i)
+      {
+        _traj->getPoint(start + i, _ca->getDataSource(), _points[i]._v);
+      }
+      OpenFrames::DS_Split(&_points[0], count, &(*_vertexHigh)[start], &(*_vertexLow)[start]);
+      start += count;
     }
     _drawArrays->setCount(newNumPoints);
   }
 
+  /** Start a new chunk of vertices that are relative to the given center */
+  void addChunk(const osg::Vec3d &center)
+  {
+    Chunk chunk;
+    chunk._center = center;
+    chunk._vertices = new osg::Vec3Array();
+    chunk._drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, 0);
+
+    chunk._geom = new osg::Geometry;
+    chunk._geom->setDataVariance(osg::Object::DYNAMIC);
+    chunk._geom->setUseDisplayList(false);
+    chunk._geom->setUseVertexBufferObjects(true);
+    chunk._geom->setVertexArray(chunk._vertices);
+    chunk._geom->setColorArray(_geom->getColorArray()); // Share line color
+    chunk._geom->addPrimitiveSet(chunk._drawArrays);
+    chunk._geom->getOrCreateVertexBufferObject()->setUsage(GL_DYNAMIC_DRAW);
+    chunk._geom->setComputeBoundingBoxCallback(new ChunkBoundingBoxCallback(center));
+
+    // Chunk center is split into high and low portions, which the shader
+    // renders relative to the eye
+    osg::Vec3f centerHigh, centerLow;
+    OpenFrames::DS_Split(center, centerHigh, centerLow);
+    osg::StateSet *stateset = chunk._geom->getOrCreateStateSet();
+    stateset->setAttribute(_ca->getRTCProgram());
+    stateset->addUniform(new osg::Uniform("of_ChunkCenterHigh", centerHigh));
+    stateset->addUniform(new osg::Uniform("of_ChunkCenterLow", centerLow));
+
+    _ca->addDrawable(chunk._geom);
+    _chunks.push_back(chunk);
+  }
+
+  void processChunks(unsigned int newNumPoints)
+  {
+    unsigned int maxPoints = std::max(_ca->getChunkSize(), 2u);
+    double maxRadius2 = _ca->getChunkRadius()*_ca->getChunkRadius();
+
+    // Only the last chunk and new chunks will change
+    _firstDirtyChunk = _chunks.empty() ? 0 : _chunks.size() - 1;
+
+    // Add each new point to the last chunk, starting a new chunk centered at the
+    // point if the last chunk is full or the point is too far from its center
+    osg::Vec3d point;
+    for (unsigned int i = _numPoints; i < newNumPoints; ++i)
+    {
+      _traj->getPoint(i, _ca->getDataSource(), point._v);
+
+      Chunk *chunk = _chunks.empty() ? NULL : &_chunks.back();
+      if ((chunk == NULL) || (chunk->_vertices->size() >= maxPoints) ||
+          ((maxRadius2 > 0.0) && ((point - chunk->_center).length2() > maxRadius2)))
+      {
+        // Full chunks won't grow, so release their unused memory
+        if (chunk) chunk->_vertices->asVector().shrink_to_fit();
+
+        addChunk(point);
+        chunk = &_chunks.back();
+
+        // Repeat the previous point so that line strips of adjacent chunks are connected
+        if (i > 0) chunk->_vertices->push_back(_lastPoint - point);
+      }
+
+      chunk->_vertices->push_back(point - chunk->_center);
+      _lastPoint = point;
+    }
+    _numPoints = newNumPoints;
+  }
+
+  /** A chunk of vertices stored as single-precision offsets from a double-precision center */
+  struct Chunk
+  {
+    osg::Geometry* _geom;
+    osg::Vec3Array* _vertices;
+    osg::DrawArrays* _drawArrays;
+    osg::Vec3d _center;
+  };
+
   bool _dataAdded, _dataCleared;
   unsigned int _batchSize;
   double _lastUpdateTime, _lastRunTime;
@@ -163,12 +295,21 @@ private:
   osg::Vec3Array* _vertexHigh;
   osg::Vec3Array* _vertexLow;
   osg::DrawArrays* _drawArrays;
+  std::vector<osg::Vec3d> _points; // Points being split into high/low portions
   const Trajectory* _traj;
   CurveArtist* _ca;
+
+  // Relative-to-center chunks, used by the CHUNKED_RTC vertex encoding
+  CurveArtist::VertexEncoding _encoding;
+  std::vector<Chunk> _chunks;
+  unsigned int _numPoints; // Number of points in chunks
+  unsigned int _firstDirtyChunk; // First chunk that changed since last dirtied
+  osg::Vec3d _lastPoint; // Last point added to chunks
 };
 
 CurveArtist::CurveArtist(const Trajectory *traj)
-: _dataValid(false), _dataZero(false)
+: _dataValid(false), _dataZero(false), _vertexEncoding(DOUBLE_SINGLE),
+  _chunkSize(4096), _chunkRadius(0.0)
 {
 	setTrajectory(traj); // Set the specified trajectory
 
@@ -202,6 +343,7 @@ CurveArtist::CurveArtist(const Trajectory *traj)
 	_lineWidth = new osg::LineWidth;
 	_linePattern = new osg::LineStipple;
   osg::StateSet* stateset = getOrCreateStateSet();
+  stateset->setDataVariance(osg::Object::DYNAMIC); // Line properties can change while drawing
 	stateset->setAttribute(_lineWidth.get());
 	stateset->setAttributeAndModes(_linePattern.get());
 
@@ -296,6 +438,38 @@ void CurveArtist::setPattern( GLint factor, GLushort pattern )
 	_linePattern->setPattern(pattern);
 }
 
+void CurveArtist::setVertexEncoding(VertexEncoding encoding)
+{
+  // Update callback recomputes vertices when it detects the new encoding
+  _vertexEncoding = encoding;
+}
+
+void CurveArtist::setChunkSize(unsigned int maxPoints)
+{
+  if(_chunkSize == maxPoints) return;
+  _chunkSize = maxPoints;
+
+  // Recompute chunks with the new size, if chunks are being used
+  if(_vertexEncoding == CHUNKED_RTC)
+  {
+    CurveArtistUpdateCallback *cb = static_cast<CurveArtistUpdateCallback*>(getUpdateCallback());
+    cb->dataCleared();
+  }
+}
+
+void CurveArtist::setChunkRadius(double radius)
+{
+  if(_chunkRadius == radius) return;
+  _chunkRadius = radius;
+
+  // Recompute chunks with the new radius, if chunks are being used
+  if(_vertexEncoding == CHUNKED_RTC)
+  {
+    CurveArtistUpdateCallback *cb = static_cast<CurveArtistUpdateCallback*>(getUpdateCallback());
+    cb->dataCleared();
+  }
+}
+
 void CurveArtist::dataCleared(const Trajectory* traj)
 {
 	verifyData();
@@ -20,13 +20,25 @@
 
 #include <OpenFrames/DepthPartitioner.hpp>
 #include <OpenFrames/Utilities.hpp>
+#include <osg/BlendFunc>
+#include <osg/ClipControl>
+#include <osg/Depth>
+#include <osg/Geometry>
+#include <osg/GLExtensions>
+#include <osg/Texture2D>
 #include <osgUtil/CullVisitor>
+#include <osgViewer/ViewerBase>
 #include <iostream>
 #include <iomanip>
 
+#ifndef GL_DEPTH_COMPONENT32F
+#define GL_DEPTH_COMPONENT32F 0x8CAC
+#endif
+
 // DepthPartitioner camera name components
 static const std::string dpCamNamePrefix("DPCam");
 static const std::string dpMainCamName(dpCamNamePrefix+"Main");
+static const std::string dpReversedZCamName(dpCamNamePrefix+"ReversedZ");
 
 namespace OpenFrames
 {
@@ -147,6 +159,24 @@ namespace OpenFrames
     setViewToPartition(NULL);
   }
   
+  /**********************************************/
+  /** Applies a clip-space depth range before/after a camera draws. Used instead of
+      a StateSet attribute so that nested render-to-texture cameras (e.g. shadow maps),
+      which are drawn before the camera's own scene, keep the default depth range. */
+  struct ClipControlCallback : public osg::Camera::DrawCallback
+  {
+    ClipControlCallback(osg::ClipControl::DepthMode mode)
+    : _clipControl(new osg::ClipControl(osg::ClipControl::LOWER_LEFT, mode))
+    {}
+    
+    virtual void operator()(osg::RenderInfo& renderInfo) const
+    {
+      _clipControl->apply(*renderInfo.getState());
+    }
+    
+    osg::ref_ptr<osg::ClipControl> _clipControl;
+  };
+  
   /**********************************************/
   /** Creates osg::Cameras and adds them as slaves to the main osg::View */
   struct BasicCameraManager : public DepthPartitionCallback::CameraManager
@@ -190,7 +220,7 @@ namespace OpenFrames
           newcam->setClearMask(GL_DEPTH_BUFFER_BIT);
         
         // Add Camera as slave, and tell it to use the master Camera's scene
-        mainCam->getView()->addSlave(newcam, true);
+        addSlave(mainCam, newcam, true);
         
         // Store new camera in internal camera list
         _cameraList[camNum] = newcam;
@@ -217,31 +247,197 @@ namespace OpenFrames
       }
     }
     
+    // Render the scene with one camera into a framebuffer object with a floating-point
+    // depth buffer, then blend the result over the background in the window
+    virtual bool enableReversedZCamera(osg::Camera* mainCam, const double &zNear)
+    {
+      // Clip control is needed for a [0,1] depth range, since the default [-1,1]
+      // range loses the precision of the floating-point depth buffer. Extensions are
+      // only available after the graphics context has been realized.
+      osg::GraphicsContext *gc = mainCam->getGraphicsContext();
+      osg::Viewport *vp = mainCam->getViewport();
+      if(!gc || !gc->getState() || !vp) return false;
+      const osg::GLExtensions *ext = osg::GLExtensions::Get(gc->getState()->getContextID(), false);
+      if(!ext || !ext->isClipControlSupported || !ext->isFrameBufferObjectSupported) return false;
+      
+      // Reversed-z only applies to perspective projections
+      osg::Matrixd projmat = mainCam->getProjectionMatrix();
+      if(!OpenFrames::makeReversedZProjection(projmat, zNear)) return false;
+      
+      if(!_reversedZCamera.valid()) createReversedZCameras(mainCam, ext);
+      
+      // Resize the scene texture and its framebuffer object with the viewport
+      int width = (int)vp->width();
+      int height = (int)vp->height();
+      if((width != _reversedZTexture->getTextureWidth()) ||
+         (height != _reversedZTexture->getTextureHeight()))
+      {
+        _reversedZTexture->setTextureSize(width, height);
+        _reversedZTexture->dirtyTextureObject();
+        _reversedZCamera->setViewport(0, 0, width, height);
+        _reversedZCamera->dirtyAttachmentMap();
+      }
+      
+      // Set camera rendering matrices
+      _reversedZCamera->setProjectionMatrix(projmat);
+      _reversedZCamera->setViewMatrix(mainCam->getViewMatrix());
+      
+      // Activate cameras
+      _reversedZCamera->setNodeMask(0xffffffff);
+      _compositeCamera->setNodeMask(0xffffffff);
+      return true;
+    }
+    
+    virtual void disableReversedZCamera()
+    {
+      if(_reversedZCamera.valid())
+      {
+        _reversedZCamera->setNodeMask(0x0);
+        _compositeCamera->setNodeMask(0x0);
+      }
+    }
+    
     // Detach all our cameras from the main scene, then erase the cameras
     virtual void reset()
     {
       for(int i = 0; i < _cameraList.size(); ++i)
       {
-        osg::View *view = _cameraList[i]->getView();
-        if(view)
-        {
-          unsigned int pos = view->findSlaveIndexForCamera(_cameraList[i]);
-          view->removeSlave(pos);
-        }
+        removeSlave(_cameraList[i]);
       }
       
       _cameraList.clear(); // Erase all cameras
+      
+      if(_reversedZCamera.valid())
+      {
+        removeSlave(_reversedZCamera);
+        removeSlave(_compositeCamera);
+        _reversedZCamera = NULL;
+        _compositeCamera = NULL;
+        _reversedZTexture = NULL;
+      }
+    }
+    
+    // Add a camera as a slave of the main camera's View. Multithreaded viewers only
+    // render cameras that existed when their threads started, so restart threads
+    // to include the new camera.
+    static void addSlave(osg::Camera* mainCam, osg::Camera* cam, bool useMastersSceneData)
+    {
+      osgViewer::View *view = dynamic_cast<osgViewer::View*>(mainCam->getView());
+      osgViewer::ViewerBase *viewer = view ? view->getViewerBase() : NULL;
+      bool restartThreads = viewer && viewer->areThreadsRunning();
+      if(restartThreads) viewer->stopThreading();
+      mainCam->getView()->addSlave(cam, useMastersSceneData);
+      if(restartThreads) viewer->startThreading();
+    }
+    
+    // Remove a camera from its View. Running viewer threads may be culling or
+    // drawing the camera, so stop them while it is removed.
+    static void removeSlave(osg::Camera* cam)
+    {
+      osg::View *view = cam->getView();
+      if(view)
+      {
+        osgViewer::View *viewerView = dynamic_cast<osgViewer::View*>(view);
+        osgViewer::ViewerBase *viewer = viewerView ? viewerView->getViewerBase() : NULL;
+        bool restartThreads = viewer && viewer->areThreadsRunning();
+        if(restartThreads) viewer->stopThreading();
+        unsigned int pos = view->findSlaveIndexForCamera(cam);
+        view->removeSlave(pos);
+        if(restartThreads) viewer->startThreading();
+      }
+    }
+    
+    // Create the reversed-z scene camera and the camera that composites its image
+    void createReversedZCameras(osg::Camera* mainCam, const osg::GLExtensions *ext)
+    {
+      osg::GraphicsContext *gc = mainCam->getGraphicsContext();
+      
+      // Match the window's antialiasing
+      int samples = gc->getTraits() ? gc->getTraits()->samples : 0;
+      if((samples > 0) && !ext->isRenderbufferMultisampleSupported()) samples = 0;
+      
+      // Scene color, rendered at the same size as the viewport. Size is set later.
+      _reversedZTexture = new osg::Texture2D;
+      _reversedZTexture->setInternalFormat(GL_RGBA8);
+      _reversedZTexture->setFilter(osg::Texture2D::MIN_FILTER, osg::Texture2D::NEAREST);
+      _reversedZTexture->setFilter(osg::Texture2D::MAG_FILTER, osg::Texture2D::NEAREST);
+      _reversedZTexture->setWrap(osg::Texture2D::WRAP_S, osg::Texture2D::CLAMP_TO_EDGE);
+      _reversedZTexture->setWrap(osg::Texture2D::WRAP_T, osg::Texture2D::CLAMP_TO_EDGE);
+      
+      // Scene camera, rendering to the texture with a 32-bit float depth buffer
+      _reversedZCamera = new osg::Camera();
+      _reversedZCamera->setCullingActive(false);
+      _reversedZCamera->setAllowEventFocus(false);
+      _reversedZCamera->setRenderOrder(osg::Camera::POST_RENDER, 0);
+      _reversedZCamera->setName(dpReversedZCamName);
+      _reversedZCamera->setGraphicsContext(gc);
+      _reversedZCamera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+      _reversedZCamera->setProjectionResizePolicy(osg::Camera::FIXED);
+      _reversedZCamera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
+      _reversedZCamera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+      _reversedZCamera->attach(osg::Camera::COLOR_BUFFER0, _reversedZTexture, 0, 0, false, samples, samples);
+      _reversedZCamera->attach(osg::Camera::DEPTH_BUFFER, GL_DEPTH_COMPONENT32F);
+      if(samples > 0) _reversedZCamera->setImplicitBufferAttachmentResolveMask(0); // Depth doesn't need resolving
+      
+      // Depth is 1 at the near plane and 0 at infinity, so clear to 0 and keep closer fragments.
+      // The background is drawn separately, so clear color to transparent.
+      _reversedZCamera->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      _reversedZCamera->setClearColor(osg::Vec4(0.0, 0.0, 0.0, 0.0));
+      _reversedZCamera->setClearDepth(0.0);
+      _reversedZCamera->setPreDrawCallback(new ClipControlCallback(osg::ClipControl::ZERO_TO_ONE));
+      _reversedZCamera->setPostDrawCallback(new ClipControlCallback(osg::ClipControl::NEGATIVE_ONE_TO_ONE));
+      // Objects that set their own depth function flip it with a ReversedZStateCallback.
+      osg::StateSet *ss = _reversedZCamera->getOrCreateStateSet();
+      ss->setAttribute(new osg::Depth(osg::Depth::GEQUAL));
+      
+      // By default accumulate alpha as coverage so the texture holds premultiplied
+      // colors that can be blended over the background. Objects with their own
+      // BlendFunc are expected to do the same (see setDepthMode).
+      ss->setAttribute(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+      addSlave(mainCam, _reversedZCamera, true);
+      
+      // Quad that blends the scene texture over the background
+      osg::Geometry* geom = osg::createTexturedQuadGeometry(osg::Vec3(), osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0));
+      osg::Geode *quad = new osg::Geode;
+      quad->addDrawable(geom);
+      osg::StateSet *quadSS = quad->getOrCreateStateSet();
+      quadSS->setTextureAttributeAndModes(0, _reversedZTexture, osg::StateAttribute::ON);
+      quadSS->setAttributeAndModes(new osg::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA), osg::StateAttribute::ON);
+      quadSS->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+      quadSS->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+      quadSS->setDataVariance(osg::Object::DYNAMIC); // Texture is resized with the viewport
+      
+      // Composite camera, drawing into the window after the scene camera
+      _compositeCamera = new osg::Camera();
+      _compositeCamera->setAllowEventFocus(false);
+      _compositeCamera->setRenderOrder(osg::Camera::POST_RENDER, 1);
+      _compositeCamera->setName(dpCamNamePrefix + "Composite");
+      _compositeCamera->setGraphicsContext(gc);
+      _compositeCamera->setViewport(mainCam->getViewport());
+      _compositeCamera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+      _compositeCamera->setProjectionResizePolicy(osg::Camera::FIXED);
+      _compositeCamera->setViewMatrix(osg::Matrix::identity());
+      _compositeCamera->setProjectionMatrix(osg::Matrix::ortho2D(0, 1, 0, 1));
+      _compositeCamera->setClearMask(0);
+      _compositeCamera->addChild(quad);
+      addSlave(mainCam, _compositeCamera, false);
     }
     
     // Cameras that should be used to draw the scene. These cameras
     // will be reused on every frame in order to save time.
     typedef std::vector< osg::ref_ptr<osg::Camera> > CameraList;
     CameraList _cameraList;
+    
+    // Reversed-z scene camera, its color texture, and the camera that
+    // draws the texture into the window
+    osg::ref_ptr<osg::Camera> _reversedZCamera;
+    osg::ref_ptr<osg::Texture2D> _reversedZTexture;
+    osg::ref_ptr<osg::Camera> _compositeCamera;
   };
   
   /**********************************************/
   DepthPartitionCallback::DepthPartitionCallback()
-  : _numActiveCameras(0)
+  : _numActiveCameras(0), _depthMode(PARTITIONED), _reversedZActive(false), _partitionTime(0.0)
   {
     _distAccumulator = new DistanceAccumulator;
     _cameraManager = new BasicCameraManager;
@@ -255,6 +451,7 @@ namespace OpenFrames
     _statsText->setLineSpacing(0.25);
     _statsText->setAlignment(osgText::Text::RIGHT_TOP);
     _statsText->setPosition(osg::Vec3(0.999, 0.999, 0.0));
+    _statsText->setDataVariance(osg::Object::DYNAMIC); // Text changes every frame
 
     _statsGeode = new osg::Geode;
     _statsGeode->addDrawable(_statsText);
@@ -274,12 +471,20 @@ namespace OpenFrames
       _cameraManager = cameraManager;
   }
   
+  /**********************************************/
+  bool DepthPartitionCallback::isReversedZCamera(const osg::Camera* cam)
+  {
+    return (cam != NULL) && (cam->getName() == dpReversedZCamName);
+  }
+  
   /**********************************************/
   void DepthPartitionCallback::updateSlave(osg::View& view, osg::View::Slave& slave)
   {
     // If the scene hasn't been defined then don't do anything
+    _partitionTime = 0.0;
     osgViewer::View *sceneView = dynamic_cast<osgViewer::View*>(&view);
     if(!sceneView || !sceneView->getSceneData()) return;
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
     
     // Capture the master camera's graphics context
     osg::Camera *masterCam = view.getCamera();
@@ -316,6 +521,20 @@ namespace OpenFrames
     dpMainSlaveCam->setViewMatrix(masterCam->getViewMatrix());
     slave.updateSlaveImplementation(view);
     
+    // Render the whole scene with a single reversed-z camera if possible. This doesn't
+    // need the near/far distances of scene objects, so the scene isn't traversed.
+    _reversedZActive = (_depthMode == REVERSED_Z) &&
+      _cameraManager->enableReversedZCamera(dpMainSlaveCam, _cameraManager->getMinZNear());
+    if(_reversedZActive)
+    {
+      _cameraManager->disableCameras(0);
+      _numActiveCameras = 0;
+      _statsText->setText("Reversed-Z near = " + std::to_string(_cameraManager->getMinZNear()) + ", far = inf\n");
+      _partitionTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+      return;
+    }
+    _cameraManager->disableReversedZCamera();
+    
     // Prepare for scene traversal
     _distAccumulator->setMatrices(dpMainSlaveCam->getViewMatrix(), dpMainSlaveCam->getProjectionMatrix());
     _distAccumulator->setNearFarRatio(dpMainSlaveCam->getNearFarRatio());
@@ -323,7 +542,7 @@ namespace OpenFrames
     _distAccumulator->reset();
     
     // Step 1: Traverse the scene, collecting near/far distances.
-    sceneView->getSceneData()->accept(*(_distAccumulator.get()));
+    _distAccumulator->traverseScene(*(sceneView->getSceneData()));
     
     // Step 2: Compute the near and far distances for each Camera that
     // should be used to render the scene
@@ -345,10 +564,27 @@ namespace OpenFrames
 
       statsStr += _cameraManager->getCameraName(i) + " near = " + std::to_string(camPairs[i].first) + ", far = " + std::to_string(camPairs[i].second) + "\n";
     }
+    if(_distAccumulator->getIncremental())
+    {
+      statsStr += "Reused subtrees = " + std::to_string(_distAccumulator->getNumReusedSubtrees()) +
+                  ", reused split = " + (_distAccumulator->getSplitReused() ? "yes" : "no") + "\n";
+    }
     _statsText->setText(statsStr);
     
     // Step 4: Disable remaining unused cameras
     _cameraManager->disableCameras(numCameras);
+
+    _partitionTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+  }
+  
+  /**********************************************/
+  void ReversedZStateCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+  {
+    osgUtil::CullVisitor *cv = dynamic_cast<osgUtil::CullVisitor*>(nv);
+    bool reversed = cv && DepthPartitionCallback::isReversedZCamera(cv->getCurrentCamera());
+    if(reversed) cv->pushStateSet(_stateSet.get());
+    traverse(node, nv);
+    if(reversed) cv->popStateSet();
   }
   
 } // OpenFrames namespace
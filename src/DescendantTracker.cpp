@@ -29,7 +29,7 @@ namespace OpenFrames
 {
 
 DescendantTracker::DescendantTracker() 
-	: _tracking(false)
+	: _tracking(false), _pathGeneration(0)
 { 
 #ifdef _OF_VERBOSE_
 	std::cout<< "DescendantTracker()" << std::endl;
@@ -37,7 +37,7 @@ DescendantTracker::DescendantTracker()
 }
 
 DescendantTracker::DescendantTracker( ReferenceFrame* frame )
-	: _tracking(false)
+	: _tracking(false), _pathGeneration(0)
 {
 #ifdef _OF_VERBOSE_
 	std::cout<< "DescendantTracker(";
@@ -172,6 +172,9 @@ bool DescendantTracker::_trackDescendant( ReferenceFrame* frame,
 /** Stop tracking all previously tracked frames */
 void DescendantTracker::_clearPath()
 {
+	  // Path is always rebuilt after being cleared
+	++_pathGeneration;
+
 	if( _framePath.empty() ) return;
 
 	FramePath::iterator i;
@@ -22,6 +22,8 @@
 #include <osg/Geode>
 #include <osg/Transform>
 #include <osg/Projection>
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
 #include <algorithm> // Needed for std::swap on Win32
 #include <climits>
 
@@ -48,15 +50,67 @@ namespace OpenFrames
              coord[2]*matrix(2,2) + matrix(3,2) );
   }
   
+  /** Maximum number of scene levels that are split into parallel tasks */
+  static const unsigned int maxSplitLevels = 8;
+  
+  /** Number of traversals that a subgraph can go unused before its cached bounds
+   are discarded, e.g. while it is outside the view */
+  static const unsigned int maxUnusedTraversals = 100;
+  
+  /** Worker thread that traverses subgraphs claimed from a DistanceAccumulator */
+  class DistanceAccumulator::TraversalThread : public OpenThreads::Thread
+  {
+  public:
+    TraversalThread(DistanceAccumulator *owner)
+    : _owner(owner), _accumulator(new DistanceAccumulator), _batchNum(owner->_batchNum)
+    {}
+    
+    virtual void run()
+    {
+      while(true)
+      {
+        // Wait for a new batch of tasks
+        {
+          OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_owner->_threadMutex);
+          while((_owner->_batchNum == _batchNum) && !_owner->_stopRequested)
+            _owner->_threadCond.wait(&_owner->_threadMutex);
+          if(_owner->_stopRequested) return;
+          _batchNum = _owner->_batchNum;
+        }
+        
+        _accumulator->beginTasks(*_owner);
+        _accumulator->runTasks(*_owner);
+        
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_owner->_threadMutex);
+        --(_owner->_numBusyThreads);
+        _owner->_threadCond.broadcast();
+      }
+    }
+    
+    DistanceAccumulator* getAccumulator() const { return _accumulator.get(); }
+    
+  protected:
+    DistanceAccumulator *_owner; // Not ref_ptr since owner owns this thread
+    osg::ref_ptr<DistanceAccumulator> _accumulator; // Results of this thread's tasks
+    unsigned int _batchNum; // Most recent batch of tasks started by this thread
+  };
+  
   DistanceAccumulator::DistanceAccumulator()
   : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN),
-  _nearFarRatio(0.0005), _maxDepth(UINT_MAX), _minZNear(1.0e-5)
+  _nearFarRatio(0.0005), _maxDepth(UINT_MAX), _minZNear(1.0e-5),
+  _incremental(false), _useCache(false), _splitTolerance(0.1), _cacheDirty(0),
+  _traversalNum(0), _numReusedSubtrees(0), _splitReused(false),
+  _numThreads(1), _owner(NULL), _newTasks(NULL), _splitDepth(0), _nextTask(0),
+  _batchNum(0), _numBusyThreads(0), _stopRequested(false)
   {
     setMatrices(osg::Matrix::identity(), osg::Matrix::identity());
     reset();
   }
   
-  DistanceAccumulator::~DistanceAccumulator() {}
+  DistanceAccumulator::~DistanceAccumulator()
+  {
+    stopThreads();
+  }
   
   void DistanceAccumulator::pushLocalFrustum()
   {
@@ -170,6 +224,8 @@ namespace OpenFrames
   
   void DistanceAccumulator::apply(osg::Node &node)
   {
+    if(deferToTask(node)) return;
+    
     if(shouldContinueTraversal(node))
     {
       // Traverse this node
@@ -181,6 +237,8 @@ namespace OpenFrames
   
   void DistanceAccumulator::apply(osg::Projection &proj)
   {
+    if(deferToTask(proj)) return;
+    
     if(shouldContinueTraversal(proj))
     {
       // Push the new projection matrix view frustum
@@ -200,6 +258,69 @@ namespace OpenFrames
   }
   
   void DistanceAccumulator::apply(osg::Transform &transform)
+  {
+    if(deferToTask(transform)) return;
+    
+    FrameTransform *xform = _useCache ? dynamic_cast<FrameTransform*>(&transform) : NULL;
+    if(xform) applyCached(*xform);
+    else traverseTransform(transform);
+  }
+  
+  void DistanceAccumulator::applyCached(FrameTransform &xform)
+  {
+    // Cached bounds are relative to the matrix above the subgraph, so they
+    // can't be used if the transform itself depends on the view
+    if((xform.getReferenceFrame() != osg::Transform::RELATIVE_RF) || xform.getFollowEye())
+    {
+      traverseTransform(xform);
+      return;
+    }
+    
+    // Nothing more to do if the subgraph is outside the view or fits in one camera
+    if(!shouldContinueTraversal(xform)) return;
+    
+    // Worker threads share the cache of the accumulator that owns their tasks
+    DistanceAccumulator &owner = _owner ? *_owner : *this;
+    osg::ref_ptr<SubtreeCache> cache;
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(owner._cacheMutex);
+      osg::ref_ptr<SubtreeCache> &entry = owner._subtreeCache[&xform];
+      if(!entry.valid()) entry = new SubtreeCache;
+      entry->_traversalNum = owner._traversalNum;
+      cache = entry;
+    }
+    
+    // Bring the subgraph's bounds up to date, which only traverses it if its
+    // structure changed, then compute distances for the current view
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(cache->_mutex);
+    unsigned int maxDepth = (_currentDepth < _maxDepth) ? (_maxDepth - _currentDepth) : 0;
+    if(!cache->_bounds->update(xform, getTraversalMask(), getNodeMaskOverride(), maxDepth))
+      ++_numReusedSubtrees;
+    
+    _boundsPairs.clear();
+    cache->_bounds->computeDistances(_viewMatrices.back(), _projectionMatrices.back(), _boundsPairs);
+    for(PairList::const_iterator i = _boundsPairs.begin(); i != _boundsPairs.end(); ++i)
+    {
+      pushDistancePair(i->first, i->second);
+    }
+    
+    // Traverse view-dependent subgraphs from the transforms above them
+    const BoundsArray::SubgraphList &subgraphs = cache->_bounds->getSubgraphs();
+    const unsigned int depth = _currentDepth;
+    for(BoundsArray::SubgraphList::const_iterator i = subgraphs.begin(); i != subgraphs.end(); ++i)
+    {
+      _viewMatrices.push_back(i->_worldMatrix*_viewMatrices.back());
+      pushLocalFrustum();
+      _currentDepth = depth + i->_depth;
+      i->_node->accept(*this);
+      _localFrusta.pop_back();
+      _bbCorners.pop_back();
+      _viewMatrices.pop_back();
+    }
+    _currentDepth = depth;
+  }
+  
+  void DistanceAccumulator::traverseTransform(osg::Transform &transform)
   {
     // ABSOLUTE_RF transform is the equivalent of resetting the
     // modelview matrix, so only check whether traversal is required
@@ -237,6 +358,8 @@ namespace OpenFrames
   
   void DistanceAccumulator::apply(osg::Geode &geode)
   {
+    if(deferToTask(geode)) return;
+    
     // Contained drawables will only be individually considered if we are
     // allowed to continue traversing.
     if(shouldContinueTraversal(geode))
@@ -275,8 +398,39 @@ namespace OpenFrames
     _projection = projection;
   }
   
+  void DistanceAccumulator::setIncremental(bool incremental)
+  {
+    _incremental = incremental;
+    if(!_incremental) dirtyCache();
+  }
+  
   void DistanceAccumulator::reset()
   {
+    bool cacheDirty = (_cacheDirty.exchange(0) != 0);
+    if(cacheDirty && _boundsArray.valid()) _boundsArray->dirty();
+    if(!_incremental || cacheDirty)
+    {
+      _subtreeCache.clear();
+    }
+    else
+    {
+      // Discard subgraphs that haven't been used recently, e.g. because they
+      // were removed from the scene
+      for(SubtreeCacheMap::iterator i = _subtreeCache.begin(); i != _subtreeCache.end();)
+      {
+        if(_traversalNum - i->second->_traversalNum > maxUnusedTraversals) _subtreeCache.erase(i++);
+        else ++i;
+      }
+    }
+    ++_traversalNum;
+    _useCache = _incremental;
+    _numReusedSubtrees = 0;
+    
+    // Keep previous camera split in case it can be reused
+    _prevCameraPairs.swap(_cameraPairs);
+    if(!_incremental || cacheDirty) _prevCameraPairs.clear();
+    _splitReused = false;
+    
     // Clear vectors & values
     _distancePairs.clear();
     _cameraPairs.clear();
@@ -303,6 +457,15 @@ namespace OpenFrames
     // Nothing in the scene, so no cameras needed
     if(_distancePairs.empty()) return;
     
+    // Keep previous cameras if possible, which avoids sorting distance
+    // pairs and keeps depth segments from changing every frame
+    if(_incremental && previousSplitCovers())
+    {
+      _cameraPairs = _prevCameraPairs;
+      _splitReused = true;
+      return;
+    }
+    
     // Entire scene can be handled by just one camera
     if(_limits.first >= _limits.second*_nearFarRatio)
     {
@@ -403,10 +566,260 @@ namespace OpenFrames
     }
   }
   
+  bool DistanceAccumulator::previousSplitCovers() const
+  {
+    if(_prevCameraPairs.empty()) return false;
+    
+    // Allow for roundoff in the computed camera near planes
+    const double eps = 1.0e-6;
+    
+    // Near/far limits must be within the previous split, and can't have
+    // shrunk by more than the tolerance since depth precision would be wasted
+    const double prevNear = _prevCameraPairs.back().first;
+    const double prevFar = _prevCameraPairs.front().second;
+    const double tol = 1.0 + _splitTolerance;
+    if((_limits.first < prevNear*(1.0 - eps)) || (_limits.first > prevNear*tol)) return false;
+    if((_limits.second > prevFar*(1.0 + eps)) || (_limits.second*tol < prevFar)) return false;
+    
+    // Combine adjacent cameras into contiguous depth ranges, since there
+    // may be gaps between separate parts of the scene
+    PairList ranges;
+    ranges.push_back(_prevCameraPairs.front());
+    for(PairList::const_iterator i = _prevCameraPairs.begin() + 1; i != _prevCameraPairs.end(); ++i)
+    {
+      if(i->second >= ranges.back().first*(1.0 - eps)) ranges.back().first = i->first;
+      else ranges.push_back(*i);
+    }
+    if(ranges.size() == 1) return true; // Limits check already covers all pairs
+    
+    // Each distance pair must be entirely within one depth range
+    PairList::const_iterator j;
+    for(PairList::const_iterator i = _distancePairs.begin(); i != _distancePairs.end(); ++i)
+    {
+      for(j = ranges.begin(); j != ranges.end(); ++j)
+      {
+        if((i->first >= j->first*(1.0 - eps)) && (i->second <= j->second*(1.0 + eps))) break;
+      }
+      if(j == ranges.end()) return false;
+    }
+    
+    return true;
+  }
+  
+  void DistanceAccumulator::setNumThreads(unsigned int numThreads)
+  {
+    if(numThreads == 0) numThreads = 1;
+    if(numThreads == _numThreads) return;
+    
+    // Threads are restarted by the next traversal
+    stopThreads();
+    _numThreads = numThreads;
+  }
+  
+  void DistanceAccumulator::setUseBoundsArray(bool use)
+  {
+    if(use == _boundsArray.valid()) return;
+    _boundsArray = use ? new BoundsArray : NULL;
+    dirtyCache();
+  }
+  
+  void DistanceAccumulator::traverseBoundsArray(osg::Node &scene)
+  {
+    _boundsArray->update(scene, getTraversalMask(), getNodeMaskOverride(), _maxDepth);
+    
+    // Test all leaf bounds at once
+    _boundsPairs.clear();
+    _boundsArray->computeDistances(_modelview, _projection, _boundsPairs);
+    for(PairList::const_iterator i = _boundsPairs.begin(); i != _boundsPairs.end(); ++i)
+    {
+      pushDistancePair(i->first, i->second);
+    }
+    
+    // Traverse view-dependent subgraphs from the transforms above them
+    const BoundsArray::SubgraphList &subgraphs = _boundsArray->getSubgraphs();
+    TraversalTask task;
+    task._projectionMatrix = _projection;
+    for(BoundsArray::SubgraphList::const_iterator i = subgraphs.begin(); i != subgraphs.end(); ++i)
+    {
+      task._node = i->_node.get();
+      task._viewMatrix = i->_worldMatrix*_modelview;
+      task._depth = i->_depth;
+      runTask(task);
+    }
+  }
+  
+  void DistanceAccumulator::traverseScene(osg::Node &scene)
+  {
+    if(_boundsArray.valid())
+    {
+      traverseBoundsArray(scene);
+      return;
+    }
+    
+    if(_numThreads <= 1)
+    {
+      scene.accept(*this);
+      return;
+    }
+    
+    // Bounds are computed when first requested, which isn't thread safe.
+    // So compute all bounds now, leaving threads to only read them.
+    scene.getBound();
+    
+    // Traverse the top of the scene, collecting subgraphs below it as tasks
+    splitScene(scene);
+    if(_tasks.empty()) return;
+    
+    // Traverse tasks in worker threads and in this thread
+    if(_threads.empty()) startThreads();
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadMutex);
+      _nextTask.exchange(0);
+      _numBusyThreads = _threads.size();
+      ++_batchNum;
+      _threadCond.broadcast();
+    }
+    runTasks(*this);
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadMutex);
+      while(_numBusyThreads > 0) _threadCond.wait(&_threadMutex);
+    }
+    
+    // Merge results from worker threads
+    for(unsigned int i = 0; i < _threads.size(); ++i)
+    {
+      DistanceAccumulator *worker = _threads[i]->getAccumulator();
+      _distancePairs.insert(_distancePairs.end(), worker->_distancePairs.begin(), worker->_distancePairs.end());
+      if(worker->_limits.first < _limits.first) _limits.first = worker->_limits.first;
+      if(worker->_limits.second > _limits.second) _limits.second = worker->_limits.second;
+      _numReusedSubtrees += worker->_numReusedSubtrees;
+    }
+    _tasks.clear();
+  }
+  
+  void DistanceAccumulator::splitScene(osg::Node &scene)
+  {
+    // Cached subgraph results would be missing children that were deferred to tasks
+    bool useCache = _useCache;
+    _useCache = false;
+    
+    // Expand tasks one scene level at a time, so that there are enough
+    // tasks to keep all threads busy even if some tasks are small
+    TaskList tasks, newTasks;
+    TraversalTask root;
+    root._node = &scene;
+    root._viewMatrix = _modelview;
+    root._projectionMatrix = _projection;
+    root._depth = 0;
+    tasks.push_back(root);
+    
+    _newTasks = &newTasks;
+    for(unsigned int level = 0; (level < maxSplitLevels) && (tasks.size() < 4*_numThreads); ++level)
+    {
+      // Traverse each task down to its children, which become new tasks
+      newTasks.clear();
+      for(TaskList::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
+      {
+        _splitDepth = i->_depth + 1;
+        runTask(*i);
+      }
+      tasks.swap(newTasks);
+      if(tasks.empty()) break; // Entire scene was traversed
+    }
+    _newTasks = NULL;
+    
+    _useCache = useCache;
+    _tasks.swap(tasks);
+  }
+  
+  bool DistanceAccumulator::deferToTask(osg::Node &node)
+  {
+    if(!_newTasks || (_currentDepth != _splitDepth)) return false;
+    
+    TraversalTask task;
+    task._node = &node;
+    task._viewMatrix = _viewMatrices.back();
+    task._projectionMatrix = _projectionMatrices.back();
+    task._depth = _currentDepth;
+    _newTasks->push_back(task);
+    return true;
+  }
+  
+  void DistanceAccumulator::runTask(const TraversalTask &task)
+  {
+    // Restore the state above the task's subgraph
+    _viewMatrices.clear();
+    _viewMatrices.push_back(task._viewMatrix);
+    _projectionMatrices.clear();
+    _projectionMatrices.push_back(task._projectionMatrix);
+    _localFrusta.clear();
+    _bbCorners.clear();
+    pushLocalFrustum();
+    _currentDepth = task._depth;
+    
+    task._node->accept(*this);
+  }
+  
+  void DistanceAccumulator::runTasks(DistanceAccumulator &owner)
+  {
+    // Claim tasks until none are left, so that threads with small
+    // tasks take over the remaining tasks from busier threads
+    unsigned int index;
+    while((index = (++owner._nextTask) - 1) < owner._tasks.size())
+    {
+      runTask(owner._tasks[index]);
+    }
+  }
+  
+  void DistanceAccumulator::beginTasks(DistanceAccumulator &owner)
+  {
+    // Use the owner's settings without invalidating anything
+    _owner = &owner;
+    _nearFarRatio = owner._nearFarRatio;
+    _minZNear = owner._minZNear;
+    _maxDepth = owner._maxDepth;
+    _useCache = owner._useCache;
+    setTraversalMask(owner.getTraversalMask());
+    setNodeMaskOverride(owner.getNodeMaskOverride());
+    
+    _distancePairs.clear();
+    _limits.first = DBL_MAX;
+    _limits.second = 0.0;
+    _numReusedSubtrees = 0;
+  }
+  
+  void DistanceAccumulator::startThreads()
+  {
+    for(unsigned int i = 1; i < _numThreads; ++i)
+    {
+      TraversalThread *thread = new TraversalThread(this);
+      thread->start();
+      _threads.push_back(thread);
+    }
+  }
+  
+  void DistanceAccumulator::stopThreads()
+  {
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadMutex);
+      _stopRequested = true;
+      _threadCond.broadcast();
+    }
+    
+    for(unsigned int i = 0; i < _threads.size(); ++i)
+    {
+      _threads[i]->join();
+      delete _threads[i];
+    }
+    _threads.clear();
+    _stopRequested = false;
+  }
+  
   void DistanceAccumulator::setNearFarRatio(double ratio)
   {
-    if(ratio <= 0.0 || ratio >= 1.0) return;
+    if(ratio <= 0.0 || ratio >= 1.0 || ratio == _nearFarRatio) return;
     _nearFarRatio = ratio;
+    dirtyCache();
   }
   
 } // !namespace OpenFrames
@@ -0,0 +1,87 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file DoubleSingleUtils.cpp
+ * Definitions of DoubleSingleUtils utility functions.
+ */
+
+#include <OpenFrames/DoubleSingleUtils.hpp>
+
+// Use the widest SIMD instructions enabled for the compiler's target
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OF_DS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define OF_DS_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OF_DS_NEON
+#endif
+
+namespace OpenFrames
+{
+
+  void DS_Split(const double *values, unsigned int numValues, float *high, float *low)
+  {
+    unsigned int i = 0;
+
+    // Split 4 values at a time. Conversions round to nearest like the
+    // scalar version, so results are identical.
+#if defined(OF_DS_AVX)
+    for(; i + 4 <= numValues; i += 4)
+    {
+      __m256d v = _mm256_loadu_pd(values + i);
+      __m128 h = _mm256_cvtpd_ps(v);
+      __m128 l = _mm256_cvtpd_ps(_mm256_sub_pd(v, _mm256_cvtps_pd(h)));
+      _mm_storeu_ps(high + i, h);
+      _mm_storeu_ps(low + i, l);
+    }
+#elif defined(OF_DS_SSE2)
+    for(; i + 4 <= numValues; i += 4)
+    {
+      __m128d v0 = _mm_loadu_pd(values + i);
+      __m128d v1 = _mm_loadu_pd(values + i + 2);
+      __m128 h0 = _mm_cvtpd_ps(v0); // 2 floats in lower half
+      __m128 h1 = _mm_cvtpd_ps(v1);
+      __m128 l0 = _mm_cvtpd_ps(_mm_sub_pd(v0, _mm_cvtps_pd(h0)));
+      __m128 l1 = _mm_cvtpd_ps(_mm_sub_pd(v1, _mm_cvtps_pd(h1)));
+      _mm_storeu_ps(high + i, _mm_movelh_ps(h0, h1));
+      _mm_storeu_ps(low + i, _mm_movelh_ps(l0, l1));
+    }
+#elif defined(OF_DS_NEON)
+    for(; i + 4 <= numValues; i += 4)
+    {
+      float64x2_t v0 = vld1q_f64(values + i);
+      float64x2_t v1 = vld1q_f64(values + i + 2);
+      float32x2_t h0 = vcvt_f32_f64(v0);
+      float32x2_t h1 = vcvt_f32_f64(v1);
+      float32x2_t l0 = vcvt_f32_f64(vsubq_f64(v0, vcvt_f64_f32(h0)));
+      float32x2_t l1 = vcvt_f32_f64(vsubq_f64(v1, vcvt_f64_f32(h1)));
+      vst1q_f32(high + i, vcombine_f32(h0, h1));
+      vst1q_f32(low + i, vcombine_f32(l0, l1));
+    }
+#endif
+
+    // Split remaining values
+    for(; i < numValues; ++i)
+    {
+      high[i] = (float)values[i];
+      low[i] = (float)(values[i] - (double)high[i]);
+    }
+  }
+
+}
@@ -20,7 +20,10 @@
 
 #include <OpenFrames/DrawableTrajectory.hpp>
 #include <OpenFrames/DoubleSingleUtils.hpp>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
 #include <osgUtil/CullVisitor>
+#include <map>
 #include <sstream>
 
 #ifdef _OF_VERBOSE_
@@ -39,19 +42,22 @@ namespace OpenFrames
  * jittering associated with very large OpenGL vertex
  * positions.
  * Ref: Cozzi & Ring, "3D Engine Design for Virtual Globes".
+ *
+ * Each camera gets its own uniforms, since cameras may be culled in
+ * parallel, or drawn after other cameras have been culled.
  */
 class UniformCallback : public osg::NodeCallback
 {
 public:
-  UniformCallback(osg::Uniform &mvmat, osg::Uniform &eyeHigh, osg::Uniform &eyeLow)
-    : _mvmat(mvmat), _eyeHigh(eyeHigh), _eyeLow(eyeLow)
-  {}
+  UniformCallback() {}
 
   virtual void operator()(osg::Node *node, osg::NodeVisitor *nv)
   {
     osgUtil::CullVisitor *cv = dynamic_cast<osgUtil::CullVisitor*>(nv);
     if (cv)
     {
+      CameraUniforms &cu = getCameraUniforms(cv->getCurrentCamera());
+
       // Get ModelView matrix
       osg::Matrixd mvmat = *(cv->getModelViewMatrix());
 
@@ -70,16 +76,50 @@ public:
       mvmat.setTrans(0.0, 0.0, 0.0);
 
       // Apply new ModelView matrix and eye point shader Uniforms
-      _mvmat.set(mvmat);
-      _eyeHigh.set(eyeHigh);
-      _eyeLow.set(eyeLow);
-    }
+      cu._mvmat->set(mvmat);
+      cu._eyeHigh->set(eyeHigh);
+      cu._eyeLow->set(eyeLow);
 
-    traverse(node, nv);
+      cv->pushStateSet(cu._stateSet.get());
+      traverse(node, nv);
+      cv->popStateSet();
+    }
+    else traverse(node, nv);
   }
 
 private:
-  osg::Uniform &_mvmat, &_eyeHigh, &_eyeLow;
+  struct CameraUniforms
+  {
+    osg::ref_ptr<osg::StateSet> _stateSet;
+    osg::ref_ptr<osg::Uniform> _mvmat, _eyeHigh, _eyeLow;
+  };
+
+  // Get the uniforms used by the given camera, creating them if needed
+  CameraUniforms& getCameraUniforms(const osg::Camera *camera)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cameraMutex);
+    CameraUniforms &cu = _cameraUniforms[camera];
+    if (!cu._stateSet.valid())
+    {
+      cu._mvmat = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "of_RTEModelViewMatrix");
+      cu._eyeHigh = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "of_ModelViewEyeHigh");
+      cu._eyeLow = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "of_ModelViewEyeLow");
+      cu._mvmat->setDataVariance(osg::Object::DYNAMIC);
+      cu._eyeHigh->setDataVariance(osg::Object::DYNAMIC);
+      cu._eyeLow->setDataVariance(osg::Object::DYNAMIC);
+
+      cu._stateSet = new osg::StateSet;
+      cu._stateSet->setDataVariance(osg::Object::DYNAMIC);
+      cu._stateSet->addUniform(cu._mvmat.get());
+      cu._stateSet->addUniform(cu._eyeHigh.get());
+      cu._stateSet->addUniform(cu._eyeLow.get());
+    }
+    return cu;
+  }
+
+  typedef std::map<const osg::Camera*, CameraUniforms> CameraUniformsMap;
+  CameraUniformsMap _cameraUniforms;
+  OpenThreads::Mutex _cameraMutex; // Cameras may be culled in parallel
 };
 
 DrawableTrajectory::DrawableTrajectory( const std::string &name ) 
@@ -132,16 +172,7 @@ void DrawableTrajectory::_init()
   _xform->addChild(_artists.get());
 
   // Set shader properties for GPU rendering relative to eye
-  osg::Uniform *mvmat = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "of_RTEModelViewMatrix");
-  osg::Uniform *eyeHigh = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "of_ModelViewEyeHigh");
-  osg::Uniform *eyeLow = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "of_ModelViewEyeLow");
-  mvmat->setDataVariance(osg::Object::DYNAMIC);
-  eyeHigh->setDataVariance(osg::Object::DYNAMIC);
-  eyeLow->setDataVariance(osg::Object::DYNAMIC);
-  stateset->addUniform(mvmat);
-  stateset->addUniform(eyeHigh);
-  stateset->addUniform(eyeLow);
-  _artists->setCullCallback(new UniformCallback(*mvmat, *eyeHigh, *eyeLow));
+  _artists->setCullCallback(new UniformCallback());
 }
 
 void DrawableTrajectory::addArtist(TrajectoryArtist *artist)
@@ -252,6 +252,11 @@ namespace OpenFrames
       
       osg::StateSet* stateset = _cameraPenumbra->getOrCreateStateSet();
       
+      // Use the standard depth test, even if the main camera reverses it
+      osg::ref_ptr<osg::Depth> depth = new osg::Depth;
+      depth->setFunction(osg::Depth::LESS);
+      stateset->setAttribute(depth.get(), osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+      
       // cull front faces so that only backfaces contribute to depth map
       osg::ref_ptr<osg::CullFace> cull_face = new osg::CullFace;
       cull_face->setMode(osg::CullFace::FRONT);
@@ -0,0 +1,438 @@
+/***********************************
+   Copyright 2019 Ravishankar Mathur
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+***********************************/
+
+/** \file FollowerGroup.cpp
+ * FollowerGroup-class function definitions.
+ */
+
+#include <OpenFrames/FollowerGroup.hpp>
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+#include <osg/NodeVisitor>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace OpenFrames
+{
+
+/** Find the time index using the previously found index as a hint. Followed
+    times usually advance by at most one point per frame, so the hint avoids
+    a full search in most cases. Return values are the same as for
+    Trajectory::getTimeIndex(). */
+static int getTimeIndexWithHint(const Trajectory *traj, const Trajectory::DataArray &times, double t, int &index)
+{
+  const int numTimes = times.size();
+  const int hint = index;
+
+  // Hint is only used for increasing times strictly inside the trajectory, since
+  // getTimeIndex() reports times at the first point as being at the bounds
+  if((numTimes >= 2) && (times[0] < times.back()) && (hint >= 0) && (hint < numTimes-1) &&
+     (t > times[0]))
+  {
+    // Requested time is in the same interval as before
+    if((times[hint] <= t) && (t < times[hint+1])) return 1;
+
+    // Requested time is in the next interval
+    if((hint+2 < numTimes) && (times[hint+1] <= t) && (t < times[hint+2]))
+    {
+      index = hint+1;
+      return 1;
+    }
+  }
+
+  // Otherwise do a full search
+  return traj->getTimeIndex(t, index);
+}
+
+/** Compute the two point indices and the fraction between them used to
+    interpolate data at the given time. Behaves the same way as
+    TrajectoryFollower for out-of-range times. */
+static void getInterpolationPoints(const Trajectory::DataArray &times, unsigned int numPoints,
+                                   int val, int index, double t,
+                                   unsigned int &i0, unsigned int &i1, double &frac)
+{
+  frac = 0.0;
+
+  // Time out of range, so use first or last point
+  if(val == -1)
+  {
+    i0 = i1 = (index < 0) ? 0 : numPoints-1;
+  }
+
+  // Time index beyond available points, so use last point
+  else if(index >= (int)numPoints)
+  {
+    i0 = i1 = numPoints-1;
+  }
+
+  // Interpolate if the two times are not equal
+  else
+  {
+    i0 = i1 = index;
+    if((index+1 < (int)numPoints) && (times[index] != times[index+1]))
+    {
+      i1 = index+1;
+      frac = (t - times[index])/(times[index+1] - times[index]);
+    }
+  }
+}
+
+/*******************************************************/
+class FollowerGroup::WorkerThread : public OpenThreads::Thread
+{
+public:
+  WorkerThread(FollowerGroup *group, unsigned int threadNum)
+    : _group(group), _threadNum(threadNum)
+  {}
+
+  /** Inherited from OpenThreads::Thread. Called on thread launch. */
+  virtual void run()
+  {
+    unsigned int begin, end;
+    while(true)
+    {
+      // Wait for the update thread to request new states
+      _group->_startBarrier.block(_group->getNumThreads());
+      if(_group->_stopRequested) break;
+
+      // Compute states for this thread's followers
+      _group->_getThreadRange(_threadNum, begin, end);
+      _group->_computeStates(begin, end);
+
+      // Tell the update thread that states are computed
+      _group->_endBarrier.block(_group->getNumThreads());
+    }
+  }
+
+private:
+  FollowerGroup *_group;
+  unsigned int _threadNum;
+};
+
+/*******************************************************/
+FollowerGroup::FollowerGroup()
+  : _needsUpdate(true),
+    _lastSimTime(0.0),
+    _currTime(0.0),
+    _numThreads(1),
+    _stopRequested(false)
+{
+  setOffsetTime(0.0);
+}
+
+FollowerGroup::~FollowerGroup()
+{
+  _stopWorkers();
+  removeAllFollowers();
+}
+
+void FollowerGroup::addFollower(FrameTransform *xform, Trajectory *traj, unsigned int data, TrajectoryFollower::FollowMode mode)
+{
+  if((xform == NULL) || (traj == NULL)) return; // Error check
+
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+  // Replace trajectory and follow type if transform is already being updated
+  FollowerIndexMap::iterator it = _followerIndices.find(xform);
+  if(it != _followerIndices.end())
+  {
+    unsigned int i = it->second;
+    if(_trajs[i] != traj)
+    {
+      _refTrajectory(traj);
+      _unrefTrajectory(_trajs[i].get());
+      _trajs[i] = traj;
+      _timeIndices[i] = -1;
+    }
+    _followData[i] = data;
+    _followModes[i] = mode;
+  }
+
+  // Otherwise append a new follower
+  else
+  {
+    _followerIndices[xform] = _xforms.size();
+    _xforms.push_back(xform);
+    _trajs.push_back(traj);
+    _followData.push_back(data);
+    _followModes.push_back(mode);
+    _timeIndices.push_back(-1);
+    _positions.push_back(osg::Vec3d());
+    _attitudes.push_back(osg::Quat());
+    _computedData.push_back(0);
+    _refTrajectory(traj);
+  }
+
+  _needsUpdate = true;
+}
+
+void FollowerGroup::removeFollower(FrameTransform *xform)
+{
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+  FollowerIndexMap::iterator it = _followerIndices.find(xform);
+  if(it == _followerIndices.end()) return;
+
+  // Move last follower into the removed follower's place so that
+  // all arrays remain contiguous
+  unsigned int i = it->second;
+  unsigned int last = _xforms.size() - 1;
+  _followerIndices.erase(it);
+  _unrefTrajectory(_trajs[i].get());
+  if(i != last)
+  {
+    _xforms[i] = _xforms[last];
+    _trajs[i] = _trajs[last];
+    _followData[i] = _followData[last];
+    _followModes[i] = _followModes[last];
+    _timeIndices[i] = _timeIndices[last];
+    _positions[i] = _positions[last];
+    _attitudes[i] = _attitudes[last];
+    _computedData[i] = _computedData[last];
+    _followerIndices[_xforms[i].get()] = i;
+  }
+
+  _xforms.pop_back();
+  _trajs.pop_back();
+  _followData.pop_back();
+  _followModes.pop_back();
+  _timeIndices.pop_back();
+  _positions.pop_back();
+  _attitudes.pop_back();
+  _computedData.pop_back();
+}
+
+void FollowerGroup::removeAllFollowers()
+{
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+  // Unsubscribe from all followed trajectories
+  for(TrajRefCountMap::iterator i = _trajRefCounts.begin(); i != _trajRefCounts.end(); ++i)
+  {
+    i->first->removeSubscriber(this);
+  }
+  _trajRefCounts.clear();
+
+  _followerIndices.clear();
+  _xforms.clear();
+  _trajs.clear();
+  _followData.clear();
+  _followModes.clear();
+  _timeIndices.clear();
+  _positions.clear();
+  _attitudes.clear();
+  _computedData.clear();
+}
+
+void FollowerGroup::setTime(double time)
+{
+  _timeVal = time;
+  _followTime = false;
+  _needsUpdate = true;
+}
+
+void FollowerGroup::setOffsetTime(double offsetTime)
+{
+  _timeVal = offsetTime;
+  _followTime = true;
+  _needsUpdate = true;
+}
+
+void FollowerGroup::setNumThreads(unsigned int numThreads)
+{
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+  if(numThreads == 0) numThreads = 1;
+  if(numThreads == getNumThreads()) return;
+
+  // Restart worker threads, the update thread is counted as thread 0
+  _stopWorkers();
+  _numThreads = numThreads;
+  for(unsigned int i = 1; i < numThreads; ++i)
+  {
+    WorkerThread *worker = new WorkerThread(this, i);
+    _workers.push_back(worker);
+    worker->start();
+  }
+}
+
+void FollowerGroup::_stopWorkers()
+{
+  if(_workers.empty()) return;
+
+  // Release workers waiting at the start barrier and tell them to exit
+  _stopRequested = true;
+  _startBarrier.block(getNumThreads());
+  for(unsigned int i = 0; i < _workers.size(); ++i)
+  {
+    _workers[i]->join();
+    delete _workers[i];
+  }
+  _workers.clear();
+  _numThreads = 1;
+  _stopRequested = false;
+}
+
+bool FollowerGroup::run(osg::Object* object, osg::Object* data)
+{
+  osg::NodeVisitor *nv = data ? data->asNodeVisitor() : 0;
+  double simTime = 0.0;
+  if(nv) simTime = nv->getFrameStamp()->getSimulationTime();
+
+  // Make sure time has changed
+  if((_lastSimTime != simTime) || _needsUpdate)
+  {
+    _lastSimTime = simTime; // Save the current simulation time
+    _needsUpdate = false; // Reset update flag
+
+    // Don't allow followers to be modified
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    if(!_xforms.empty())
+    {
+      // Get current time, either constant-time or offset-simulation-time
+      if(_followTime) _currTime = _lastSimTime + _timeVal;
+      else _currTime = _timeVal;
+
+      // Compute new states, with the update thread acting as thread 0
+      unsigned int begin, end;
+      _getThreadRange(0, begin, end);
+      if(_workers.empty()) _computeStates(begin, end);
+      else
+      {
+        _startBarrier.block(getNumThreads());
+        _computeStates(begin, end);
+        _endBarrier.block(getNumThreads());
+      }
+
+      // Apply new states to the followed transforms. This is done in the
+      // update thread since transforms may share parents whose bounds
+      // are dirtied by the new states.
+      const unsigned int numFollowers = _xforms.size();
+      for(unsigned int i = 0; i < numFollowers; ++i)
+      {
+        if(_computedData[i] & TrajectoryFollower::POSITION)
+          _xforms[i]->setPosition(_positions[i]);
+        if(_computedData[i] & TrajectoryFollower::ATTITUDE)
+          _xforms[i]->setAttitude(_attitudes[i]);
+      }
+    }
+  }
+
+  // Call nested callbacks and traverse rest of scene graph
+  return osg::Callback::traverse(object, data);
+}
+
+void FollowerGroup::_getThreadRange(unsigned int threadNum, unsigned int &begin, unsigned int &end) const
+{
+  // Split followers into contiguous blocks of nearly equal size
+  const unsigned int numFollowers = _xforms.size();
+  const unsigned int numThreads = getNumThreads();
+  begin = (unsigned long long)numFollowers*threadNum/numThreads;
+  end = (unsigned long long)numFollowers*(threadNum+1)/numThreads;
+}
+
+void FollowerGroup::_computeStates(unsigned int begin, unsigned int end)
+{
+  unsigned int i0, i1;
+  double frac;
+  osg::Vec3d v1, v2;
+  osg::Quat a1, a2;
+
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    _computedData[i] = 0;
+    const Trajectory *traj = _trajs[i].get();
+
+    // Prevent trajectory from being modified while reading it
+    traj->lockData();
+
+    const Trajectory::DataArray &times = traj->getTimeList();
+    if(!times.empty())
+    {
+      double t = _currTime;
+
+      // LOOP mode: wrap time to the trajectory's time range
+      if(_followModes[i] == TrajectoryFollower::LOOP)
+      {
+        double t0 = std::min(times.front(), times.back());
+        double tf = std::max(times.front(), times.back());
+        if(tf - t0 <= 8.0*DBL_MIN) t = t0;
+        else t = t - std::floor((t - t0)/(tf - t0))*(tf - t0);
+      }
+
+      // Find requested time in the trajectory
+      int index = _timeIndices[i];
+      int val = getTimeIndexWithHint(traj, times, t, index);
+      if(val != -2) _timeIndices[i] = index;
+
+      // Interpolate position
+      const unsigned int numPos = std::min(traj->getNumTimes(), traj->getNumPos());
+      if((val != -2) && (_followData[i] & TrajectoryFollower::POSITION) && (numPos > 0))
+      {
+        getInterpolationPoints(times, numPos, val, index, t, i0, i1, frac);
+        traj->getPosition(i0, v1[0], v1[1], v1[2]);
+        if(i1 != i0)
+        {
+          traj->getPosition(i1, v2[0], v2[1], v2[2]);
+          v1 += (v2 - v1)*frac; // Linear interpolation for position
+        }
+        _positions[i] = v1;
+        _computedData[i] |= TrajectoryFollower::POSITION;
+      }
+
+      // Interpolate attitude
+      const unsigned int numAtt = traj->getNumAtt();
+      if((val != -2) && (_followData[i] & TrajectoryFollower::ATTITUDE) && (numAtt > 0))
+      {
+        getInterpolationPoints(times, numAtt, val, index, t, i0, i1, frac);
+        traj->getAttitude(i0, a1[0], a1[1], a1[2], a1[3]);
+        if(i1 != i0)
+        {
+          traj->getAttitude(i1, a2[0], a2[1], a2[2], a2[3]);
+          a1.slerp(frac, a1, a2); // Spherical interpolation for attitude
+        }
+        _attitudes[i] = a1;
+        _computedData[i] |= TrajectoryFollower::ATTITUDE;
+      }
+    }
+
+    traj->unlockData();
+  }
+}
+
+void FollowerGroup::_refTrajectory(Trajectory *traj)
+{
+  // Subscribe to trajectory when it is used by its first follower
+  unsigned int &count = _trajRefCounts[traj];
+  if(count == 0) traj->addSubscriber(this);
+  ++count;
+}
+
+void FollowerGroup::_unrefTrajectory(Trajectory *traj)
+{
+  // Unsubscribe from trajectory when it is no longer used by any followers
+  TrajRefCountMap::iterator it = _trajRefCounts.find(traj);
+  if(it == _trajRefCounts.end()) return;
+  if(--(it->second) == 0)
+  {
+    traj->removeSubscriber(this);
+    _trajRefCounts.erase(it);
+  }
+}
+
+} // !namespace OpenFrames
@@ -0,0 +1,526 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file FrameCapture.cpp
+ * FrameCapture-class function definitions.
+ */
+
+#include <OpenFrames/FrameCapture.hpp>
+#include <OpenThreads/ScopedLock>
+#include <osg/BufferObject>
+#include <osgDB/WriteFile>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define OF_PIPE_MODE "wb"
+#else
+#define OF_PIPE_MODE "w"
+#endif
+
+namespace OpenFrames
+{
+  /*******************************************************/
+  class FrameCapture::EncoderThread : public OpenThreads::Thread
+  {
+  public:
+    EncoderThread(FrameCapture *capture) : _capture(capture) {}
+
+    virtual void run() { _capture->_encodeFrames(); }
+
+  protected:
+    FrameCapture *_capture; // Not ref_ptr since FrameCapture owns this thread
+  };
+
+  /*******************************************************/
+  FrameCapture::ImageFileEncoder::ImageFileEncoder(const std::string &fname, const std::string &fext)
+  : _fname(fname), _fext(fext)
+  { }
+
+  /*******************************************************/
+  bool FrameCapture::ImageFileEncoder::encode(const osg::Image &image, unsigned int frameNum)
+  {
+    char num[16];
+    std::snprintf(num, sizeof(num), "%06u", frameNum);
+    std::string filename = _fname + "_" + num + "." + _fext;
+
+    if(_fext == "raw")
+    {
+      std::ofstream file(filename.c_str(), std::ios::binary);
+      file.write((const char*)image.data(), image.getTotalSizeInBytes());
+      if(!file)
+      {
+        std::cerr<< "OpenFrames::FrameCapture ERROR: Could not write " << filename << std::endl;
+        return false;
+      }
+      return true;
+    }
+    else if(!osgDB::writeImageFile(image, filename))
+    {
+      std::cerr<< "OpenFrames::FrameCapture ERROR: Could not write " << filename << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+
+  /*******************************************************/
+  FrameCapture::PipeEncoder::PipeEncoder(const std::string &command)
+  : _command(command), _pipe(NULL)
+  { }
+
+  /*******************************************************/
+  FrameCapture::PipeEncoder::~PipeEncoder()
+  {
+    finish();
+  }
+
+  /*******************************************************/
+  void FrameCapture::PipeEncoder::finish()
+  {
+    // Waits for the process to exit, e.g. for a video encoder to write its file
+    if(_pipe) pclose(_pipe);
+    _pipe = NULL;
+  }
+
+  /*******************************************************/
+  bool FrameCapture::PipeEncoder::encode(const osg::Image &image, unsigned int frameNum)
+  {
+    // Start the process when the first frame arrives
+    if(_pipe == NULL)
+    {
+      _pipe = popen(_command.c_str(), OF_PIPE_MODE);
+      if(_pipe == NULL)
+      {
+        std::cerr<< "OpenFrames::FrameCapture ERROR: Could not run " << _command << std::endl;
+        return false;
+      }
+    }
+
+    // Write rows from top to bottom, the order expected by most encoders
+    const unsigned int rowSize = image.getRowSizeInBytes();
+    for(int row = image.t() - 1; row >= 0; --row)
+    {
+      if(std::fwrite(image.data(0, row), 1, rowSize, _pipe) != rowSize)
+      {
+        std::cerr<< "OpenFrames::FrameCapture ERROR: Could not write frame " << frameNum << " to " << _command << std::endl;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /*******************************************************/
+  FrameCapture::FrameCapture()
+  : _numPBOs(3), _numThreads(2), _capturing(false), _numFramesLeft(-1),
+    _finishPending(false), _frameNum(0), _width(0), _height(0),
+    _numPending(0), _nextPBO(0), _maxQueuedFrames(8), _dropFrames(true),
+    _numBusy(0), _stopRequested(false),
+    _numCaptured(0), _numEncoded(0), _numFailed(0), _numDropped(0)
+  { }
+
+  /*******************************************************/
+  FrameCapture::~FrameCapture()
+  {
+    _stopThreads();
+
+    if(!_pbos.empty())
+    {
+      std::cerr<< "OpenFrames::FrameCapture WARNING: PBOs were not released with releaseGLObjects()" << std::endl;
+    }
+  }
+
+  /*******************************************************/
+  bool FrameCapture::setEncoder(Encoder *encoder)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    if(_capturing) return false;
+    _encoder = encoder;
+    return true;
+  }
+
+  /*******************************************************/
+  FrameCapture::Encoder* FrameCapture::getEncoder() const
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    return _encoder.get();
+  }
+
+  /*******************************************************/
+  void FrameCapture::setNumPBOs(unsigned int numPBOs)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    if(!_capturing) _numPBOs = std::max(numPBOs, 1u);
+  }
+
+  /*******************************************************/
+  void FrameCapture::setNumThreads(unsigned int numThreads)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    if(!_capturing) _numThreads = std::max(numThreads, 1u);
+  }
+
+  /*******************************************************/
+  void FrameCapture::setMaxQueuedFrames(unsigned int maxFrames)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+    _maxQueuedFrames = std::max(maxFrames, 1u);
+    _queueCond.broadcast(); // Renderer may be waiting for room in the queue
+  }
+
+  /*******************************************************/
+  void FrameCapture::setDropFrames(bool drop)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+    _dropFrames = drop;
+    _queueCond.broadcast(); // Renderer may be waiting for room in the queue
+  }
+
+  /*******************************************************/
+  bool FrameCapture::start(int numFrames)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    if(!_encoder.valid())
+    {
+      std::cerr<< "OpenFrames::FrameCapture ERROR: No encoder specified" << std::endl;
+      return false;
+    }
+    if(numFrames == 0) return false;
+
+    // Ordered encoders can't encode frames in parallel
+    unsigned int numThreads = _encoder->isOrdered() ? 1 : _numThreads;
+    if(_threads.size() != numThreads)
+    {
+      _stopThreads(); // Finishes encoding any queued frames
+      _startThreads(numThreads);
+    }
+
+    _numFramesLeft = numFrames;
+    _capturing = true;
+    return true;
+  }
+
+  /*******************************************************/
+  void FrameCapture::stop()
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    _capturing = false;
+  }
+
+  /*******************************************************/
+  bool FrameCapture::isCapturing() const
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+    return _capturing;
+  }
+
+  /*******************************************************/
+  void FrameCapture::waitForEncoding()
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+    while((!_queue.empty() || (_numBusy > 0)) && !_threads.empty())
+    {
+      _queueCond.wait(&_queueMutex);
+    }
+  }
+
+  /*******************************************************/
+  void FrameCapture::capture(osg::GraphicsContext *gc)
+  {
+    // Nothing to do if not capturing and all frames have been queued
+    if(!hasPendingFrames()) return;
+
+    osg::GLExtensions *ext = gc->getState()->get<osg::GLExtensions>();
+    const osg::GraphicsContext::Traits *traits = gc->getTraits();
+
+    // PBOs hold frames of the old size, so read them before resizing
+    if((traits->width != _width) || (traits->height != _height))
+    {
+      _readPendingPBOs(ext);
+      releaseGLObjects(gc);
+      _width = traits->width;
+      _height = traits->height;
+    }
+
+    // Decide whether to capture this frame, and get the settings to capture it with
+    bool captureFrame = false, capturing;
+    unsigned int numPBOs;
+    osg::ref_ptr<Encoder> encoder;
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_captureMutex);
+      if(_capturing && (_width > 0) && (_height > 0))
+      {
+        captureFrame = true;
+        if((_numFramesLeft > 0) && (--_numFramesLeft == 0)) _capturing = false;
+      }
+      capturing = _capturing;
+      numPBOs = _numPBOs;
+      encoder = _encoder;
+    }
+
+    if(captureFrame)
+    {
+      // Frames of a previous capture with another encoder are queued and
+      // finished first, if that capture stopped without being flushed
+      if(encoder != _captureEncoder)
+      {
+        _readPendingPBOs(ext);
+        if(_finishPending) _queueFrame(NULL, 0);
+        _captureEncoder = encoder;
+      }
+      _finishPending = true;
+
+      const unsigned int frameNum = _frameNum++;
+      ++_numCaptured;
+
+      // Read from the buffer that was just drawn
+      glReadBuffer(traits->doubleBuffer ? GL_BACK : GL_FRONT);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+      if((numPBOs > 1) && ext->isPBOSupported)
+      {
+        // Create ring of PBOs for the current frame size
+        if(_pbos.empty())
+        {
+          _pbos.resize(numPBOs);
+          _pboFrameNums.assign(numPBOs, 0);
+          _pboPending.assign(numPBOs, false);
+          _numPending = 0;
+          _nextPBO = 0;
+
+          ext->glGenBuffers(numPBOs, &_pbos[0]);
+          for(unsigned int i = 0; i < numPBOs; ++i)
+          {
+            ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, _pbos[i]);
+            ext->glBufferData(GL_PIXEL_PACK_BUFFER_ARB, _width*_height*4, NULL, GL_STREAM_READ_ARB);
+          }
+        }
+
+        // Start an asynchronous copy of the frame into the next PBO
+        ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, _pbos[_nextPBO]);
+        glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+        _pboFrameNums[_nextPBO] = frameNum;
+        _pboPending[_nextPBO] = true;
+        ++_numPending;
+        _nextPBO = (_nextPBO + 1) % _pbos.size();
+
+        // The oldest PBO was filled a few frames ago, so its copy has most
+        // likely completed and it can be mapped without stalling
+        if(_pboPending[_nextPBO]) _readPBO(ext, _nextPBO);
+      }
+      else
+      {
+        // Synchronous readback
+        osg::ref_ptr<osg::Image> image = _acquireImage(_width, _height);
+        if(image.valid())
+        {
+          glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, image->data());
+          _queueFrame(image.get(), frameNum);
+        }
+      }
+    }
+
+    // Flush remaining frames once capturing stops, then finish the encoder
+    // once they have been encoded
+    if(!capturing)
+    {
+      _readPendingPBOs(ext);
+      if(_finishPending)
+      {
+        _queueFrame(NULL, 0);
+        _finishPending = false;
+      }
+    }
+  }
+
+  /*******************************************************/
+  void FrameCapture::releaseGLObjects(osg::GraphicsContext *gc)
+  {
+    if(_pbos.empty()) return;
+
+    // Frames that were never read can't be recovered
+    for(; _numPending > 0; --_numPending) ++_numDropped;
+
+    osg::GLExtensions *ext = gc->getState()->get<osg::GLExtensions>();
+    ext->glDeleteBuffers(_pbos.size(), &_pbos[0]);
+    _pbos.clear();
+    _pboFrameNums.clear();
+    _pboPending.clear();
+    _nextPBO = 0;
+  }
+
+  /*******************************************************/
+  void FrameCapture::_readPBO(osg::GLExtensions *ext, unsigned int index)
+  {
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, _pbos[index]);
+    const GLubyte *src = (const GLubyte*)ext->glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+    if(src)
+    {
+      osg::ref_ptr<osg::Image> image = _acquireImage(_width, _height);
+      if(image.valid())
+      {
+        std::memcpy(image->data(), src, image->getTotalSizeInBytes());
+        _queueFrame(image.get(), _pboFrameNums[index]);
+      }
+      ext->glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB);
+    }
+    else
+    {
+      std::cerr<< "OpenFrames::FrameCapture ERROR: Could not map PBO for frame " << _pboFrameNums[index] << std::endl;
+      ++_numFailed;
+    }
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+    _pboPending[index] = false;
+    --_numPending;
+  }
+
+  /*******************************************************/
+  void FrameCapture::_readPendingPBOs(osg::GLExtensions *ext)
+  {
+    // The next PBO to be filled is also the oldest one
+    for(unsigned int i = 0; (i < _pbos.size()) && (_numPending > 0); ++i)
+    {
+      unsigned int index = (_nextPBO + i) % _pbos.size();
+      if(_pboPending[index]) _readPBO(ext, index);
+    }
+  }
+
+  /*******************************************************/
+  osg::ref_ptr<osg::Image> FrameCapture::_acquireImage(int width, int height)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+
+    // Wait for room in the queue, or drop the frame
+    while(_queue.size() >= _maxQueuedFrames)
+    {
+      if(_dropFrames || _threads.empty())
+      {
+        ++_numDropped;
+        return NULL;
+      }
+      _queueCond.wait(&_queueMutex);
+    }
+
+    // Reuse an image that has already been encoded
+    osg::ref_ptr<osg::Image> image;
+    if(_freeImages.empty()) image = new osg::Image;
+    else
+    {
+      image = _freeImages.back();
+      _freeImages.pop_back();
+    }
+
+    if((image->s() != width) || (image->t() != height))
+    {
+      image->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, 1);
+    }
+
+    return image;
+  }
+
+  /*******************************************************/
+  void FrameCapture::_queueFrame(osg::Image *image, unsigned int frameNum)
+  {
+    QueuedFrame frame;
+    frame._image = image;
+    frame._frameNum = frameNum;
+    frame._encoder = _captureEncoder;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+    _queue.push_back(frame);
+    _queueCond.broadcast();
+  }
+
+  /*******************************************************/
+  void FrameCapture::_encodeFrames()
+  {
+    while(true)
+    {
+      QueuedFrame frame;
+
+      // Wait for a frame to encode
+      {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+        while(_queue.empty() && !_stopRequested) _queueCond.wait(&_queueMutex);
+        if(_queue.empty()) return; // Stop requested and all frames encoded
+
+        frame = _queue.front();
+        _queue.pop_front();
+        _queueCond.broadcast(); // Renderer may be waiting for room in the queue
+
+        // Other threads may still be encoding frames before the end of a capture
+        if(!frame._image.valid())
+        {
+          while(_numBusy > 0) _queueCond.wait(&_queueMutex);
+        }
+        ++_numBusy;
+      }
+
+      if(!frame._image.valid()) frame._encoder->finish();
+      else if(frame._encoder->encode(*frame._image, frame._frameNum)) ++_numEncoded;
+      else ++_numFailed;
+
+      // Return the image for reuse
+      {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+        if(frame._image.valid()) _freeImages.push_back(frame._image);
+        --_numBusy;
+        _queueCond.broadcast();
+      }
+    }
+  }
+
+  /*******************************************************/
+  void FrameCapture::_startThreads(unsigned int numThreads)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+    for(unsigned int i = 0; i < numThreads; ++i)
+    {
+      EncoderThread *thread = new EncoderThread(this);
+      thread->start();
+      _threads.push_back(thread);
+    }
+  }
+
+  /*******************************************************/
+  void FrameCapture::_stopThreads()
+  {
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+      _stopRequested = true;
+      _queueCond.broadcast();
+    }
+
+    // Threads exit after encoding all queued frames
+    for(unsigned int i = 0; i < _threads.size(); ++i)
+    {
+      _threads[i]->join();
+      delete _threads[i];
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+    _threads.clear();
+    _stopRequested = false;
+  }
+
+} // !namespace OpenFrames
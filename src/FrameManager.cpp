@@ -0,0 +1,225 @@
+/***********************************
+   Copyright 2019 Ravishankar Mathur
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+***********************************/
+
+/** \file FrameManager.cpp
+ * FrameManager-class function definitions.
+ */
+
+#include <OpenFrames/FrameManager.hpp>
+#include <OpenThreads/ScopedLock>
+
+namespace OpenFrames
+{
+
+  void FrameManager::setDoubleBuffered(bool doubleBuffered)
+  {
+    // If double buffered, this also waits for frames being drawn to finish
+    lock();
+
+    if(_doubleBuffered && !doubleBuffered)
+    {
+      // Apply states that were staged while double buffered
+      _mutexStaging.lock();
+      _doubleBuffered = false;
+      _frontStates.swap(_backStates);
+      _statesStaged.exchange(0);
+      _mutexStaging.unlock();
+
+      for(auto &state : _frontStates) _applyState(state.second);
+      _frontStates.clear();
+    }
+    else _doubleBuffered = doubleBuffered;
+
+    unlock();
+  }
+
+  void FrameManager::stagePosition(ReferenceFrame *frame, const osg::Vec3d &pos)
+  {
+    if(frame == NULL) return;
+
+    FrameState *state = _beginStaging(frame);
+    if(state)
+    {
+      state->_position = pos;
+      state->_staged |= FrameState::POSITION;
+    }
+    else frame->setPosition(pos);
+    _endStaging(state);
+  }
+
+  void FrameManager::stageAttitude(ReferenceFrame *frame, const osg::Quat &att)
+  {
+    if(frame == NULL) return;
+
+    FrameState *state = _beginStaging(frame);
+    if(state)
+    {
+      state->_attitude = att;
+      state->_staged |= FrameState::ATTITUDE;
+    }
+    else frame->setAttitude(att);
+    _endStaging(state);
+  }
+
+  void FrameManager::stageVisibility(ReferenceFrame *frame, bool visible)
+  {
+    if(frame == NULL) return;
+
+    FrameState *state = _beginStaging(frame);
+    if(state)
+    {
+      state->_visible = visible;
+      state->_staged |= FrameState::VISIBILITY;
+    }
+    else frame->getTransform()->setNodeMask(visible ? 0xffffffff : 0x0);
+    _endStaging(state);
+  }
+
+  void FrameManager::stageColor(ReferenceFrame *frame, const osg::Vec4 &color)
+  {
+    if(frame == NULL) return;
+
+    FrameState *state = _beginStaging(frame);
+    if(state)
+    {
+      state->_color = color;
+      state->_staged |= FrameState::COLOR;
+    }
+    else frame->setColor(color);
+    _endStaging(state);
+  }
+
+  bool FrameManager::beginRender()
+  {
+    _mutexRender.readLock();
+
+    if(_doubleBuffered && (_statesStaged != 0))
+    {
+      // Other threads may be drawing the scene, so apply staged states exclusively
+      _mutexRender.readUnlock();
+      _mutexRender.writeLock();
+      if(_doubleBuffered) _applyStagedStates();
+      _mutexRender.writeUnlock();
+      _mutexRender.readLock();
+    }
+
+    // Double buffering can't be disabled while read-locked, so it's safe to draw
+    if(_doubleBuffered) return false;
+
+    _mutexRender.readUnlock();
+    lock(LOW_PRIORITY);
+    return true;
+  }
+
+  void FrameManager::endRender(bool locked)
+  {
+    if(locked) unlock(LOW_PRIORITY);
+    else _mutexRender.readUnlock();
+  }
+
+  void FrameManager::_applyStagedStates()
+  {
+    // Writers hold the staging mutex only briefly, so waiting for it is cheap
+    _mutexStaging.lock();
+    _frontStates.swap(_backStates);
+    _statesStaged.exchange(0);
+    _mutexStaging.unlock();
+
+    // Apply states without blocking writers, who now fill the other buffer
+    for(auto &state : _frontStates) _applyState(state.second);
+    _frontStates.clear();
+  }
+
+  FrameManager::FrameState* FrameManager::_beginStaging(ReferenceFrame *frame)
+  {
+    if(_doubleBuffered)
+    {
+      _mutexStaging.lock();
+
+      // Check again in case double buffering was disabled while waiting
+      if(_doubleBuffered)
+      {
+        FrameState &state = _backStates[frame];
+        if(!state._frame.valid()) state._frame = frame;
+        return &state;
+      }
+
+      _mutexStaging.unlock();
+    }
+
+    // Not double buffered, so modify the frame directly
+    lock();
+    return NULL;
+  }
+
+  void FrameManager::_endStaging(FrameState *state)
+  {
+    if(state)
+    {
+      _statesStaged.exchange(1);
+      _mutexStaging.unlock();
+      ++_generation; // Staged state has to be applied at the next frame
+    }
+    else unlock();
+  }
+
+  void FrameManager::_applyState(const FrameState &state)
+  {
+    ReferenceFrame *frame = state._frame.get();
+
+    if(state._staged & FrameState::POSITION) frame->setPosition(state._position);
+    if(state._staged & FrameState::ATTITUDE) frame->setAttitude(state._attitude);
+    if(state._staged & FrameState::VISIBILITY)
+      frame->getTransform()->setNodeMask(state._visible ? 0xffffffff : 0x0);
+    if(state._staged & FrameState::COLOR) frame->setColor(state._color);
+  }
+
+  void FrameManager::setLockStatsEnabled(bool enable)
+  {
+    _statsEnabled = enable;
+  }
+
+  LockStats FrameManager::getLockStats(Priority priority) const
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutexStats);
+    return _lockStats[priority];
+  }
+
+  void FrameManager::resetLockStats()
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutexStats);
+    _lockStats[LOW_PRIORITY].reset();
+    _lockStats[HIGH_PRIORITY].reset();
+  }
+
+  void FrameManager::_beginHold(Priority priority, osg::Timer_t startTick)
+  {
+    _holdStart = osg::Timer::instance()->tick();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutexStats);
+    _lockStats[priority].addWait(osg::Timer::instance()->delta_s(startTick, _holdStart));
+  }
+
+  void FrameManager::_endHold(Priority priority)
+  {
+    double holdTime = osg::Timer::instance()->delta_s(_holdStart, osg::Timer::instance()->tick());
+    _holdStart = 0;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutexStats);
+    _lockStats[priority].addHold(holdTime);
+  }
+
+} // !namespace OpenFrames
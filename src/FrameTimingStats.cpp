@@ -0,0 +1,222 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+/** \file FrameTimingStats.cpp
+ * FrameTimingStats-class function definitions.
+ */
+
+#include <OpenFrames/FrameTimingStats.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace OpenFrames
+{
+  static const char* phaseNames[FrameTimingStats::NUM_PHASES] =
+  {
+    "throttle", "lock", "event", "update", "depth_partition",
+    "cull", "draw", "swap", "other", "total"
+  };
+
+  /** Get index of the given percentile in a sorted list of n values */
+  static unsigned int getRank(unsigned int n, double pct)
+  {
+    double rank = std::ceil((double)n*std::min(std::max(pct, 0.0), 100.0)/100.0);
+    return (rank < 1.0) ? 0 : (unsigned int)rank - 1;
+  }
+
+  /*******************************************************/
+  FrameTimingStats::FrameTimingStats(unsigned int capacity)
+  : _numAdded(0), _resetCount(0)
+  {
+    // Use a power of 2 capacity so that ring buffer indices remain
+    // consistent when the frame counter wraps around
+    unsigned int size = 1;
+    while((size < capacity) && (size < (1u << 20))) size <<= 1;
+    _frames.resize(size);
+    _sequences = new OpenThreads::Atomic[size];
+  }
+
+  /*******************************************************/
+  FrameTimingStats::~FrameTimingStats()
+  {
+    delete[] _sequences;
+  }
+
+  /*******************************************************/
+  const char* FrameTimingStats::getPhaseName(Phase phase)
+  {
+    if(phase < NUM_PHASES) return phaseNames[phase];
+    else return "invalid";
+  }
+
+  /*******************************************************/
+  void FrameTimingStats::addFrame(const FrameTiming &timing)
+  {
+    unsigned int slot = _numAdded & (_frames.size() - 1);
+
+    // Readers discard the slot if its counter is odd or changes while copying
+    ++_sequences[slot];
+    _frames[slot] = timing;
+    ++_sequences[slot];
+
+    ++_numAdded;
+  }
+
+  /*******************************************************/
+  void FrameTimingStats::reset()
+  {
+    _resetCount.exchange(_numAdded);
+  }
+
+  /*******************************************************/
+  void FrameTimingStats::getFrames(std::vector<FrameTiming> &frames) const
+  {
+    const unsigned int capacity = _frames.size();
+    const unsigned int mask = capacity - 1;
+
+    // Get range of available frames
+    unsigned int numAdded = _numAdded;
+    unsigned int count = std::min(numAdded - (unsigned int)_resetCount, capacity);
+    unsigned int begin = numAdded - count;
+
+    frames.resize(count);
+    unsigned int numCopied = 0;
+    for(unsigned int i = 0; i < count; ++i)
+    {
+      // Skip slots that are being written, or were written while copying
+      unsigned int slot = (begin + i) & mask;
+      unsigned int sequence = _sequences[slot];
+      if(sequence & 1) continue;
+      frames[numCopied] = _frames[slot];
+      if(_sequences[slot] != sequence) continue;
+
+      // Skip slots that the writer has since reused for a newer frame
+      if(_numAdded - (begin + i) >= capacity) continue;
+
+      ++numCopied;
+    }
+    frames.resize(numCopied);
+  }
+
+  /*******************************************************/
+  bool FrameTimingStats::getPercentiles(Phase phase, double p50Pct, double p95Pct, double p99Pct,
+                                        double &p50, double &p95, double &p99) const
+  {
+    p50 = p95 = p99 = 0.0;
+    if(phase >= NUM_PHASES) return false;
+
+    std::vector<FrameTiming> frames;
+    getFrames(frames);
+    if(frames.empty()) return false;
+
+    std::vector<double> times(frames.size());
+    for(unsigned int i = 0; i < frames.size(); ++i) times[i] = frames[i]._times[phase];
+    std::sort(times.begin(), times.end());
+
+    // Nearest-rank percentiles
+    p50 = times[getRank(times.size(), p50Pct)];
+    p95 = times[getRank(times.size(), p95Pct)];
+    p99 = times[getRank(times.size(), p99Pct)];
+    return true;
+  }
+
+  /*******************************************************/
+  std::string FrameTimingStats::getSummary() const
+  {
+    std::string summary = "Frame timing (ms): p50 / p95 / p99\n";
+    char line[128];
+    double p50, p95, p99;
+    for(unsigned int i = 0; i < NUM_PHASES; ++i)
+    {
+      Phase phase = (Phase)i;
+      if(!getPercentiles(phase, p50, p95, p99)) break;
+      std::snprintf(line, sizeof(line), "%s: %.2f / %.2f / %.2f\n",
+                    getPhaseName(phase), p50*1.0e3, p95*1.0e3, p99*1.0e3);
+      summary += line;
+    }
+    return summary;
+  }
+
+  /*******************************************************/
+  bool FrameTimingStats::writeCSV(const std::string &filename) const
+  {
+    std::ofstream file(filename.c_str());
+    if(!file)
+    {
+      std::cerr<< "OpenFrames::FrameTimingStats ERROR: Could not open " << filename << std::endl;
+      return false;
+    }
+
+    std::vector<FrameTiming> frames;
+    getFrames(frames);
+
+    file << "frame";
+    for(unsigned int i = 0; i < NUM_PHASES; ++i) file << ',' << phaseNames[i];
+    file << '\n' << std::setprecision(9);
+
+    for(unsigned int j = 0; j < frames.size(); ++j)
+    {
+      file << frames[j]._frameNumber;
+      for(unsigned int i = 0; i < NUM_PHASES; ++i) file << ',' << frames[j]._times[i];
+      file << '\n';
+    }
+
+    return file.good();
+  }
+
+  /*******************************************************/
+  bool FrameTimingStats::writeJSON(const std::string &filename) const
+  {
+    std::ofstream file(filename.c_str());
+    if(!file)
+    {
+      std::cerr<< "OpenFrames::FrameTimingStats ERROR: Could not open " << filename << std::endl;
+      return false;
+    }
+
+    std::vector<FrameTiming> frames;
+    getFrames(frames);
+
+    file << std::setprecision(9);
+    file << "{\n  \"numFrames\": " << frames.size() << ",\n  \"percentiles\": {";
+    double p50, p95, p99;
+    for(unsigned int i = 0; i < NUM_PHASES; ++i)
+    {
+      getPercentiles((Phase)i, p50, p95, p99);
+      file << (i ? ",\n" : "\n") << "    \"" << phaseNames[i] << "\": {\"p50\": " << p50
+           << ", \"p95\": " << p95 << ", \"p99\": " << p99 << "}";
+    }
+    file << "\n  },\n  \"frames\": [";
+
+    for(unsigned int j = 0; j < frames.size(); ++j)
+    {
+      file << (j ? ",\n" : "\n") << "    {\"frame\": " << frames[j]._frameNumber;
+      for(unsigned int i = 0; i < NUM_PHASES; ++i)
+      {
+        file << ", \"" << phaseNames[i] << "\": " << frames[j]._times[i];
+      }
+      file << "}";
+    }
+    file << "\n  ]\n}\n";
+
+    return file.good();
+  }
+
+} // !namespace OpenFrames
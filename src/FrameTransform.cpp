@@ -20,17 +20,34 @@
 
 #include <OpenFrames/FrameTransform.hpp>
 #include <osgUtil/CullVisitor>
+#include <OpenThreads/Atomic>
 
 namespace OpenFrames
 {
 
+  // Incremented whenever any FrameTransform changes
+  static OpenThreads::Atomic globalGeneration;
+
 FrameTransform::FrameTransform()
+	: _generation(0)
 {
 	reset();
 }
 
 FrameTransform::~FrameTransform() {}
 
+unsigned int FrameTransform::getGlobalGeneration()
+{
+	return globalGeneration;
+}
+
+void FrameTransform::_dirtyTransform()
+{
+	++_generation;
+	++globalGeneration;
+	dirtyBound();
+}
+
 void FrameTransform::reset()
 {
 	_disabled = false;
@@ -39,20 +56,24 @@ void FrameTransform::reset()
 	setAttitude(0.0, 0.0, 0.0, 1.0);
 	setScale(1.0, 1.0, 1.0);
 	setPivot(0.0, 0.0, 0.0);
+	_dirtyTransform(); // Setters only dirty the transform if their values change
 }
 
 void FrameTransform::setPosition(const double &x, const double &y, const double &z)
 {
+	// Setting the same value doesn't count as a change
+	if((_position[0] == x) && (_position[1] == y) && (_position[2] == z)) return;
 	_position[0] = x;
 	_position[1] = y;
 	_position[2] = z;
-	dirtyBound();
+	_dirtyTransform();
 }
 
 void FrameTransform::setPosition(const osg::Vec3d &pos)
 {
+  if(_position == pos) return;
   _position = pos;
-  dirtyBound();
+  _dirtyTransform();
 }
 
 void FrameTransform::getPosition(double &x, double &y, double &z) const
@@ -75,17 +96,20 @@ void FrameTransform::getPosition(osg::Vec3d &pos) const
 void FrameTransform::setAttitude(const double &rx, const double &ry,
 				const double &rz, const double &angle)
 {
+	if((_attitude._v[0] == rx) && (_attitude._v[1] == ry) &&
+	   (_attitude._v[2] == rz) && (_attitude._v[3] == angle)) return;
 	_attitude._v[0] = rx;
 	_attitude._v[1] = ry;
 	_attitude._v[2] = rz;
 	_attitude._v[3] = angle;
-	dirtyBound();
+	_dirtyTransform();
 }
 
 void FrameTransform::setAttitude(const osg::Quat &att)
 {
+  if(_attitude == att) return;
   _attitude = att;
-  dirtyBound();
+  _dirtyTransform();
 }
 
 void FrameTransform::getAttitude(double &rx, double &ry, double &rz, double &angle) const
@@ -112,10 +136,11 @@ void FrameTransform::getAttitude(osg::Quat &att) const
 
 void FrameTransform::setScale(const double &sx, const double &sy, const double &sz)
 {
+	if((_scale[0] == sx) && (_scale[1] == sy) && (_scale[2] == sz)) return;
 	_scale[0] = sx;
 	_scale[1] = sy;
 	_scale[2] = sz;
-	dirtyBound();
+	_dirtyTransform();
 }
 
 void FrameTransform::getScale(double &sx, double &sy, double &sz)
@@ -131,10 +156,11 @@ void FrameTransform::getScale(double &sx, double &sy, double &sz)
 
 void FrameTransform::setPivot(const double &px, const double &py, const double &pz)
 {
+	if((_pivot[0] == px) && (_pivot[1] == py) && (_pivot[2] == pz)) return;
 	_pivot[0] = px;
 	_pivot[1] = py;
 	_pivot[2] = pz;
-	dirtyBound();
+	_dirtyTransform();
 }
 
 void FrameTransform::getPivot(double &px, double &py, double &pz)
@@ -19,16 +19,21 @@
  */
 
 #include <OpenFrames/FramerateLimiter.hpp>
+#include <OpenThreads/ScopedLock>
 #include <OpenThreads/Thread>
+#include <algorithm>
+#include <cmath>
   
 namespace OpenFrames{
 
 /** Constructor */
 FramerateLimiter::FramerateLimiter(double fps)
-  	: _timer(*osg::Timer::instance()),
-    _startTick(0), _endTick(0), _prevStartTick(0)
+  	: _pacingMode(SLEEP), _spinTime(0.002),
+    _timer(*osg::Timer::instance()),
+    _startTick(0), _endTick(0), _prevStartTick(0), _deadlineTick(0)
 {
 	setDesiredFramerate(fps);
+	resetIntervalStats();
 }
 
 void FramerateLimiter::setDesiredFramerate(double fps)
@@ -40,6 +45,13 @@ void FramerateLimiter::setDesiredFramerate(double fps)
     _desiredSPF = 0.0; // Indicate unlimited framerate
 
   _currSPF = _desiredSPF;
+  _deadlineTick = 0; // Restart deadline schedule
+}
+
+void FramerateLimiter::setPacingMode(PacingMode mode)
+{
+  _pacingMode = mode;
+  _deadlineTick = 0; // Restart deadline schedule
 }
 
 /** Indicates the start of a new frame */
@@ -48,19 +60,87 @@ void FramerateLimiter::frame()
   // This frame begins after the previous frame's workload ends
   _endTick = _timer.tick();
 
-  // Compute time taken by workload
-  double workTime = _timer.delta_s(_startTick, _endTick);
+  if (_pacingMode == HYBRID) _waitForDeadline();
+  else
+  {
+    // Compute time taken by workload
+    double workTime = _timer.delta_s(_startTick, _endTick);
 
-  // Sleep until the next workload should begin
-  double sleepTime = _desiredSPF - workTime;
-  if (sleepTime > 0.0) OpenThreads::Thread::microSleep((unsigned int)(sleepTime*1.0e6));
+    // Sleep until the next workload should begin
+    double sleepTime = _desiredSPF - workTime;
+    if (sleepTime > 0.0) OpenThreads::Thread::microSleep((unsigned int)(sleepTime*1.0e6));
+  }
 
   // Get next workload start time
   _startTick = _timer.tick();
 
   // Update statistics (considered part of next workload)
   _currSPF = _timer.delta_s(_prevStartTick, _startTick);
+  if (_prevStartTick != 0) _addInterval(_currSPF);
   _prevStartTick = _startTick;
 }
 
+void FramerateLimiter::_waitForDeadline()
+{
+  if (_desiredSPF == 0.0) return; // Unlimited framerate
+
+  // Deadlines are a fixed number of ticks apart, so that sleep errors
+  // don't accumulate into framerate drift
+  osg::Timer_t frameTicks = (osg::Timer_t)(_desiredSPF/_timer.getSecondsPerTick());
+  if (_deadlineTick == 0) _deadlineTick = _endTick;
+  else _deadlineTick += frameTicks;
+
+  // If more than a frame behind (e.g. after a long frame or pause), restart the
+  // schedule instead of rushing through several frames to catch up
+  if (_endTick > _deadlineTick + frameTicks) _deadlineTick = _endTick;
+
+  // Coarse sleep until shortly before the deadline
+  if (_endTick < _deadlineTick)
+  {
+    double sleepTime = _timer.delta_s(_endTick, _deadlineTick) - _spinTime;
+    if (sleepTime > 0.0) OpenThreads::Thread::microSleep((unsigned int)(sleepTime*1.0e6));
+  }
+
+  // Yield the processor until the deadline
+  while (_timer.tick() < _deadlineTick) OpenThreads::Thread::YieldCurrentThread();
+}
+
+void FramerateLimiter::_addInterval(double interval)
+{
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+  ++_numIntervals;
+  _sumInterval += interval;
+  _sumSqInterval += interval*interval;
+  _minInterval = std::min(_minInterval, interval);
+  _maxInterval = std::max(_maxInterval, interval);
+  if (_desiredSPF > 0.0) _maxError = std::max(_maxError, std::abs(interval - _desiredSPF));
+}
+
+unsigned int FramerateLimiter::getIntervalStats(double &mean, double &jitter, double &minInterval,
+                                                double &maxInterval, double &maxError) const
+{
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+  if (_numIntervals == 0)
+  {
+    mean = jitter = minInterval = maxInterval = maxError = 0.0;
+    return 0;
+  }
+
+  mean = _sumInterval/_numIntervals;
+  jitter = std::sqrt(std::max(_sumSqInterval/_numIntervals - mean*mean, 0.0));
+  minInterval = _minInterval;
+  maxInterval = _maxInterval;
+  maxError = _maxError;
+  return _numIntervals;
+}
+
+void FramerateLimiter::resetIntervalStats()
+{
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+  _numIntervals = 0;
+  _sumInterval = _sumSqInterval = 0.0;
+  _minInterval = 1.0e300;
+  _maxInterval = _maxError = 0.0;
+}
+
 } // !namespace OpenFrames
@@ -0,0 +1,503 @@
+/***********************************
+   Copyright 2019 Ravishankar Mathur
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+***********************************/
+
+/** \file InstancedModel.cpp
+ * Definitions for the InstancedModel class.
+ */
+
+#include <OpenFrames/InstancedModel.hpp>
+#include <osg/Geode>
+#include <osg/Program>
+#include <osg/Shader>
+#include <osgDB/ReadFile>
+#include <osgUtil/Optimizer>
+#include <OpenThreads/ScopedLock>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace OpenFrames
+{
+  // Texture unit that holds packed instance transforms
+  static const unsigned int OF_INSTANCEDATA_UNIT = 7;
+
+  // Number of instances in each row of the packed instance transform texture
+  static const unsigned int OF_INSTANCES_PER_ROW = 256;
+
+  // Implement vertex shader that places each instance using its packed
+  // eye-space transform, and applies per-vertex lighting from the first light
+  static const char *OFInstancedModel_VertSource = {
+    "#version 120\n"
+    "#extension GL_ARB_draw_instanced : require\n"
+    "uniform mat4 osg_ProjectionMatrix;\n"
+
+    // Eye-space transform rows of visible instances, 3 texels per instance
+    "uniform sampler2D of_InstanceData;\n"
+    "uniform vec2 of_InstanceDataSize;\n"
+    "const float instancesPerRow = 256.0;\n"
+
+    "vec4 instanceRow(float row, float col, float i)\n"
+    "{\n"
+    "  vec2 uv = vec2(3.0*col + i + 0.5, row + 0.5)/of_InstanceDataSize;\n"
+    "  return texture2DLod(of_InstanceData, uv, 0.0);\n"
+    "}\n"
+
+    "void main(void)\n"
+    "{\n"
+       // Get this instance's eye-space transform
+    "  float id = float(gl_InstanceIDARB);\n"
+    "  float row = floor(id/instancesPerRow);\n"
+    "  float col = id - row*instancesPerRow;\n"
+    "  vec4 r0 = instanceRow(row, col, 0.0);\n"
+    "  vec4 r1 = instanceRow(row, col, 1.0);\n"
+    "  vec4 r2 = instanceRow(row, col, 2.0);\n"
+
+       // Transform vertex and normal to eye space
+    "  vec4 ecPos = vec4(dot(r0, gl_Vertex), dot(r1, gl_Vertex), dot(r2, gl_Vertex), 1.0);\n"
+    "  vec3 n = normalize(vec3(dot(r0.xyz, gl_Normal), dot(r1.xyz, gl_Normal), dot(r2.xyz, gl_Normal)));\n"
+    "  gl_Position = osg_ProjectionMatrix*ecPos;\n"
+
+       // Ambient and diffuse lighting from the first light source
+    "  vec3 L = normalize(gl_LightSource[0].position.xyz - ecPos.xyz*gl_LightSource[0].position.w);\n"
+    "  float NdotL = max(dot(n, L), 0.0);\n"
+    "  gl_FrontColor = gl_FrontLightModelProduct.sceneColor + gl_FrontLightProduct[0].ambient + NdotL*gl_FrontLightProduct[0].diffuse;\n"
+    "  gl_FrontColor.a = gl_FrontMaterial.diffuse.a;\n"
+    "  gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "}\n"
+  };
+
+  /** Gathers instance transforms during the update traversal */
+  class InstancedModel::InstanceUpdateCallback : public osg::Callback
+  {
+  public:
+    InstanceUpdateCallback(InstancedModel *im) : _im(im) {}
+
+    virtual bool run(osg::Object* object, osg::Object* data)
+    {
+      _im->_updateInstances();
+      return traverse(object, data);
+    }
+
+  protected:
+    InstancedModel *_im; // Not ref'd since the InstancedModel removes this callback in its destructor
+  };
+
+  /** Culls instances for each camera, then traverses the camera's copy of the
+      model instead of the model itself, so that only visible instances are drawn */
+  class InstancedModel::InstanceCullCallback : public osg::Callback
+  {
+  public:
+    InstanceCullCallback(InstancedModel *im) : _im(im) {}
+
+    virtual bool run(osg::Object* object, osg::Object* data)
+    {
+      osgUtil::CullVisitor *cv = dynamic_cast<osgUtil::CullVisitor*>(data);
+      if(cv == nullptr) return traverse(object, data);
+
+      CameraInstances *ci = _im->_cullInstances(cv);
+      if(ci->_model.valid() && (ci->_numVisible > 0))
+      {
+        cv->pushStateSet(ci->_stateSet.get());
+        ci->_model->accept(*cv);
+        cv->popStateSet();
+      }
+      return true;
+    }
+
+  protected:
+    InstancedModel *_im; // Not ref'd since the InstancedModel removes this callback in its destructor
+  };
+
+  /** Makes each instanced geometry's bounds include all instances, so that
+      the geometry is culled and near/far planes are computed correctly */
+  class InstancedModel::InstanceBoundCallback : public osg::Drawable::ComputeBoundingBoxCallback
+  {
+  public:
+    InstanceBoundCallback(const InstancedModel *im) : _im(im) {}
+
+    virtual osg::BoundingBox computeBound(const osg::Drawable&) const
+    {
+      return _im->_instanceBox;
+    }
+
+  protected:
+    const InstancedModel *_im; // Not ref'd since the InstancedModel removes this callback in its destructor
+  };
+
+  /** Prepares all geometries in a model for instanced drawing */
+  class InstancingVisitor : public osg::NodeVisitor
+  {
+  public:
+    InstancingVisitor(osg::Drawable::ComputeBoundingBoxCallback *boundCallback, std::vector<osg::ref_ptr<osg::Geometry> > &geoms)
+    : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+    _boundCallback(boundCallback), _geoms(geoms)
+    {}
+
+    virtual void apply(osg::Geode &geode)
+    {
+      for(unsigned int i = 0; i < geode.getNumDrawables(); ++i)
+      {
+        osg::Geometry *geom = geode.getDrawable(i)->asGeometry();
+        if(geom == nullptr) continue;
+
+        // Instanced drawing requires vertex buffer objects
+        geom->setUseDisplayList(false);
+        geom->setUseVertexBufferObjects(true);
+        geom->setComputeBoundingBoxCallback(_boundCallback);
+        _geoms.push_back(geom);
+      }
+
+      traverse(geode);
+    }
+
+  protected:
+    osg::ref_ptr<osg::Drawable::ComputeBoundingBoxCallback> _boundCallback;
+    std::vector<osg::ref_ptr<osg::Geometry> > &_geoms;
+  };
+
+  InstancedModel::InstancedModel( const std::string &name )
+  : ReferenceFrame(name)
+  {
+    _init();
+  }
+
+  InstancedModel::InstancedModel( const std::string &name, const osg::Vec3 &color )
+  : ReferenceFrame(name, color)
+  {
+    _init();
+  }
+
+  InstancedModel::InstancedModel( const std::string &name, const osg::Vec4 &color )
+  : ReferenceFrame(name, color)
+  {
+    _init();
+  }
+
+  InstancedModel::InstancedModel( const std::string &name, float r, float g, float b, float a )
+  : ReferenceFrame(name, r, g, b, a)
+  {
+    _init();
+  }
+
+  InstancedModel::~InstancedModel()
+  {
+    // Callbacks refer to this InstancedModel, so make sure they aren't called after it's gone
+    _instanceGroup->setUpdateCallback(nullptr);
+    _instanceGroup->setCullCallback(nullptr);
+    for(auto geom : _instancedGeoms) geom->setComputeBoundingBoxCallback(nullptr);
+    for(auto &ci : _cameraInstances)
+    {
+      for(auto geom : ci.second._geoms) geom->setComputeBoundingBoxCallback(nullptr);
+    }
+  }
+
+  void InstancedModel::_init()
+  {
+    _minPixelSize = 0.0;
+
+    // Create the group that draws all instances, which is hidden until instances are added
+    _instanceGroup = new osg::Group;
+    _instanceGroup->setName(_name + " instances");
+    _instanceGroup->setNodeMask(0x0);
+    _xform->addChild(_instanceGroup.get());
+
+    // Create vertex shader that places instances
+    osg::Shader *vertShader = new osg::Shader(osg::Shader::VERTEX, OFInstancedModel_VertSource);
+    osg::Program *program = new osg::Program;
+    program->setName("OFInstancedModel_ShaderProgram");
+    program->addShader(vertShader);
+
+    // Override any shaders in the model, since they can't place instances
+    osg::StateSet *ss = _instanceGroup->getOrCreateStateSet();
+    ss->setAttribute(program, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+    ss->addUniform(new osg::Uniform("of_InstanceData", (int)OF_INSTANCEDATA_UNIT));
+
+    _instanceGroup->setUpdateCallback(new InstanceUpdateCallback(this));
+    _instanceGroup->setCullCallback(new InstanceCullCallback(this));
+  }
+
+  /********************************************************/
+  bool InstancedModel::setModel( const std::string& filename )
+  {
+    osg::ref_ptr<osg::Node> loadedModel = osgDB::readRefNodeFile(filename);
+    if(!loadedModel.valid())
+    {
+      std::cerr<< "OpenFrames::InstancedModel ERROR: Model file \'" << filename << "\' could not be loaded!" << std::endl;
+      return false;
+    }
+
+    // Geometries are modified for instancing, so use a private copy of the model
+    // in case the loaded model is shared through the object cache
+    osg::ref_ptr<osg::Group> newModel = new osg::Group;
+    newModel->setName(filename);
+    newModel->addChild(osg::clone(loadedModel.get(), osg::CopyOp(osg::CopyOp::DEEP_COPY_NODES | osg::CopyOp::DEEP_COPY_DRAWABLES | osg::CopyOp::DEEP_COPY_PRIMITIVES)));
+
+    // Instance transforms are applied directly to model vertices, so flatten
+    // the model's own transforms into its vertices
+    osgUtil::Optimizer optimizer;
+    optimizer.optimize(newModel.get(), osgUtil::Optimizer::FLATTEN_STATIC_TRANSFORMS_DUPLICATING_SHARED_SUBGRAPHS);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_instanceMutex);
+
+    // Remove current model
+    for(auto geom : _instancedGeoms) geom->setComputeBoundingBoxCallback(nullptr);
+    _instancedGeoms.clear();
+    _instanceGroup->removeChildren(0, _instanceGroup->getNumChildren());
+
+    // Store the model's own bounds, since instancing makes its geometries
+    // report the bounds of all instances
+    _modelBound = newModel->getBound();
+
+    // Prepare new model for instancing
+    InstancingVisitor iv(new InstanceBoundCallback(this), _instancedGeoms);
+    newModel->accept(iv);
+    _model = newModel;
+    _instanceGroup->addChild(_model.get());
+
+    // Each camera copies the new model during its next cull traversal
+    return true;
+  }
+
+  /********************************************************/
+  void InstancedModel::addInstance( ReferenceFrame* frame )
+  {
+    if(frame == nullptr) return;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_instanceMutex);
+
+    if(_instanceIndices.find(frame) != _instanceIndices.end()) return;
+    _instanceIndices[frame] = _instanceFrames.size();
+    _instanceFrames.push_back(frame);
+
+    _instanceGroup->setNodeMask(0xffffffff);
+  }
+
+  /********************************************************/
+  void InstancedModel::removeInstance( ReferenceFrame* frame )
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_instanceMutex);
+
+    InstanceIndexMap::iterator i = _instanceIndices.find(frame);
+    if(i == _instanceIndices.end()) return;
+
+    // Move last instance into the removed instance's place
+    unsigned int index = i->second;
+    _instanceIndices.erase(i);
+    if(index != _instanceFrames.size() - 1)
+    {
+      _instanceFrames[index] = _instanceFrames.back();
+      _instanceIndices[_instanceFrames[index].get()] = index;
+    }
+    _instanceFrames.pop_back();
+
+    if(_instanceFrames.empty()) _instanceGroup->setNodeMask(0x0);
+  }
+
+  /********************************************************/
+  void InstancedModel::removeAllInstances()
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_instanceMutex);
+    _instanceFrames.clear();
+    _instanceIndices.clear();
+    _instanceGroup->setNodeMask(0x0);
+  }
+
+  /********************************************************/
+  void InstancedModel::_updateInstances()
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_instanceMutex);
+
+    unsigned int numInstances = _instanceFrames.size();
+    _instanceMatrices.resize(numInstances);
+    _instanceBounds.resize(numInstances);
+    _instanceBox.init();
+
+    const osg::BoundingSphere &modelBound = _modelBound;
+
+    // Instances are placed relative to the nearest ancestor of this frame (through
+    // first parents) that they share, so get the transform from that ancestor into
+    // this frame for each of this frame's ancestors, including itself
+    std::vector<ReferenceFrame*> ancestors;
+    std::vector<osg::Matrixd> ancestorInverses;
+    osg::Matrixd toAncestor;
+    for(ReferenceFrame *frame = this; frame != nullptr; )
+    {
+      ancestors.push_back(frame);
+      ancestorInverses.push_back(osg::Matrixd::inverse(toAncestor));
+
+      osg::Matrixd local;
+      frame->getTransform()->computeLocalToWorldMatrix(local, nullptr);
+      toAncestor.postMult(local);
+      frame = (frame->getNumParents() > 0) ? frame->getParent(0) : nullptr;
+    }
+
+    for(unsigned int i = 0; i < numInstances; ++i)
+    {
+      osg::Matrixd &mat = _instanceMatrices[i];
+      osg::BoundingSphere &bs = _instanceBounds[i];
+      bs.init();
+      if(!modelBound.valid()) continue;
+
+      // Get transform from instance to the shared ancestor. Instances of hidden
+      // frames, or of frames that don't share an ancestor with this frame, are
+      // not drawn.
+      mat.makeIdentity();
+      ReferenceFrame *frame = _instanceFrames[i].get();
+      std::vector<ReferenceFrame*>::iterator ancestor = ancestors.end();
+      while(frame != nullptr)
+      {
+        ancestor = std::find(ancestors.begin(), ancestors.end(), frame);
+        if(ancestor != ancestors.end()) break;
+
+        const FrameTransform *xform = frame->getTransform();
+        if(xform->getNodeMask() == 0x0) break;
+        osg::Matrixd local;
+        xform->computeLocalToWorldMatrix(local, nullptr);
+        mat.postMult(local);
+        frame = (frame->getNumParents() > 0) ? frame->getParent(0) : nullptr;
+      }
+      if((frame == nullptr) || (ancestor == ancestors.end())) continue;
+
+      // Get transform from instance to this frame
+      mat.postMult(ancestorInverses[ancestor - ancestors.begin()]);
+
+      // Scale model bounds by the instance's largest scale factor
+      double scale2 = osg::Vec3d(mat(0, 0), mat(0, 1), mat(0, 2)).length2();
+      scale2 = std::max(scale2, osg::Vec3d(mat(1, 0), mat(1, 1), mat(1, 2)).length2());
+      scale2 = std::max(scale2, osg::Vec3d(mat(2, 0), mat(2, 1), mat(2, 2)).length2());
+      bs.set(modelBound.center()*mat, modelBound.radius()*std::sqrt(scale2));
+      _instanceBox.expandBy(bs);
+    }
+
+    // Instances have moved, so geometry bounds must be recomputed,
+    // including those of each camera's copy of the model
+    for(auto geom : _instancedGeoms) geom->dirtyBound();
+    OpenThreads::ScopedLock<OpenThreads::Mutex> cameraLock(_cameraMutex);
+    for(auto &ci : _cameraInstances)
+    {
+      for(auto geom : ci.second._geoms) geom->dirtyBound();
+    }
+  }
+
+  /********************************************************/
+  InstancedModel::CameraInstances* InstancedModel::_cullInstances( osgUtil::CullVisitor* cv )
+  {
+    CameraInstances *ci;
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cameraMutex);
+
+      // Map elements aren't moved by insertions, so this pointer stays valid
+      ci = &_cameraInstances[cv->getCurrentCamera()];
+      if(!ci->_stateSet.valid())
+      {
+        ci->_stateSet = new osg::StateSet;
+        ci->_stateSet->setDataVariance(osg::Object::DYNAMIC);
+        ci->_dataSize = new osg::Uniform("of_InstanceDataSize", osg::Vec2());
+        ci->_stateSet->addUniform(ci->_dataSize);
+      }
+    }
+
+    // Each camera draws its own number of instances, so it needs its own copy of
+    // the model's primitive sets. Other model data is shared.
+    if(ci->_source != _model)
+    {
+      ci->_source = _model;
+      ci->_model = nullptr;
+      ci->_geoms.clear();
+      ci->_numVisible = 0; // Copied primitive sets don't draw instances yet
+      if(_model.valid())
+      {
+        ci->_model = osg::clone(_model.get(), osg::CopyOp(osg::CopyOp::DEEP_COPY_NODES | osg::CopyOp::DEEP_COPY_DRAWABLES | osg::CopyOp::DEEP_COPY_PRIMITIVES));
+        InstancingVisitor iv(new InstanceBoundCallback(this), ci->_geoms);
+        ci->_model->accept(iv);
+      }
+    }
+
+    // Make sure the packed transform texture can hold all instances
+    unsigned int numInstances = _instanceMatrices.size();
+    int numRows = std::max(1u, (numInstances + OF_INSTANCES_PER_ROW - 1)/OF_INSTANCES_PER_ROW);
+    if(!ci->_image.valid() || (ci->_image->t() < numRows))
+    {
+      int width = 3*OF_INSTANCES_PER_ROW;
+      ci->_image = new osg::Image;
+      ci->_image->setDataVariance(osg::Object::DYNAMIC);
+      ci->_image->allocateImage(width, numRows, 1, GL_RGBA, GL_FLOAT);
+      ci->_image->setInternalTextureFormat(GL_RGBA32F_ARB);
+
+      ci->_texture = new osg::Texture2D(ci->_image.get());
+      ci->_texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+      ci->_texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+      ci->_texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+      ci->_texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+      ci->_texture->setResizeNonPowerOfTwoHint(false);
+
+      // Texture is only read by the vertex shader, so don't enable its mode
+      ci->_stateSet->setTextureAttribute(OF_INSTANCEDATA_UNIT, ci->_texture.get());
+      ci->_dataSize->set(osg::Vec2(width, numRows));
+    }
+
+    // Cull instances against the view frustum and by pixel size, and pack the
+    // eye-space transforms of the remaining instances
+    const osg::Matrixd &modelView = *cv->getModelViewMatrix();
+    float *data = (float*)ci->_image->data();
+    unsigned int numVisible = 0;
+    for(unsigned int i = 0; i < numInstances; ++i)
+    {
+      const osg::BoundingSphere &bs = _instanceBounds[i];
+      if(!bs.valid() || cv->isCulled(bs)) continue;
+      if((_minPixelSize > 0.0) && (cv->clampedPixelSize(bs) < _minPixelSize)) continue;
+
+      // Eye-space transform is computed in double precision, then each
+      // of its first three columns is stored as a texel
+      osg::Matrixd instModelView = _instanceMatrices[i]*modelView;
+      float *texel = data + 12*numVisible;
+      for(unsigned int c = 0; c < 3; ++c)
+      {
+        texel[4*c]     = instModelView(0, c);
+        texel[4*c + 1] = instModelView(1, c);
+        texel[4*c + 2] = instModelView(2, c);
+        texel[4*c + 3] = instModelView(3, c);
+      }
+      ++numVisible;
+    }
+
+    ci->_image->dirty();
+
+    // Draw only the visible instances
+    if(numVisible != ci->_numVisible)
+    {
+      for(auto geom : ci->_geoms)
+      {
+        for(unsigned int j = 0; j < geom->getNumPrimitiveSets(); ++j)
+          geom->getPrimitiveSet(j)->setNumInstances(numVisible);
+      }
+      ci->_numVisible = numVisible;
+    }
+
+    return ci;
+  }
+
+  /********************************************************/
+  const osg::BoundingSphere& InstancedModel::getBound() const
+  {
+    // Bounding sphere encompasses axes/labels and all instances
+    ReferenceFrame::getBound();
+    if(_instanceBox.valid()) _bound.expandBy(_instanceBox);
+
+    return _bound;
+  }
+
+} // !namespace OpenFrames
@@ -225,6 +225,8 @@ private:
     // Compute intermediate points
     if ((_ma->getMarkers() & MarkerArtist::INTERMEDIATE) && (newNumPoints > 2) && (newNumPoints > _numPoints))
     {
+      _points.clear(); // Intermediate points to be split into high and low portions
+
       // Compute points at specified time increments
       if (_ma->getIntermediateType() == MarkerArtist::TIME)
       {
@@ -283,9 +285,7 @@ private:
           }
 
           // Store the interpolated point
-          OpenFrames::DS_Split(newPoint, high, low);
-          _intermediateVertexHigh->push_back(high);
-          _intermediateVertexLow->push_back(low);
+          _points.push_back(newPoint);
         }
       }
 
@@ -344,10 +344,7 @@ private:
           {
             // Interpolate the data point to be plotted
             frac = (_targetDistance - _prevDistance) / (_currDistance - _prevDistance);
-            osg::Vec3d temp = prevPoint + (newPoint - prevPoint)*frac;
-            OpenFrames::DS_Split(temp, high, low);
-            _intermediateVertexHigh->push_back(high);
-            _intermediateVertexLow->push_back(low);
+            _points.push_back(prevPoint + (newPoint - prevPoint)*frac);
 
             _targetDistance += _ma->getIntermediateSpacing();
           }
@@ -395,11 +392,12 @@ private:
         for (; direction*_currIndex < end; _currIndex += spacing)
         {
           _traj->getPoint(_currIndex, _ma->getDataSource(), newPoint._v);
-          OpenFrames::DS_Split(newPoint, high, low);
-          _intermediateVertexHigh->push_back(high);
-          _intermediateVertexLow->push_back(low);
+          _points.push_back(newPoint);
         }
       }
+
+      // Split new intermediate points into high and low portions
+      OpenFrames::DS_Append(_points, *_intermediateVertexHigh, *_intermediateVertexLow);
     }
   }
 
@@ -428,6 +426,7 @@ private:
   osg::Vec3Array* _intermediateVertexHigh;
   osg::Vec3Array* _intermediateVertexLow;
   osg::DrawArrays* _intermediateDrawArrays;
+  std::vector<osg::Vec3d> _points; // New intermediate points
   const Trajectory* _traj;
   MarkerArtist* _ma;
 };
@@ -508,6 +507,7 @@ _intermediateDirection(START), _dataValid(true), _dataZero(true), _attenuationDi
 
   // Initialize point properties
   osg::StateSet *ss = getOrCreateStateSet();
+  ss->setDataVariance(osg::Object::DYNAMIC); // Marker properties can change while drawing
   ss->setAttribute(new osg::Point); // Allows marker resizing
   osg::PointSprite *sprite = new osg::PointSprite();
   ss->setTextureAttributeAndModes(0, sprite);
@@ -677,7 +677,8 @@ bool MarkerArtist::setMarkerImage(const std::string &fname)
           // Set up alpha blending for marker texture
           osg::BlendFunc *fn = new osg::BlendFunc();
           fn->setFunction(osg::BlendFunc::SRC_ALPHA, 
-              osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
+              osg::BlendFunc::ONE_MINUS_SRC_ALPHA,
+              osg::BlendFunc::ONE, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
           ss->setAttributeAndModes(fn);
 
           // Fragment shader to draw the marker texture
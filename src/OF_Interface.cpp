@@ -522,6 +522,162 @@ OF_EXPORT void OF_FCN(ofwin_gettimescale)(double *tscale)
   }
 }
 
+OF_EXPORT void OF_FCN(ofwin_setfixedtimestep)(double *dt)
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->setFixedTimeStep(*dt);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setoffscreen)(bool *offscreen)
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->setOffscreen(*offscreen);
+    if(_objs->_currWinProxy->isOffscreen() == *offscreen) _objs->_intVal = 0;
+    else _objs->_intVal = 1;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setmaxframes)(unsigned int *maxFrames)
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->setMaxFrames(*maxFrames);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setrenderondemand)(bool *onDemand)
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->setRenderOnDemand(*onDemand);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_requestredraw)()
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->requestRedraw();
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setthreadingmodel)(int *model)
+{
+  if(_objs->_currWinProxy)
+  {
+    osgViewer::ViewerBase::ThreadingModel tm;
+    switch(*model)
+    {
+      case 0: tm = osgViewer::ViewerBase::SingleThreaded; break;
+      case 1: tm = osgViewer::ViewerBase::CullDrawThreadPerContext; break;
+      case 2: tm = osgViewer::ViewerBase::DrawThreadPerContext; break;
+      case 3: tm = osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext; break;
+      default:
+        _objs->_intVal = 1;
+        return;
+    }
+    _objs->_currWinProxy->setThreadingModel(tm);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setdepthpartitionincremental)(unsigned int *row, unsigned int *col, bool *incremental)
+{
+  if(_objs->_currWinProxy)
+  {
+    RenderRectangle *rr = _objs->_currWinProxy->getGridPosition(*row, *col);
+    if (rr) {
+      rr->getDepthPartitioner()->getCallback()->setIncremental(*incremental);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = 1;
+    }
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setdepthpartitionthreads)(unsigned int *row, unsigned int *col, unsigned int *numThreads)
+{
+  if(_objs->_currWinProxy)
+  {
+    RenderRectangle *rr = _objs->_currWinProxy->getGridPosition(*row, *col);
+    if (rr) {
+      rr->getDepthPartitioner()->getCallback()->setNumThreads(*numThreads);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = 1;
+    }
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setdepthpartitionboundsarray)(unsigned int *row, unsigned int *col, bool *use)
+{
+  if(_objs->_currWinProxy)
+  {
+    RenderRectangle *rr = _objs->_currWinProxy->getGridPosition(*row, *col);
+    if (rr) {
+      rr->getDepthPartitioner()->getCallback()->setUseBoundsArray(*use);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = 1;
+    }
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setdepthmode)(unsigned int *row, unsigned int *col, int *mode)
+{
+  if(_objs->_currWinProxy)
+  {
+    RenderRectangle *rr = _objs->_currWinProxy->getGridPosition(*row, *col);
+    if (rr && (*mode == DepthPartitionCallback::PARTITIONED || *mode == DepthPartitionCallback::REVERSED_Z)) {
+      rr->setDepthMode((DepthPartitionCallback::DepthMode)(*mode));
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = 1;
+    }
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
 void OF_FCN(ofwin_setscene)(unsigned int *row, unsigned int *col)
 {
 	if(_objs->_currWinProxy) {
@@ -948,6 +1104,48 @@ void OF_FCN(ofwin_setdesiredframerate)(double *fps)
     }
 }
 
+OF_EXPORT void OF_FCN(ofwin_setframepacing)(int *mode, double *spinTime)
+{
+  if(_objs->_currWinProxy)
+  {
+    FramerateLimiter *limiter = _objs->_currWinProxy->getFramerateLimiter();
+    if(*mode == 1) limiter->setPacingMode(FramerateLimiter::HYBRID);
+    else limiter->setPacingMode(FramerateLimiter::SLEEP);
+    limiter->setSpinTime(*spinTime);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_getframeintervals)(unsigned int *numIntervals, double *mean,
+                                               double *jitter, double *maxError)
+{
+  if(_objs->_currWinProxy)
+  {
+    double minInterval, maxInterval;
+    FramerateLimiter *limiter = _objs->_currWinProxy->getFramerateLimiter();
+    *numIntervals = limiter->getIntervalStats(*mean, *jitter, minInterval, maxInterval, *maxError);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_resetframeintervals)()
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->getFramerateLimiter()->resetIntervalStats();
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
 void OF_FCN(ofwin_addview)(unsigned int *row, unsigned int *col)
 {
 	if(_objs->_currWinProxy && _objs->_currView)
@@ -1075,6 +1273,159 @@ OF_EXPORT void OF_FCN(ofwin_setwindowcapturekey)(int *key)
   }
 }
 
+OF_EXPORT void OF_FCN(ofwin_setframetimingenabled)(bool *enable)
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->setFrameTimingEnabled(*enable);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_showframetiming)(unsigned int *row, unsigned int *col, bool *show)
+{
+  if(_objs->_currWinProxy)
+  {
+    RenderRectangle *rr = _objs->_currWinProxy->getGridPosition(*row, *col);
+    if(rr)
+    {
+      rr->setShowFrameTiming(*show);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = 1;
+    }
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_getframetiming)(int *phase, double *p50, double *p95, double *p99)
+{
+  if(_objs->_currWinProxy)
+  {
+    FrameTimingStats *stats = _objs->_currWinProxy->getFrameTimingStats();
+    if((*phase >= 0) && stats->getPercentiles((FrameTimingStats::Phase)*phase, *p50, *p95, *p99))
+      _objs->_intVal = 0;
+    else
+      _objs->_intVal = 1;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_writeframetiming)(OF_CHARARG(fname))
+{
+  if(_objs->_currWinProxy)
+  {
+    // Convert given character string and length to a proper C string
+    std::string temp(OF_STRING(fname));
+    if(_objs->_currWinProxy->writeFrameTiming(temp)) _objs->_intVal = 0;
+    else _objs->_intVal = 1;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+#if defined(IFORT_CALLS)
+OF_EXPORT void OF_FCN(ofwin_setcapturefile)(const char *fname,
+                                            const char *fext,
+                                            unsigned int fnamelen,
+                                            unsigned int fextlen)
+#else
+OF_EXPORT void OF_FCN(ofwin_setcapturefile)(OF_CHARARG(fname),
+                                            OF_CHARARG(fext))
+#endif
+{
+  if(_objs->_currWinProxy)
+  {
+    // Convert given character string and length to a proper C string
+    std::string fnamestr(OF_STRING(fname));
+    std::string fextstr(OF_STRING(fext));
+    FrameCapture *capture = _objs->_currWinProxy->getFrameCapture();
+    osg::ref_ptr<FrameCapture::Encoder> encoder = new FrameCapture::ImageFileEncoder(fnamestr, fextstr);
+    if(capture->setEncoder(encoder.get())) _objs->_intVal = 0;
+    else _objs->_intVal = 1; // Can't change encoder while capturing
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setcapturepipe)(OF_CHARARG(command))
+{
+  if(_objs->_currWinProxy)
+  {
+    // Convert given character string and length to a proper C string
+    std::string temp(OF_STRING(command));
+    FrameCapture *capture = _objs->_currWinProxy->getFrameCapture();
+    osg::ref_ptr<FrameCapture::Encoder> encoder = new FrameCapture::PipeEncoder(temp);
+    if(capture->setEncoder(encoder.get())) _objs->_intVal = 0;
+    else _objs->_intVal = 1; // Can't change encoder while capturing
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_startcapture)(int *numFrames)
+{
+  if(_objs->_currWinProxy)
+  {
+    if(_objs->_currWinProxy->getFrameCapture()->start(*numFrames)) _objs->_intVal = 0;
+    else _objs->_intVal = 1;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_stopcapture)()
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->getFrameCapture()->stop();
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_setcapturedropframes)(bool *drop)
+{
+  if(_objs->_currWinProxy)
+  {
+    _objs->_currWinProxy->getFrameCapture()->setDropFrames(*drop);
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
+OF_EXPORT void OF_FCN(ofwin_getcapturestats)(unsigned int *numCaptured, unsigned int *numEncoded,
+                                             unsigned int *numDropped)
+{
+  if(_objs->_currWinProxy)
+  {
+    FrameCapture *capture = _objs->_currWinProxy->getFrameCapture();
+    *numCaptured = capture->getNumCaptured();
+    *numEncoded = capture->getNumEncoded();
+    *numDropped = capture->getNumDropped();
+    _objs->_intVal = 0;
+  }
+  else {
+    _objs->_intVal = -2;
+  }
+}
+
 /*******************************************
 	FrameManager Functions
 *******************************************/
@@ -1137,6 +1488,141 @@ void OF_FCN(offm_unlock)()
 	}
 }
 
+void OF_FCN(offm_setdoublebuffered)(bool *enable)
+{
+    if (_objs->_currFM) {
+      _objs->_currFM->setDoubleBuffered(*enable);
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_stageposition)(double *x, double *y, double *z)
+{
+    if (_objs->_currFM && _objs->_currFrame) {
+      _objs->_currFM->stagePosition(_objs->_currFrame, osg::Vec3d(*x, *y, *z));
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_stageattitude)(double *rx, double *ry, double *rz, double *angle)
+{
+    if (_objs->_currFM && _objs->_currFrame) {
+      _objs->_currFM->stageAttitude(_objs->_currFrame, osg::Quat(*rx, *ry, *rz, *angle));
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_stagevisibility)(bool *visible)
+{
+    if (_objs->_currFM && _objs->_currFrame) {
+      _objs->_currFM->stageVisibility(_objs->_currFrame, *visible);
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_stagecolor)(float *r, float *g, float *b, float *a)
+{
+    if (_objs->_currFM && _objs->_currFrame) {
+      _objs->_currFM->stageColor(_objs->_currFrame, osg::Vec4(*r, *g, *b, *a));
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_setlockstatsenabled)(bool *enable)
+{
+    if (_objs->_currFM) {
+      _objs->_currFM->setLockStatsEnabled(*enable);
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+/// Copy lock statistics to the given outputs
+static void getLockStatsValues(const LockStats &stats, unsigned int *numAcquisitions,
+                               double *totalWait, double *maxWait,
+                               double *totalHold, double *maxHold)
+{
+  *numAcquisitions = stats.getNumAcquisitions();
+  *totalWait = stats.getTotalWaitTime();
+  *maxWait = stats.getMaxWaitTime();
+  *totalHold = stats.getTotalHoldTime();
+  *maxHold = stats.getMaxHoldTime();
+}
+
+/// Copy lock histograms to the given outputs
+static void getLockStatsHistograms(const LockStats &stats, unsigned int waitHist[], unsigned int holdHist[])
+{
+  for(unsigned int i = 0; i < LockStats::NUM_BINS; ++i)
+  {
+    waitHist[i] = stats.getWaitCount(i);
+    holdHist[i] = stats.getHoldCount(i);
+  }
+}
+
+void OF_FCN(offm_getlockstats)(int *priority, unsigned int *numAcquisitions,
+                               double *totalWait, double *maxWait,
+                               double *totalHold, double *maxHold)
+{
+    if (_objs->_currFM) {
+      FrameManager::Priority p = (*priority == 0) ? FrameManager::LOW_PRIORITY : FrameManager::HIGH_PRIORITY;
+      getLockStatsValues(_objs->_currFM->getLockStats(p), numAcquisitions,
+                         totalWait, maxWait, totalHold, maxHold);
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_getlockhistograms)(int *priority, unsigned int waitHist[], unsigned int holdHist[])
+{
+    if (_objs->_currFM) {
+      FrameManager::Priority p = (*priority == 0) ? FrameManager::LOW_PRIORITY : FrameManager::HIGH_PRIORITY;
+      getLockStatsHistograms(_objs->_currFM->getLockStats(p), waitHist, holdHist);
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
+void OF_FCN(offm_resetlockstats)()
+{
+    if (_objs->_currFM) {
+      _objs->_currFM->resetLockStats();
+      _objs->_intVal = 0;
+    }
+	else 
+	{
+	  _objs->_intVal = -2;
+	}
+}
+
 /*******************************************
 	ReferenceFrame Functions
 *******************************************/
@@ -2388,6 +2874,55 @@ void OF_FCN(oftraj_autoinformartists)(bool *autoinform)
     }
 }
 
+void OF_FCN(oftraj_setlockstatsenabled)(bool *enable)
+{
+	if (_objs->_currTraj) {
+	  _objs->_currTraj->setLockStatsEnabled(*enable);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = -2;
+    }
+}
+
+void OF_FCN(oftraj_getlockstats)(int *lockType, unsigned int *numAcquisitions,
+                                 double *totalWait, double *maxWait,
+                                 double *totalHold, double *maxHold)
+{
+	if (_objs->_currTraj) {
+	  Trajectory::DataLockType type = (*lockType == 0) ? Trajectory::READ_LOCK : Trajectory::WRITE_LOCK;
+	  getLockStatsValues(_objs->_currTraj->getLockStats(type), numAcquisitions,
+	                     totalWait, maxWait, totalHold, maxHold);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = -2;
+    }
+}
+
+void OF_FCN(oftraj_getlockhistograms)(int *lockType, unsigned int waitHist[], unsigned int holdHist[])
+{
+	if (_objs->_currTraj) {
+	  Trajectory::DataLockType type = (*lockType == 0) ? Trajectory::READ_LOCK : Trajectory::WRITE_LOCK;
+	  getLockStatsHistograms(_objs->_currTraj->getLockStats(type), waitHist, holdHist);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = -2;
+    }
+}
+
+void OF_FCN(oftraj_resetlockstats)()
+{
+	if (_objs->_currTraj) {
+	  _objs->_currTraj->resetLockStats();
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = -2;
+    }
+}
+
 /************************************************
 	TrajectoryArtist Functions
 ************************************************/
@@ -2549,6 +3084,20 @@ void OF_FCN(ofcurveartist_setpattern)(int *factor, unsigned short *pattern)
     }
 }
 
+void OF_FCN(ofcurveartist_setvertexencoding)(int *encoding, unsigned int *chunkSize, double *chunkRadius)
+{
+	CurveArtist *artist = dynamic_cast<CurveArtist*>(_objs->_currArtist);
+    if (artist) {
+      artist->setVertexEncoding((CurveArtist::VertexEncoding)*encoding);
+      artist->setChunkSize(*chunkSize);
+      artist->setChunkRadius(*chunkRadius);
+      _objs->_intVal = 0;
+    }
+    else {
+      _objs->_intVal = -2;
+    }
+}
+
 /************************************************
 	SegmentArtist Functions
 ************************************************/
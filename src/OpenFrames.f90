@@ -41,10 +41,15 @@
 	INTEGER, PARAMETER :: OFMA_DISTANCE = 2 ! Distance increments
 	INTEGER, PARAMETER :: OFMA_DATA = 3 ! Data point increments
 
+! Constants used to tell a CurveArtist how to encode vertex positions
+	INTEGER, PARAMETER :: OFCA_DOUBLE_SINGLE = 0 ! High and low floats
+	INTEGER, PARAMETER :: OFCA_CHUNKED_RTC = 1 ! Float offsets from chunk centers
+
 ! Constants that determine how a frame following a trajectory handles when
 ! the current time is out of the trajectory's data bounds
 	INTEGER, PARAMETER :: OFFOLLOW_LOOP = 0
 	INTEGER, PARAMETER :: OFFOLLOW_LIMIT = 1
+	INTEGER, PARAMETER :: OFFOLLOW_EXTRAPOLATE = 2
 
 ! Constants that specify whether a frame follows a trajectory's position,
 ! attitude, or both
@@ -57,6 +62,39 @@
 	INTEGER, PARAMETER :: OF_YAXIS = 2 ! Use Y axis 
 	INTEGER, PARAMETER :: OF_ZAXIS = 4 ! Use Z axis
 
+! Constants that specify which lock statistics to get
+	INTEGER, PARAMETER :: OFFM_LOW_PRIORITY = 0 ! FrameManager rendering locks
+	INTEGER, PARAMETER :: OFFM_HIGH_PRIORITY = 1 ! FrameManager user locks
+	INTEGER, PARAMETER :: OFTRAJ_READ_LOCK = 0 ! Trajectory read locks
+	INTEGER, PARAMETER :: OFTRAJ_WRITE_LOCK = 1 ! Trajectory write locks
+	INTEGER, PARAMETER :: OF_LOCKSTATS_NUMBINS = 32 ! Lock histogram size
+
+! Constants that specify a phase of frame timing statistics
+	INTEGER, PARAMETER :: OFWIN_TIMING_THROTTLE = 0 ! Framerate limiter sleep
+	INTEGER, PARAMETER :: OFWIN_TIMING_LOCK = 1 ! Wait to lock scenes
+	INTEGER, PARAMETER :: OFWIN_TIMING_EVENT = 2 ! Event traversal
+	INTEGER, PARAMETER :: OFWIN_TIMING_UPDATE = 3 ! Update traversal
+	INTEGER, PARAMETER :: OFWIN_TIMING_DEPTH_PARTITION = 4 ! Depth partitioning
+	INTEGER, PARAMETER :: OFWIN_TIMING_CULL = 5 ! Cull traversal
+	INTEGER, PARAMETER :: OFWIN_TIMING_DRAW = 6 ! Draw traversal
+	INTEGER, PARAMETER :: OFWIN_TIMING_SWAP = 7 ! Swap buffers
+	INTEGER, PARAMETER :: OFWIN_TIMING_OTHER = 8 ! Remaining time
+	INTEGER, PARAMETER :: OFWIN_TIMING_TOTAL = 9 ! Total frame time
+
+! Constants that specify how the framerate limiter waits between frames
+	INTEGER, PARAMETER :: OFWIN_PACING_SLEEP = 0 ! Sleep for remaining frame time
+	INTEGER, PARAMETER :: OFWIN_PACING_HYBRID = 1 ! Sleep then yield until deadline
+
+! Constants that specify how rendering is distributed across threads
+	INTEGER, PARAMETER :: OFWIN_SINGLE_THREADED = 0 ! Update, cull, and draw in one thread
+	INTEGER, PARAMETER :: OFWIN_CULL_DRAW_THREAD_PER_CONTEXT = 1 ! Cull and draw in a thread per context
+	INTEGER, PARAMETER :: OFWIN_DRAW_THREAD_PER_CONTEXT = 2 ! Draw in a thread per context
+	INTEGER, PARAMETER :: OFWIN_CULL_THREAD_PER_CAMERA = 3 ! Cull per camera, draw per context
+
+! Constants that specify how scenes with large depth ranges are rendered
+	INTEGER, PARAMETER :: OFWIN_DEPTH_PARTITIONED = 0 ! Render in multiple depth segments
+	INTEGER, PARAMETER :: OFWIN_DEPTH_REVERSED_Z = 1 ! Render in one pass with reversed float depth
+
 ! Constants that specify relative view base reference frame
 	INTEGER, PARAMETER :: OFVIEW_ABSOLUTE = 0 ! Global reference frame
 	INTEGER, PARAMETER :: OFVIEW_RELATIVE = 1 ! Body-fixed frame
@@ -196,6 +234,57 @@
   REAL(8), INTENT(OUT) :: tscale
   END SUBROUTINE
 
+  SUBROUTINE ofwin_setfixedtimestep(dt)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setfixedtimestep
+  REAL(8), INTENT(IN) :: dt
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setoffscreen(offscreen)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setoffscreen
+  LOGICAL, INTENT(IN) :: offscreen
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setmaxframes(maxFrames)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setmaxframes
+  INTEGER, INTENT(IN) :: maxFrames
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setrenderondemand(onDemand)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setrenderondemand
+  LOGICAL, INTENT(IN) :: onDemand
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_requestredraw()
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_requestredraw
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setthreadingmodel(model)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setthreadingmodel
+  INTEGER, INTENT(IN) :: model
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setdepthpartitionincremental(row, col, incremental)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setdepthpartitionincremental
+  INTEGER, INTENT(IN) :: row, col
+  LOGICAL, INTENT(IN) :: incremental
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setdepthpartitionthreads(row, col, numThreads)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setdepthpartitionthreads
+  INTEGER, INTENT(IN) :: row, col, numThreads
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setdepthpartitionboundsarray(row, col, use)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setdepthpartitionboundsarray
+  INTEGER, INTENT(IN) :: row, col
+  LOGICAL, INTENT(IN) :: use
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setdepthmode(row, col, mode)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setdepthmode
+  INTEGER, INTENT(IN) :: row, col, mode
+  END SUBROUTINE
+
   SUBROUTINE ofwin_setlightambient(row, col, r, g, b)
   !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setlightambient
   INTEGER, INTENT(IN) :: row, col
@@ -281,6 +370,22 @@
 	REAL(8), INTENT(IN) :: fps
 	END SUBROUTINE
 
+	SUBROUTINE ofwin_setframepacing(mode, spinTime)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setframepacing
+	INTEGER, INTENT(IN) :: mode
+	REAL(8), INTENT(IN) :: spinTime
+	END SUBROUTINE
+
+	SUBROUTINE ofwin_getframeintervals(numIntervals, mean, jitter, maxError)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_getframeintervals
+	INTEGER, INTENT(OUT) :: numIntervals
+	REAL(8), INTENT(OUT) :: mean, jitter, maxError
+	END SUBROUTINE
+
+	SUBROUTINE ofwin_resetframeintervals()
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_resetframeintervals
+	END SUBROUTINE
+
 	SUBROUTINE ofwin_addview(row, col)
 	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_addview
 	INTEGER, INTENT(IN) :: row, col
@@ -362,6 +467,57 @@
   INTEGER, INTENT(IN) :: key
   END SUBROUTINE
 
+  SUBROUTINE ofwin_setframetimingenabled(enable)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setframetimingenabled
+  LOGICAL, INTENT(IN) :: enable
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_showframetiming(row, col, show)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_showframetiming
+  INTEGER, INTENT(IN) :: row, col
+  LOGICAL, INTENT(IN) :: show
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_getframetiming(phase, p50, p95, p99)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_getframetiming
+  INTEGER, INTENT(IN) :: phase
+  REAL(8), INTENT(OUT) :: p50, p95, p99
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_writeframetiming(fname)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_writeframetiming
+  CHARACTER(LEN=*), INTENT(IN) :: fname
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setcapturefile(fname, fext)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setcapturefile
+  CHARACTER(LEN=*), INTENT(IN) :: fname, fext
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setcapturepipe(command)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setcapturepipe
+  CHARACTER(LEN=*), INTENT(IN) :: command
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_startcapture(numFrames)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_startcapture
+  INTEGER, INTENT(IN) :: numFrames
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_stopcapture()
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_stopcapture
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_setcapturedropframes(drop)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_setcapturedropframes
+  LOGICAL, INTENT(IN) :: drop
+  END SUBROUTINE
+
+  SUBROUTINE ofwin_getcapturestats(numCaptured, numEncoded, numDropped)
+  !DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofwin_getcapturestats
+  INTEGER, INTENT(OUT) :: numCaptured, numEncoded, numDropped
+  END SUBROUTINE
+
 ! FrameManager functions
 
 	SUBROUTINE offm_activate(id)
@@ -386,6 +542,53 @@
 	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_unlock
 	END SUBROUTINE
 
+	SUBROUTINE offm_setdoublebuffered(enable)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_setdoublebuffered
+	LOGICAL, INTENT(IN) :: enable
+	END SUBROUTINE
+
+	SUBROUTINE offm_stageposition(x, y, z)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_stageposition
+	REAL(8), INTENT(IN) :: x, y, z
+	END SUBROUTINE
+
+	SUBROUTINE offm_stageattitude(x, y, z, angle)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_stageattitude
+	REAL(8), INTENT(IN) :: x, y, z, angle
+	END SUBROUTINE
+
+	SUBROUTINE offm_stagevisibility(visible)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_stagevisibility
+	LOGICAL, INTENT(IN) :: visible
+	END SUBROUTINE
+
+	SUBROUTINE offm_stagecolor(r, g, b, a)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_stagecolor
+	REAL, INTENT(IN) :: r, g, b, a
+	END SUBROUTINE
+
+	SUBROUTINE offm_setlockstatsenabled(enable)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_setlockstatsenabled
+	LOGICAL, INTENT(IN) :: enable
+	END SUBROUTINE
+
+	SUBROUTINE offm_getlockstats(priority, numAcquisitions, totalWait, maxWait, totalHold, maxHold)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_getlockstats
+	INTEGER, INTENT(IN) :: priority
+	INTEGER, INTENT(OUT) :: numAcquisitions
+	REAL(8), INTENT(OUT) :: totalWait, maxWait, totalHold, maxHold
+	END SUBROUTINE
+
+	SUBROUTINE offm_getlockhistograms(priority, waitHist, holdHist)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_getlockhistograms
+	INTEGER, INTENT(IN) :: priority
+	INTEGER, INTENT(OUT) :: waitHist(*), holdHist(*)
+	END SUBROUTINE
+
+	SUBROUTINE offm_resetlockstats()
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: offm_resetlockstats
+	END SUBROUTINE
+
 ! ReferenceFrame functions
 
 	SUBROUTINE offrame_activate(name)
@@ -845,6 +1048,28 @@
 	LOGICAL, INTENT(IN) :: autoinform
 	END SUBROUTINE
 
+	SUBROUTINE oftraj_setlockstatsenabled(enable)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: oftraj_setlockstatsenabled
+	LOGICAL, INTENT(IN) :: enable
+	END SUBROUTINE
+
+	SUBROUTINE oftraj_getlockstats(lockType, numAcquisitions, totalWait, maxWait, totalHold, maxHold)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: oftraj_getlockstats
+	INTEGER, INTENT(IN) :: lockType
+	INTEGER, INTENT(OUT) :: numAcquisitions
+	REAL(8), INTENT(OUT) :: totalWait, maxWait, totalHold, maxHold
+	END SUBROUTINE
+
+	SUBROUTINE oftraj_getlockhistograms(lockType, waitHist, holdHist)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: oftraj_getlockhistograms
+	INTEGER, INTENT(IN) :: lockType
+	INTEGER, INTENT(OUT) :: waitHist(*), holdHist(*)
+	END SUBROUTINE
+
+	SUBROUTINE oftraj_resetlockstats()
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: oftraj_resetlockstats
+	END SUBROUTINE
+
 ! TrajectoryArtist functions
 ! A TrajectoryArtist graphically interprets the data contained in a
 ! Trajectory.  Since it is not a ReferenceFrame, it must be attached
@@ -902,6 +1127,12 @@
 	INTEGER(2), INTENT(IN) :: pattern
 	END SUBROUTINE
 
+	SUBROUTINE ofcurveartist_setvertexencoding(encoding, chunkSize, chunkRadius)
+	!DEC$ ATTRIBUTES DLLIMPORT,C,REFERENCE :: ofcurveartist_setvertexencoding
+	INTEGER, INTENT(IN) :: encoding, chunkSize
+	REAL(8), INTENT(IN) :: chunkRadius
+	END SUBROUTINE
+
 ! SegmentArtist functions
 
 	SUBROUTINE ofsegmentartist_create(name)
@@ -19,6 +19,7 @@
  */
 
 #include <OpenFrames/RadialPlane.hpp>
+#include <OpenFrames/DepthPartitioner.hpp>
 #include <osg/Geometry>
 #include <osg/LineWidth>
 #include <osg/PolygonOffset>
@@ -80,9 +81,11 @@ void RadialPlane::init()
 	planeSS->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
 	linesSS->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
 
-	// Enable standard color blending and transparency
+	// Enable standard color blending and transparency, accumulating alpha
+	// as coverage for reversed-depth rendering
 	osg::BlendFunc *bf = new osg::BlendFunc();
-	bf->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
+	bf->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA,
+	                osg::BlendFunc::ONE, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
 	planeSS->setAttributeAndModes(bf);
 	planeSS->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
 	linesSS->setAttributeAndModes(bf);
@@ -100,6 +103,18 @@ void RadialPlane::init()
 	osg::PolygonOffset *offset = new osg::PolygonOffset(1, 1);
 	planeSS->setAttributeAndModes(offset);
 
+	// With reversed depth, farther fragments have smaller depth values, so
+	// flip the depth test and the plane's offset
+	osg::Depth *reversedDepth = new osg::Depth(osg::Depth::GEQUAL);
+	reversedDepth->setWriteMask(false);
+	osg::StateSet *reversedPlaneSS = new osg::StateSet;
+	reversedPlaneSS->setAttribute(reversedDepth, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+	reversedPlaneSS->setAttribute(new osg::PolygonOffset(-1, -1), osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+	_planeGeode->setCullCallback(new ReversedZStateCallback(reversedPlaneSS));
+	osg::StateSet *reversedLinesSS = new osg::StateSet;
+	reversedLinesSS->setAttribute(reversedDepth, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+	_linesGeode->setCullCallback(new ReversedZStateCallback(reversedLinesSS));
+
 	// Create a geometry drawable for the radial circles & longitudinal
 	// lines, and another one for the 0-degree longitude line.
 	// Note that the geometry drawables for the actual plane itself
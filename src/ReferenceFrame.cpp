@@ -20,7 +20,7 @@
 
 #include <OpenFrames/ReferenceFrame.hpp>
 #include <OpenFrames/FrameTransform.hpp>
-#include <OpenFrames/DescendantTracker.hpp>
+#include <OpenFrames/FrameTracker.hpp>
 #include <OpenFrames/Vector.hpp>
 
 #include <osg/Geode>
@@ -28,6 +28,7 @@
 #include <osg/ShapeDrawable>
 #include <osgDB/FileNameUtils>
 #include <osgText/Text>
+#include <algorithm>
 
 #ifdef _OF_VERBOSE_
 #include <iostream>
@@ -70,9 +71,14 @@ ReferenceFrame::~ReferenceFrame()
 	std::cout<< "~ReferenceFrame() for " << _name << std::endl;
 #endif
 
-	  // Remove each child from our child list
+	  // Axes and labels won't be created after this frame is gone
+	if (_axes.valid()) _axes->setUpdateCallback(nullptr);
+	if (_labels.valid()) _labels->setUpdateCallback(nullptr);
+
+	  // Remove each child from our child list, starting from the back
+	  // so that the remaining children don't need to be reindexed
 	while( !_children.empty() )
-	  removeChild( _children.front().get() );
+	  removeChild( _children.back().get() );
 
 #ifdef _OF_VERBOSE_
 	  // This should never evaluate true, since removeChild() should have told
@@ -84,90 +90,66 @@ ReferenceFrame::~ReferenceFrame()
 #endif
 }
 
-void ReferenceFrame::_init( const std::string &name, const osg::Vec4& c )
-{
-	  // Create the transform for this frame
-	_xform = new FrameTransform; 
-
-	  // Create x, y, and z axis vectors
-	_xAxis = new Vector(osg::X_AXIS);
-	_yAxis = new Vector(osg::Y_AXIS);
-	_zAxis = new Vector(osg::Z_AXIS);
-  
-	// Create labels
-	_xLabel = new osgText::Text;
-	_yLabel = new osgText::Text;
-	_zLabel = new osgText::Text;
-  _nameLabel = new osgText::Text;
-
-	// Make sure the labels will always be facing the screen
-	_xLabel->setAxisAlignment(osgText::Text::SCREEN);
-	_yLabel->setAxisAlignment(osgText::Text::SCREEN);
-	_zLabel->setAxisAlignment(osgText::Text::SCREEN);
-  _nameLabel->setAxisAlignment(osgText::Text::SCREEN);
-
-	// X/Y/Z label text size grows as the text gets closer, but is limited to a maximum size (fontResolution)
-	_xLabel->setCharacterSizeMode(osgText::Text::OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT);
-	_yLabel->setCharacterSizeMode(osgText::Text::OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT);
-	_zLabel->setCharacterSizeMode(osgText::Text::OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT);
-  
-  // Name label text is constant size regardless of distance from viewer
-  _nameLabel->setCharacterSizeMode(osgText::Text::SCREEN_COORDS);
+  /** Creates a frame's axes or labels the first time their geode is visited
+      during an update traversal. This is not ref'd by the frame's geodes when
+      they are hidden, so hidden decorations are never created. */
+  class ReferenceFrame::DecorationCallback : public osg::Callback
+  {
+  public:
+    DecorationCallback(const ReferenceFrame *frame) : _frame(frame) {}
 
-  // Sets how "smooth" the text looks ... larger resolution looks nicer, but takes up more memory
-  // Also sets the maximum height of the font when it grows with distance
-  setLabelSize(20.0);
+    virtual bool run(osg::Object* object, osg::Object* data)
+    {
+      // Creating decorations removes this callback from its geode, so
+      // keep it alive until the traversal is complete
+      osg::ref_ptr<osg::Callback> keepAlive = this;
 
-  // Set label font
-  setLabelFont("arial.ttf");
+      if (object == _frame->_axes.get()) _frame->_createAxes();
+      else if (object == _frame->_labels.get()) _frame->_createLabels();
 
-  // Set label text
-  _xLabel->setText("X");
-  _yLabel->setText("Y");
-  _zLabel->setText("Z");
-  _nameLabel->setText(name);
+      return traverse(object, data);
+    }
 
-	// Create groups to which axes & labels will be added
-	_axes = new osg::Geode;
-    _labels = new osg::Geode;
-	_xform->addChild(_axes.get());
-    _xform->addChild(_labels.get());
+  protected:
+    // Not ref'd since the frame removes this callback in its destructor
+    const ReferenceFrame *_frame;
+  };
 
-    // Add axes and labels to their groups
-    _axes->addDrawable(_xAxis->getVector());
-    _axes->addDrawable(_yAxis->getVector());
-    _axes->addDrawable(_zAxis->getVector());
-    _labels->addDrawable(_xLabel);
-    _labels->addDrawable(_yLabel);
-    _labels->addDrawable(_zLabel);
-    _labels->addDrawable(_nameLabel);
+void ReferenceFrame::_init( const std::string &name, const osg::Vec4& c )
+{
+	  // Create the transform for this frame
+	_xform = new FrameTransform; 
 
-	setName(name); // Set the name of this ReferenceFrame
+	  // Axes and labels are created when they are first used, so only
+	  // store their default properties here
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+	  _axisParams[i]._base.set(0.0, 0.0, 0.0); // At the origin
+	  _axisParams[i]._length = 1.0;            // With a length of 1.0
+	  _axisParams[i]._headRatio = 0.3;
+	  _axisParams[i]._bodyRadius = 0.05;
+	  _axisParams[i]._headRadius = 0.1;
+	}
+	_color = c;
+	_axesLabelText[0] = "X";
+	_axesLabelText[1] = "Y";
+	_axesLabelText[2] = "Z";
 
-	setColor(c); // Set the axes' color
+	// Sets how "smooth" the text looks ... larger resolution looks nicer, but takes up more memory
+	// Also sets the maximum height of the font when it grows with distance
+	_labelSize = 20;
+	_labelFont = "arial.ttf";
 
-	// Appropriately position the axes and labels
-	moveXAxis(osg::Vec3d(), 1.0); // At the origin, with a length of 1.0
-	moveYAxis(osg::Vec3d(), 1.0);
-	moveZAxis(osg::Vec3d(), 1.0);
+	setName(name); // Set the name of this ReferenceFrame
 
 	// Show the axes and labels
-	showAxes(X_AXIS | Y_AXIS | Z_AXIS); // Show all axes
-	showAxesLabels(X_AXIS | Y_AXIS | Z_AXIS); // Show all axes labels
-	showNameLabel(true); // Show the frame's name label
-
-	// Disable culling on the axes and labels
-	_axes->setCullingActive(false);
-    _labels->setCullingActive(false);
-
-	// Rescale axes normals in case we have scales in the scene
-	_axes->getOrCreateStateSet()->setMode( GL_RESCALE_NORMAL, osg::StateAttribute::ON );
-
-    // Disable lighting for labels
-    _labels->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+	_axesShown = X_AXIS | Y_AXIS | Z_AXIS; // Show all axes
+	_axesLabelsShown = X_AXIS | Y_AXIS | Z_AXIS; // Show all axes labels
+	_nameLabelShown = true; // Show the frame's name label
+	_updateDecorations();
 }
 
-  void ReferenceFrame::_resetTextGlyphs()
+  void ReferenceFrame::_resetTextGlyphs() const
   {
     // Some graphics drivers have a bug where text can't be properly changed.
     // Get around this by initializing text using all likely characters.
@@ -186,25 +168,172 @@ void ReferenceFrame::_init( const std::string &name, const osg::Vec4& c )
     _zLabel->setText(dummyText);
     _nameLabel->setText(dummyText);
   }
+
+  void ReferenceFrame::_updateDecorations()
+  {
+    if (!_decorationCallback.valid()) _decorationCallback = new DecorationCallback(this);
+
+    // Axes geode is needed if any axis is shown
+    if (_axesShown != NO_AXES)
+    {
+      if (!_axes.valid())
+      {
+        _axes = new osg::Geode;
+        _axes->setName(_name + " axes");
+        _axes->setCullingActive(false); // Disable culling on the axes
+        _xform->addChild(_axes.get());
+      }
+      _axes->setNodeMask(enabled);
+
+      // Create axes vectors during the next update traversal
+      if (!_xAxis.valid()) _axes->setUpdateCallback(_decorationCallback.get());
+    }
+    else if (_axes.valid())
+    {
+      if (_xAxis.valid()) _axes->setNodeMask(disabled); // Keep axes in case they are shown again
+      else
+      {
+        // Axes were never used, so remove their geode
+        _xform->removeChild(_axes.get());
+        _axes = nullptr;
+      }
+    }
+
+    // Labels geode is needed if any axis label or the name label is shown
+    if ((_axesLabelsShown != NO_AXES) || _nameLabelShown)
+    {
+      if (!_labels.valid())
+      {
+        _labels = new osg::Geode;
+        _labels->setName(_name + " labels");
+        _labels->setCullingActive(false); // Disable culling on the labels
+        _xform->addChild(_labels.get());
+      }
+      _labels->setNodeMask(enabled);
+
+      // Create label text during the next update traversal
+      if (!_nameLabel.valid()) _labels->setUpdateCallback(_decorationCallback.get());
+    }
+    else if (_labels.valid())
+    {
+      if (_nameLabel.valid()) _labels->setNodeMask(disabled); // Keep labels in case they are shown again
+      else
+      {
+        // Labels were never used, so remove their geode
+        _xform->removeChild(_labels.get());
+        _labels = nullptr;
+      }
+    }
+  }
+
+  void ReferenceFrame::_createAxes() const
+  {
+    if (_xAxis.valid() || !_axes.valid()) return;
+
+    // Create x, y, and z axis vectors
+    _xAxis = new Vector(osg::X_AXIS);
+    _yAxis = new Vector(osg::Y_AXIS);
+    _zAxis = new Vector(osg::Z_AXIS);
+
+    // Appropriately position and color the axes
+    for (unsigned int i = 0; i < 3; ++i) _applyAxis(i);
+
+    // Add axes to their group
+    _axes->addDrawable(_xAxis->getVector());
+    _axes->addDrawable(_yAxis->getVector());
+    _axes->addDrawable(_zAxis->getVector());
+
+    // Rescale axes normals in case we have scales in the scene
+    _axes->getOrCreateStateSet()->setMode( GL_RESCALE_NORMAL, osg::StateAttribute::ON );
+
+    // Axes no longer need to be created
+    _axes->setUpdateCallback(nullptr);
+  }
+
+  void ReferenceFrame::_createLabels() const
+  {
+    if (_nameLabel.valid() || !_labels.valid()) return;
+
+    // Create labels
+    _xLabel = new osgText::Text;
+    _yLabel = new osgText::Text;
+    _zLabel = new osgText::Text;
+    _nameLabel = new osgText::Text;
+
+    // Make sure the labels will always be facing the screen
+    _xLabel->setAxisAlignment(osgText::Text::SCREEN);
+    _yLabel->setAxisAlignment(osgText::Text::SCREEN);
+    _zLabel->setAxisAlignment(osgText::Text::SCREEN);
+    _nameLabel->setAxisAlignment(osgText::Text::SCREEN);
+
+    // X/Y/Z label text size grows as the text gets closer, but is limited to a maximum size (fontResolution)
+    _xLabel->setCharacterSizeMode(osgText::Text::OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT);
+    _yLabel->setCharacterSizeMode(osgText::Text::OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT);
+    _zLabel->setCharacterSizeMode(osgText::Text::OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT);
+
+    // Name label text is constant size regardless of distance from viewer
+    _nameLabel->setCharacterSizeMode(osgText::Text::SCREEN_COORDS);
+
+    // Set label size and font
+    _applyLabelSize();
+    _applyLabelFont();
+
+    // Set label text
+    _xLabel->setText(_axesLabelText[0]);
+    _yLabel->setText(_axesLabelText[1]);
+    _zLabel->setText(_axesLabelText[2]);
+    _nameLabel->setText(_name);
+
+    // Set label color
+    _xLabel->setColor(_color);
+    _yLabel->setColor(_color);
+    _zLabel->setColor(_color);
+    _nameLabel->setColor(_color);
+
+    // Appropriately show and position the labels
+    _applyLabelVisibility();
+    _applyLabelPositions();
+
+    // Add labels to their group
+    _labels->addDrawable(_xLabel);
+    _labels->addDrawable(_yLabel);
+    _labels->addDrawable(_zLabel);
+    _labels->addDrawable(_nameLabel);
+
+    // Disable lighting for labels
+    _labels->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+    // Labels no longer need to be created
+    _labels->setUpdateCallback(nullptr);
+  }
   
   void ReferenceFrame::setName( const std::string& name )
   {
     _name = name;
-    _nameLabel->setText(name);
-    _axes->setName(_name + " axes");
-    _labels->setName(_name + " labels");
+    if (_nameLabel.valid()) _nameLabel->setText(name);
+    if (_axes.valid()) _axes->setName(_name + " axes");
+    if (_labels.valid()) _labels->setName(_name + " labels");
     _xform->setName(_name + " transform");
   }
 
 void ReferenceFrame::setColor( const osg::Vec4 &color )
 {
-	_xAxis->getVector()->setColor(color);
-	_yAxis->getVector()->setColor(color);
-	_zAxis->getVector()->setColor(color);
-	_xLabel->setColor(color);
-	_yLabel->setColor(color);
-	_zLabel->setColor(color);
-	_nameLabel->setColor(color);
+	_color = color;
+
+	if (_xAxis.valid())
+	{
+	  _xAxis->getVector()->setColor(color);
+	  _yAxis->getVector()->setColor(color);
+	  _zAxis->getVector()->setColor(color);
+	}
+
+	if (_nameLabel.valid())
+	{
+	  _xLabel->setColor(color);
+	  _yLabel->setColor(color);
+	  _zLabel->setColor(color);
+	  _nameLabel->setColor(color);
+	}
 }
 
   void ReferenceFrame::setColor( float r, float g, float b, float a )
@@ -214,7 +343,7 @@ void ReferenceFrame::setColor( const osg::Vec4 &color )
 
   const osg::Vec4& ReferenceFrame::getColor() const
   {
-    return _xAxis->getVector()->getColor();
+    return _color;
   }
 
   void ReferenceFrame::getColor(float &r, float &g, float &b, float &a) const
@@ -235,12 +364,21 @@ void ReferenceFrame::setColor( const osg::Vec4 &color )
 const osg::BoundingSphere& ReferenceFrame::getBound() const
 {
 	_bound.init();
-    if (_xAxis->getVector()->getNodeMask() != 0x0)
-	  _bound.expandBy(_xAxis->getVector()->getBound());
-    if (_yAxis->getVector()->getNodeMask() != 0x0)
-	  _bound.expandBy(_yAxis->getVector()->getBound());
-    if (_zAxis->getVector()->getNodeMask() != 0x0)
-	  _bound.expandBy(_zAxis->getVector()->getBound());
+
+	  // Compute bounds of shown axes from their stored geometry, since the
+	  // axes may not have been created yet. Each axis is bounded by a sphere
+	  // around its centerline, padded by its largest radius.
+	static const unsigned int axisTypes[3] = {X_AXIS, Y_AXIS, Z_AXIS};
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+	  if (!(_axesShown & axisTypes[i])) continue;
+
+	  const AxisParams &params = _axisParams[i];
+	  osg::Vec3d dir;
+	  dir[i] = 0.5*params._length;
+	  double radius = 0.5*params._length + std::max(params._bodyRadius, params._headRadius);
+	  _bound.expandBy(osg::BoundingSphere(params._base + dir, radius));
+	}
 
 	return _bound;
 }
@@ -248,136 +386,165 @@ const osg::BoundingSphere& ReferenceFrame::getBound() const
   void ReferenceFrame::showAxes(unsigned int axes)
   { 
     // Disable entire axes geode if there's nothing to show
-    if (axes == NO_AXES) _axes->setNodeMask(disabled);
-    else _axes->setNodeMask(enabled);
+    _axesShown = axes;
+    _updateDecorations();
 
-    if (axes & X_AXIS) // Need to enable x-axis
-      _xAxis->getVector()->setNodeMask(enabled);
-    else
-      _xAxis->getVector()->setNodeMask(disabled);
-
-    if (axes & Y_AXIS) // Need to enable y-axis
-      _yAxis->getVector()->setNodeMask(enabled);
-    else
-      _yAxis->getVector()->setNodeMask(disabled);
-
-    if (axes & Z_AXIS) // Need to enable z-axis
-      _zAxis->getVector()->setNodeMask(enabled);
-    else
-      _zAxis->getVector()->setNodeMask(disabled);
-	
-    // Reposition axes labels
-    moveXAxis(_xAxis->getBasePosition(), _xAxis->getTotalLength());
-    moveYAxis(_yAxis->getBasePosition(), _yAxis->getTotalLength());
-    moveZAxis(_zAxis->getBasePosition(), _zAxis->getTotalLength());
+    // Enable/disable individual axes and reposition axes labels
+    moveXAxis(_axisParams[0]._base, _axisParams[0]._length);
+    moveYAxis(_axisParams[1]._base, _axisParams[1]._length);
+    moveZAxis(_axisParams[2]._base, _axisParams[2]._length);
   }
 
 void ReferenceFrame::showAxesLabels(unsigned int labels)
 {
   // Disable entire label geode if there's nothing to show
-  if ((labels == NO_AXES) && (_nameLabel->getNodeMask() == disabled)) _labels->setNodeMask(disabled);
-  else _labels->setNodeMask(enabled);
-
-  // Enable x-label
-  if (labels & X_AXIS) _xLabel->setNodeMask(enabled);
-  else _xLabel->setNodeMask(disabled);
-
-  // Enable y-label
-  if (labels & Y_AXIS) _yLabel->setNodeMask(enabled);
-  else _yLabel->setNodeMask(disabled);
+  _axesLabelsShown = labels;
+  _updateDecorations();
 
-  // Enable z-label
-  if (labels & Z_AXIS) _zLabel->setNodeMask(enabled);
-  else _zLabel->setNodeMask(disabled);
+  // Enable individual labels
+  if (_nameLabel.valid()) _applyLabelVisibility();
 
   // Reposition z-axis label
-  double bodyLen, headLen, bodyRadius, headRadius;
-  _zAxis->getLength(bodyLen, headLen);
-  _zAxis->getRadius(bodyRadius, headRadius);
-  double totalLen = bodyLen + headLen;
-  moveZAxis(_zAxis->getBasePosition(), totalLen, headLen/totalLen, bodyRadius, headRadius);
+  const AxisParams &z = _axisParams[2];
+  moveZAxis(z._base, z._length, z._headRatio, z._bodyRadius, z._headRadius);
 }
 
   void ReferenceFrame::showNameLabel(bool show)
   {
     // Disable entire label geode if there's nothing to show
-    if (!show && ((_xLabel->getNodeMask() | _yLabel->getNodeMask() | _zLabel->getNodeMask()) == disabled))
-        _labels->setNodeMask(disabled);
-    else
-        _labels->setNodeMask(enabled);
+    _nameLabelShown = show;
+    _updateDecorations();
 
     // Enable name label
-    if (show) _nameLabel->setNodeMask(enabled);
-    else _nameLabel->setNodeMask(disabled);
+    if (_nameLabel.valid()) _applyLabelVisibility();
   }
 
   void ReferenceFrame::moveXAxis(osg::Vec3d base, double len, double headRatio, double bodyRadius, double headRadius) const
   {
-    bool xexists = (_xAxis->getVector()->getNodeMask() == enabled);
+    _moveAxis(0, base, len, headRatio, bodyRadius, headRadius);
+  }
+
+  void ReferenceFrame::moveYAxis(osg::Vec3d base, double len, double headRatio, double bodyRadius, double headRadius) const
+  {
+    _moveAxis(1, base, len, headRatio, bodyRadius, headRadius);
+  }
+
+  void ReferenceFrame::moveZAxis(osg::Vec3d base, double len, double headRatio, double bodyRadius, double headRadius) const
+  {
+    _moveAxis(2, base, len, headRatio, bodyRadius, headRadius);
+  }
 
+  void ReferenceFrame::_moveAxis(unsigned int axis, const osg::Vec3d &base, double len, double headRatio, double bodyRadius, double headRadius) const
+  {
     if (headRatio <= 0.0 || headRatio >= 1.0) headRatio = 0.3;
     if (bodyRadius <= 0.0) bodyRadius = 0.05*len;
     if (headRadius <= 0.0) headRadius = 0.1*len;
 
-    _xAxis->setBasePosition(base);
-    _xAxis->setLength((1.0-headRatio)*len, headRatio*len);
-    _xAxis->setRadius(bodyRadius, headRadius);
+    AxisParams &params = _axisParams[axis];
+    params._base = base;
+    params._length = len;
+    params._headRatio = headRatio;
+    params._bodyRadius = bodyRadius;
+    params._headRadius = headRadius;
 
-    _xLabel->setCharacterSize(0.4*len);
-    if (xexists) _xLabel->setPosition(base + osg::Vec3d(len, 0, 0));
-    else _xLabel->setPosition(base);
+    if (_xAxis.valid()) _applyAxis(axis);
+    if (_nameLabel.valid()) _applyLabelPositions();
   }
 
-  void ReferenceFrame::moveYAxis(osg::Vec3d base, double len, double headRatio, double bodyRadius, double headRadius) const
+  void ReferenceFrame::_applyAxis(unsigned int axis) const
   {
-    bool yexists = (_yAxis->getVector()->getNodeMask() == enabled);
-
-    if (headRatio <= 0.0 || headRatio >= 1.0) headRatio = 0.3;
-    if (bodyRadius <= 0.0) bodyRadius = 0.05*len;
-    if (headRadius <= 0.0) headRadius = 0.1*len;
+    static const unsigned int axisTypes[3] = {X_AXIS, Y_AXIS, Z_AXIS};
+    Vector *vec = (axis == 0) ? _xAxis.get() : ((axis == 1) ? _yAxis.get() : _zAxis.get());
+    const AxisParams &params = _axisParams[axis];
 
-    _yAxis->setBasePosition(base);
-    _yAxis->setLength((1.0-headRatio)*len, headRatio*len);
-    _yAxis->setRadius(bodyRadius, headRadius);
+    vec->setBasePosition(params._base);
+    vec->setLength((1.0 - params._headRatio)*params._length, params._headRatio*params._length);
+    vec->setRadius(params._bodyRadius, params._headRadius);
+    vec->getVector()->setColor(_color);
 
-    _yLabel->setCharacterSize(0.4*len);
-    if (yexists) _yLabel->setPosition(base + osg::Vec3d(0, len, 0));
-    else _yLabel->setPosition(base);
+    if (_axesShown & axisTypes[axis]) vec->getVector()->setNodeMask(enabled);
+    else vec->getVector()->setNodeMask(disabled);
   }
 
-  void ReferenceFrame::moveZAxis(osg::Vec3d base, double len, double headRatio, double bodyRadius, double headRadius) const
+  void ReferenceFrame::_applyLabelVisibility() const
   {
-    bool zaxisexists = (_zAxis->getVector()->getNodeMask() == enabled);
-    bool zlabelexists = (_zLabel->getNodeMask() == enabled);
+    // Enable x-label
+    if (_axesLabelsShown & X_AXIS) _xLabel->setNodeMask(enabled);
+    else _xLabel->setNodeMask(disabled);
 
-    if (headRatio <= 0.0 || headRatio >= 1.0) headRatio = 0.3;
-    if (bodyRadius <= 0.0) bodyRadius = 0.05*len;
-    if (headRadius <= 0.0) headRadius = 0.1*len;
+    // Enable y-label
+    if (_axesLabelsShown & Y_AXIS) _yLabel->setNodeMask(enabled);
+    else _yLabel->setNodeMask(disabled);
 
-    _zAxis->setBasePosition(base);
-    _zAxis->setLength((1.0 - headRatio)*len, headRatio*len);
-    _zAxis->setRadius(bodyRadius, headRadius);
+    // Enable z-label
+    if (_axesLabelsShown & Z_AXIS) _zLabel->setNodeMask(enabled);
+    else _zLabel->setNodeMask(disabled);
 
-    _zLabel->setCharacterSize(0.4*len);
-    if (zaxisexists)
+    // Enable name label
+    if (_nameLabelShown) _nameLabel->setNodeMask(enabled);
+    else _nameLabel->setNodeMask(disabled);
+  }
+
+  void ReferenceFrame::_applyLabelPositions() const
+  {
+    // Axes labels are placed at the tip of each shown axis, or at its base otherwise
+    const AxisParams &x = _axisParams[0];
+    _xLabel->setCharacterSize(0.4*x._length);
+    if (_axesShown & X_AXIS) _xLabel->setPosition(x._base + osg::Vec3d(x._length, 0, 0));
+    else _xLabel->setPosition(x._base);
+
+    const AxisParams &y = _axisParams[1];
+    _yLabel->setCharacterSize(0.4*y._length);
+    if (_axesShown & Y_AXIS) _yLabel->setPosition(y._base + osg::Vec3d(0, y._length, 0));
+    else _yLabel->setPosition(y._base);
+
+    // Name label is placed above the z-axis label
+    const AxisParams &z = _axisParams[2];
+    bool zlabelexists = (_axesLabelsShown & Z_AXIS);
+    _zLabel->setCharacterSize(0.4*z._length);
+    if (_axesShown & Z_AXIS)
     {
-      _zLabel->setPosition(base + osg::Vec3d(0, 0, len));
+      _zLabel->setPosition(z._base + osg::Vec3d(0, 0, z._length));
       if (zlabelexists)
-        _nameLabel->setPosition(base + osg::Vec3d(0, 0, 1.5*len));
+        _nameLabel->setPosition(z._base + osg::Vec3d(0, 0, 1.5*z._length));
       else
-        _nameLabel->setPosition(base + osg::Vec3d(0, 0, len));
+        _nameLabel->setPosition(z._base + osg::Vec3d(0, 0, z._length));
     }
     else
     {
-      _zLabel->setPosition(base);
+      _zLabel->setPosition(z._base);
       if (zlabelexists)
-        _nameLabel->setPosition(base + osg::Vec3d(0, 0, 0.5*len));
+        _nameLabel->setPosition(z._base + osg::Vec3d(0, 0, 0.5*z._length));
       else
-        _nameLabel->setPosition(base);
+        _nameLabel->setPosition(z._base);
     }
   }
 
+  void ReferenceFrame::setXLabel(const std::string &str)
+  {
+    _axesLabelText[0] = str;
+    if (_xLabel.valid()) _xLabel->setText(str);
+  }
+
+  void ReferenceFrame::setYLabel(const std::string &str)
+  {
+    _axesLabelText[1] = str;
+    if (_yLabel.valid()) _yLabel->setText(str);
+  }
+
+  void ReferenceFrame::setZLabel(const std::string &str)
+  {
+    _axesLabelText[2] = str;
+    if (_zLabel.valid()) _zLabel->setText(str);
+  }
+
   void ReferenceFrame::setLabelFont(const std::string &font)
+  {
+    _labelFont = font;
+    if (_nameLabel.valid()) _applyLabelFont();
+  }
+
+  void ReferenceFrame::_applyLabelFont() const
   {
     // Save current label text
     std::string prevXLabel = _xLabel->getText().createUTF8EncodedString();
@@ -392,10 +559,10 @@ void ReferenceFrame::showAxesLabels(unsigned int labels)
     _nameLabel->setText("");
 
     // Set the new font
-    _xLabel->setFont(font);
-    _yLabel->setFont(font);
-    _zLabel->setFont(font);
-    _nameLabel->setFont(font);
+    _xLabel->setFont(_labelFont);
+    _yLabel->setFont(_labelFont);
+    _zLabel->setFont(_labelFont);
+    _nameLabel->setFont(_labelFont);
     
     // Initialize text with all printable characters to support older graphics drivers
     _resetTextGlyphs();
@@ -414,24 +581,74 @@ void ReferenceFrame::showAxesLabels(unsigned int labels)
   
   std::string ReferenceFrame::getLabelFontPath() const
   {
-    const osgText::Font* font = _xLabel->getFont();
-    std::string fontFile = font ? font->getFileName() : "default";
-    return fontFile;
+    if (_xLabel.valid())
+    {
+      const osgText::Font* font = _xLabel->getFont();
+      std::string fontFile = font ? font->getFileName() : "default";
+      return fontFile;
+    }
+
+    // Labels load their font when they are created, so until then
+    // search for the font file without loading it
+    std::string fontFile = osgText::findFontFile(_labelFont);
+    return fontFile.empty() ? "default" : fontFile;
   }
   
   void ReferenceFrame::setLabelSize(unsigned int size)
+  {
+    _labelSize = size;
+    if (_nameLabel.valid()) _applyLabelSize();
+  }
+
+  void ReferenceFrame::_applyLabelSize() const
   {
     // Set size for axes labels (treated as maximum size)
-    _xLabel->setFontResolution(size, size);
-    _yLabel->setFontResolution(size, size);
-    _zLabel->setFontResolution(size, size);
+    _xLabel->setFontResolution(_labelSize, _labelSize);
+    _yLabel->setFontResolution(_labelSize, _labelSize);
+    _zLabel->setFontResolution(_labelSize, _labelSize);
     
     // Set size for name label (treated as fixed size)
-    _nameLabel->setFontResolution(size, size);
-    _nameLabel->setCharacterSize(size);
+    _nameLabel->setFontResolution(_labelSize, _labelSize);
+    _nameLabel->setCharacterSize(_labelSize);
   }
   
 bool ReferenceFrame::addChild( ReferenceFrame* child )
+{
+	  // A child without children can't be an ancestor of this frame,
+	  // so ancestors are only needed to prevent loops otherwise
+	FrameSet ancestors;
+	if ((child != nullptr) && !child->_children.empty()) _getAncestors(ancestors);
+
+	return _addChild(child, ancestors);
+}
+
+unsigned int ReferenceFrame::addChildren( const std::vector<ReferenceFrame*> &frames )
+{
+	  // Adding children doesn't change this frame's ancestors, so they
+	  // only need to be computed once for all children
+	FrameSet ancestors;
+	for (auto frame : frames)
+	{
+	  if ((frame != nullptr) && !frame->_children.empty())
+	  {
+	    _getAncestors(ancestors);
+	    break;
+	  }
+	}
+
+	_children.reserve(_children.size() + frames.size());
+	_childIndices.reserve(_childIndices.size() + frames.size());
+
+	unsigned int numAdded = 0;
+	for (auto frame : frames)
+	{
+	  if (_addChild(frame, ancestors)) ++numAdded;
+	}
+
+	return numAdded;
+}
+
+bool ReferenceFrame::_addChild( ReferenceFrame* child, const FrameSet &ancestors )
 {
 	  // Make sure we're not trying to add ourselves as a child
 	  // Also make sure child is not NULL
@@ -442,8 +659,7 @@ bool ReferenceFrame::addChild( ReferenceFrame* child )
 
 	  // Check to see if we are a descendant of the child.
 	  // This case would cause a loop in the tree structure.
-	osg::ref_ptr<DescendantTracker> dt = new DescendantTracker(child);
-	if (dt->trackDescendant(this)) 
+	if (ancestors.count(child) > 0)
 	{
 #ifdef _OF_VERBOSE_
 	  std::cout<< "ReferenceFrame ERROR: Trying to add child "
@@ -452,12 +668,6 @@ bool ReferenceFrame::addChild( ReferenceFrame* child )
 	      << child->getName() << "!" << std::endl;
 #endif
 
-	    // Remove the child from the tracker without deleting it in case
-	    // the child is still being used somewhere else.
-	  osg::ref_ptr<ReferenceFrame> temp = child;
-	  dt->setRoot(NULL);
-	  temp.release(); 
-
 	  return false;
 	}
 
@@ -468,6 +678,7 @@ bool ReferenceFrame::addChild( ReferenceFrame* child )
 	_xform->addChild(child->getGroup());
 
 	  // Add child to this frame
+	_childIndices[child] = _children.size();
 	_children.push_back(child);
 
 	  // Tell each tracker that the child was added to this frame.
@@ -478,6 +689,22 @@ bool ReferenceFrame::addChild( ReferenceFrame* child )
 	return true;
 }
 
+void ReferenceFrame::_getAncestors( FrameSet &ancestors ) const
+{
+	  // Search upwards through all parents, visiting each frame once
+	std::vector<const ReferenceFrame*> toVisit(1, this);
+	ancestors.insert(this);
+	while (!toVisit.empty())
+	{
+	  const ReferenceFrame* frame = toVisit.back();
+	  toVisit.pop_back();
+	  for (auto parent : frame->_parents)
+	  {
+	    if (ancestors.insert(parent).second) toVisit.push_back(parent);
+	  }
+	}
+}
+
 bool ReferenceFrame::removeChild( ReferenceFrame* child )
 {
 	int index = getChildIndex(child);
@@ -496,6 +723,12 @@ bool ReferenceFrame::removeChild( ReferenceFrame* child )
 	osg::ref_ptr<ReferenceFrame> temp = child;
 	_children.erase(_children.begin() + index);
 
+	  // Reindex children that followed the removed child
+	_childIndices.erase(child);
+	int num__children = _children.size();
+	for(int i = index; i < num__children; ++i)
+	  _childIndices[_children[i].get()] = i;
+
 	  // Inform _trackers about child's removal
 	int num__trackers = _trackers.size();
 	for(int i = 0; i < num__trackers; ++i)
@@ -581,57 +814,71 @@ std::string ReferenceFrame::frameInfo() const
 
     void ReferenceFrame::addParent( ReferenceFrame* frame )
     {
-      if ( getParentIndex(frame) == -1 ) _parents.push_back(frame);
+      if ( getParentIndex(frame) == -1 )
+      {
+        _parentIndices[frame] = _parents.size();
+        _parents.push_back(frame);
+      }
     }
 
     void ReferenceFrame::removeParent( ReferenceFrame* frame )
     {
       int index = getParentIndex(frame);
-      if ( index != -1 ) _parents.erase(_parents.begin() + index);
+      if ( index != -1 )
+      {
+        _parents.erase(_parents.begin() + index);
+
+        // Reindex parents that followed the removed parent
+        _parentIndices.erase(frame);
+        int num_parents = _parents.size();
+        for (int i = index; i < num_parents; ++i)
+          _parentIndices[_parents[i]] = i;
+      }
     }
 
     void ReferenceFrame::addTracker( FrameTracker* t )
     {
-      if ( getTrackerIndex(t) == -1 ) _trackers.push_back(t);
+      if ( getTrackerIndex(t) == -1 )
+      {
+        _trackerIndices[t] = _trackers.size();
+        _trackers.push_back(t);
+      }
     }
 
     void ReferenceFrame::removeTracker( FrameTracker* t )
     {
       int index = getTrackerIndex(t);
-      if ( index != -1 ) _trackers.erase(_trackers.begin() + index);
+      if ( index != -1 )
+      {
+        _trackers.erase(_trackers.begin() + index);
+
+        // Reindex trackers that followed the removed tracker
+        _trackerIndices.erase(t);
+        int num_trackers = _trackers.size();
+        for (int i = index; i < num_trackers; ++i)
+          _trackerIndices[_trackers[i]] = i;
+      }
     }
 
     int ReferenceFrame::getChildIndex( const ReferenceFrame* frame ) const
     {
-      int num__children = _children.size();
-      for( int i = 0; i < num__children; ++i )
-      if( _children[i] == frame ) return i;
-
-      return -1;
+      FrameIndexMap::const_iterator i = _childIndices.find(frame);
+      if ( i == _childIndices.end() ) return -1;
+      else return i->second;
     }
 
     int ReferenceFrame::getParentIndex(const ReferenceFrame* frame) const
     {
-      int num_parents = _parents.size();
-      for (int i=0; i<num_parents; ++i)
-      {
-        if (_parents[i] == frame)
-          return i;
-      }
-
-      return -1;
+      FrameIndexMap::const_iterator i = _parentIndices.find(frame);
+      if ( i == _parentIndices.end() ) return -1;
+      else return i->second;
     }
 
     int ReferenceFrame::getTrackerIndex( const FrameTracker* frame ) const
     {
-      int num_trackers = _trackers.size();
-      for (int i=0; i<num_trackers; ++i)
-      {
-        if (_trackers[i] == frame)
-          return i;
-      }
-
-      return -1;
+      TrackerIndexMap::const_iterator i = _trackerIndices.find(frame);
+      if ( i == _trackerIndices.end() ) return -1;
+      else return i->second;
     }
 
 } // !namespace OpenFrames
@@ -410,6 +410,39 @@ namespace OpenFrames
     else _borderGeode->setNodeMask(0x0);
   }
   
+  /** Set whether frame timing text is shown or not */
+  void RenderRectangle::setShowFrameTiming(bool show)
+  {
+    if(!_timingGeode.valid())
+    {
+      if(!show) return;
+
+      // Create frame timing text in the top-left corner of the HUD
+      _timingText = new osgText::Text;
+      _timingText->setDataVariance(osg::Object::DYNAMIC); // Text changes while animating
+      _timingText->setColor(osg::Vec4(0.949, 0.427, 0.129, 1));
+      _timingText->setCharacterSizeMode(osgText::Text::SCREEN_COORDS);
+      _timingText->setCharacterSize(16.0);
+      _timingText->setFont("arial.ttf");
+      _timingText->setFontResolution(16, 16);
+      _timingText->setLineSpacing(0.25);
+      _timingText->setAlignment(osgText::Text::LEFT_TOP);
+      _timingText->setPosition(osg::Vec3(0.001, 0.999, 0.0));
+
+      _timingGeode = new osg::Geode;
+      _timingGeode->addDrawable(_timingText);
+      _hudCamera->addChild(_timingGeode);
+    }
+
+    _timingGeode->setNodeMask(show ? 0xffffffff : 0x0);
+  }
+
+  /** Set the frame timing text */
+  void RenderRectangle::setFrameTimingText(const std::string &text)
+  {
+    if(_timingText.valid()) _timingText->setText(text);
+  }
+  
   void RenderRectangle::setSkySphereTexture(const std::string& fname)
   {
     unsigned int currDrawMode = _skySphere->getDrawMode();
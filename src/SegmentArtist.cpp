@@ -125,25 +125,19 @@ private:
 
   void processPoints(unsigned int newNumPoints)
   {
+    // Gather start and end vertices for each new point
+    _points.clear();
     osg::Vec3d startVertex, endVertex;  // Start and end vertices for a point
-    osg::Vec3f high, low;
-
     for (unsigned int i = _numPoints; i < newNumPoints; i += _sa->getStride())
     {
-      // Get start and end vertices for current point
       _traj->getPoint(i, _sa->getStartDataSource(), startVertex._v);
       _traj->getPoint(i, _sa->getEndDataSource(), endVertex._v);
-
-      // Split start vertex into high and low portions to support GPU-based RTE rendering
-      OpenFrames::DS_Split(startVertex, high, low);
-      _vertexHigh->push_back(high);
-      _vertexLow->push_back(low);
-
-      // Split end vertex into high and low portions to support GPU-based RTE rendering
-      OpenFrames::DS_Split(endVertex, high, low);
-      _vertexHigh->push_back(high);
-      _vertexLow->push_back(low);
+      _points.push_back(startVertex);
+      _points.push_back(endVertex);
     }
+
+    // Split vertices into high and low portions to support GPU-based RTE rendering
+    OpenFrames::DS_Append(_points, *_vertexHigh, *_vertexLow);
   }
 
   unsigned int _numPoints;
@@ -153,6 +147,7 @@ private:
   osg::Vec3Array* _vertexHigh;
   osg::Vec3Array* _vertexLow;
   osg::DrawArrays* _drawArrays;
+  std::vector<osg::Vec3d> _points; // Vertices being split into high/low portions
   const Trajectory* _traj;
   SegmentArtist* _sa;
 };
@@ -174,6 +169,7 @@ SegmentArtist::SegmentArtist(const Trajectory *traj)
   _lineWidth = new osg::LineWidth;
   _linePattern = new osg::LineStipple;
   osg::StateSet* stateset = getOrCreateStateSet();
+  stateset->setDataVariance(osg::Object::DYNAMIC); // Line properties can change while drawing
   stateset->setAttribute(_lineWidth.get());
   stateset->setAttributeAndModes(_linePattern.get());
 
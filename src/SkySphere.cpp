@@ -19,9 +19,19 @@
  */
 
 #include <OpenFrames/SkySphere.hpp>
+#include <OpenFrames/TextParser.hpp>
 #include <osg/BlendFunc>
 #include <osg/PointSprite>
+#include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
+#include <osgUtil/CullVisitor>
+#include <sys/stat.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
@@ -72,6 +82,35 @@ static const char *OFSkySphere_FragSource = {
   "}\n"
 };
 
+/**
+ * \class StarTileCallback
+ *
+ * \brief Draws a star tile's child tiles only when the tile is large on screen.
+ *
+ * A tile group's first child contains the tile's own stars, and the
+ * remaining children are its child tiles.
+ */
+class StarTileCallback : public osg::NodeCallback
+{
+public:
+  StarTileCallback(const SkySphere *sky) : _sky(sky) {}
+
+  virtual void operator()(osg::Node *node, osg::NodeVisitor *nv)
+  {
+    osgUtil::CullVisitor *cv = dynamic_cast<osgUtil::CullVisitor*>(nv);
+    osg::Group *group = node->asGroup();
+    if (cv && (group->getNumChildren() > 1) &&
+        (cv->clampedPixelSize(node->getBound()) < _sky->getStarTileRefinePixels()))
+    {
+      group->getChild(0)->accept(*nv); // Only draw this tile's stars
+    }
+    else traverse(node, nv);
+  }
+
+private:
+  const SkySphere *_sky; // SkySphere owns all tiles, so it outlives this callback
+};
+
 SkySphere::SkySphere(const std::string &name)
 : Sphere(name)
 {
@@ -88,6 +127,11 @@ void SkySphere::_init()
   _maxNumStars = 10000;
   _minPixSize = 1.0;
   _maxPixSize = 10.0;
+  _useStarCache = true;
+  _maxStarTileLevel = 12;
+  _maxStarsPerTile = 1024;
+  _starTileRefinePixels = 256.0;
+  for(unsigned int i = 0; i < 6; ++i) _starFaceTiles[i] = -1;
 
   // Hide Sphere's axes and labels
   showAxes(ReferenceFrame::NO_AXES);
@@ -99,6 +143,7 @@ void SkySphere::_init()
 
   // Create new StateSet to specify star-specific OpenGL properties
   osg::StateSet *ss = new osg::StateSet();
+  _starStateSet = ss;
 
   // Create vertex and fragment shaders for stars
   osg::Shader *vertShader = new osg::Shader(osg::Shader::VERTEX, OFSkySphere_VertSource);
@@ -119,28 +164,14 @@ void SkySphere::_init()
   fn->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE);
   ss->setAttributeAndModes(fn);
 
-  // Create the geode that will contain all star bins, and add it directly to
+  // Create the group that will contain all star tiles, and add it directly to
   // this frame's transform. This allows the stars to be drawn in this reference
   // frame, while the textured sphere has its own sub-transform (see Sphere::_sphereXform)
-  _starGeode = new osg::Geode;
-  _starGeode->setName(_name + "_StarBins");
-  _xform->addChild(_starGeode);
-  
-  // Create star bins (osg::Geometries) that will hold sets of stars
-  for(unsigned int i = 0; i < _starBinCount; ++i)
-  {
-    _starBinGeoms[i] = new osg::Geometry;
-    _starBinGeoms[i]->setName("StarFieldDrawable"+std::to_string(i));
-    _starBinGeoms[i]->setStateSet(ss);
-    _starBinGeoms[i]->setUseDisplayList(false);
-    _starBinGeoms[i]->setUseVertexBufferObjects(true);
-    _starBinGeoms[i]->getOrCreateVertexBufferObject()->setUsage(GL_STATIC_DRAW);
-    _starBinGeoms[i]->setVertexArray(new osg::Vec3Array());
-    osg::Vec4Array *colors = new osg::Vec4Array;
-    colors->setBinding(osg::Array::BIND_PER_VERTEX);
-    _starBinGeoms[i]->setColorArray(colors);
-    _starGeode->addDrawable(_starBinGeoms[i]);
-  }
+  // Tiles are created as stars are added to them
+  _starTileRoot = new osg::Group;
+  _starTileRoot->setName(_name + "_StarTiles");
+  _starTileRoot->setStateSet(ss);
+  _xform->addChild(_starTileRoot);
 
   // By default draw both texture and starfield
   setDrawMode(TEXTURE + STARFIELD);
@@ -158,7 +189,7 @@ void SkySphere::setDrawMode(unsigned int drawMode)
   osg::Node::NodeMask starMask;
   if(drawMode & STARFIELD) starMask = 0xffffffff;
   else starMask = 0x0;
-  _starGeode->setNodeMask(starMask);
+  _starTileRoot->setNodeMask(starMask);
 }
 
 unsigned int SkySphere::getDrawMode()
@@ -167,7 +198,7 @@ unsigned int SkySphere::getDrawMode()
   unsigned int useTexture = _geode->getNodeMask() & TEXTURE;
 
   // Check if starfield is drawn
-  unsigned int useStarfield = _starGeode->getNodeMask() & STARFIELD;
+  unsigned int useStarfield = _starTileRoot->getNodeMask() & STARFIELD;
 
   // Return draw mode
   return (useTexture + useStarfield);
@@ -188,6 +219,12 @@ bool SkySphere::setStarData(const std::string &catalogName, float minMag, float
   return processStars();
 }
 
+void SkySphere::setStarTileLimits(unsigned int maxLevel, unsigned int maxStarsPerTile)
+{
+  _maxStarTileLevel = std::min(maxLevel, 16u);
+  _maxStarsPerTile = std::max(maxStarsPerTile, 1u);
+}
+
 // Compute star's pixel size from its apparent magnitude
 // See SkySphere::StarToPoint() implementation for equation reference
 float getStarPixelSizeFromMagnitude(float mag)
@@ -208,10 +245,152 @@ bool SkySphere::processStars()
     return false;
   }
 
-  // Open the star catalog file
+  // Load stars from the cache if it is up to date, otherwise from the
+  // star catalog, in which case the cache is updated
   std::string fullFile = osgDB::findDataFile(_starCatalogFile);
-  std::ifstream starfile(fullFile);
-  if(!starfile.is_open()) 
+  std::string cacheFile = getStarCacheFile(fullFile);
+  StarStats stats;
+  bool cached = !cacheFile.empty() && readStarCache(cacheFile, fullFile, stats);
+  if(!cached)
+  {
+    if(!readStarCatalog(fullFile, stats)) return false;
+    if(!cacheFile.empty()) writeStarCache(cacheFile, fullFile, stats);
+  }
+
+  OSG_NOTICE<< std::setprecision(2) << std::fixed << "OpenFrames plotting " << stats.numStars << " stars in magnitude range [" << stats.minMag << "," << stats.maxMag << "], and pixel size range [" << stats.minSize << "," << stats.maxSize << "]" << (cached ? " from star cache" : "") << std::endl;
+
+  // Tell all star tiles to draw their stars
+  for(unsigned int i = 0; i < _starTiles.size(); ++i)
+  {
+    StarTile &tile = _starTiles[i];
+
+#ifdef OF_DEBUG
+    std::cout<< "Star Tile " << i << " (face " << tile._face << ", level " << tile._level << ") has " << tile._vertices->size() << " stars" << std::endl;
+#endif
+
+    tile._drawArrays->setCount(tile._vertices->size());
+    tile._drawArrays->dirty();
+    tile._geom->dirtyBound();
+  }
+
+  return true;
+}
+
+namespace
+{
+  // A star that was parsed from a star catalog
+  struct ParsedStar
+  {
+    float mag;
+    osg::Vec3 vert;
+    osg::Vec4 color; // Size in color[3]
+  };
+
+  // Sort stars by magnitude
+  bool compareMagnitudes(const std::pair<float, const ParsedStar*> &a, const std::pair<float, const ParsedStar*> &b)
+  {
+    return a.first < b.first;
+  }
+}
+
+/**
+ * \class StarChunkParser
+ *
+ * \brief Parses lines of a star catalog into stars.
+ *
+ * Each chunk's stars are stored separately, in file order, so they can be
+ * merged in file order once all chunks are parsed.
+ */
+class StarChunkParser : public TextParser::ChunkParser
+{
+public:
+  StarChunkParser(double ra_limit, float minMag, float maxMag, unsigned int maxNumStars,
+                  float minPixSize, float maxPixSize, float minDimRatio)
+    : _ra_limit(ra_limit), _minMag(minMag), _maxMag(maxMag), _maxNumStars(maxNumStars),
+      _minPixSize(minPixSize), _maxPixSize(maxPixSize), _minDimRatio(minDimRatio)
+  {
+    // Find the scale needed to ensure all stars are in the right pixel size range
+    _maxRawSize = getStarPixelSizeFromMagnitude(_minMag); // minimum magnitude = maximum size
+    _minRawSize = getStarPixelSizeFromMagnitude(_maxMag);
+  }
+
+  virtual void beginChunks(unsigned int numChunks)
+  {
+    _chunks.resize(numChunks);
+  }
+
+  virtual void parseChunk(unsigned int chunkNum, const char *begin, const char *end)
+  {
+    std::vector<ParsedStar> &stars = _chunks[chunkNum];
+    double ra, dec; // Doubles for intermediate position calculations
+    float mag, colorindex;
+    SkySphere::Star currStar;
+    ParsedStar parsedStar;
+    const char *pos = begin;
+    const char *lineBegin, *lineEnd;
+
+    // Later chunks can't contribute more than the maximum number of stars either
+    while((stars.size() < _maxNumStars) && TextParser::nextLine(pos, end, lineBegin, lineEnd))
+    {
+      // Extract star info, skipping lines without position and magnitude
+      const char *linePos = lineBegin;
+      if(!TextParser::parseNumber(linePos, lineEnd, ra) ||
+         !TextParser::parseNumber(linePos, lineEnd, dec) ||
+         !TextParser::parseNumber(linePos, lineEnd, mag)) continue;
+      if(!TextParser::parseNumber(linePos, lineEnd, colorindex)) colorindex = 0.0;
+
+      // Filter by magnitude
+      if((mag < _minMag) || (mag > _maxMag)) continue;
+
+      // Prepare star data for processing
+      currStar.ra = (float)(ra / _ra_limit * 2.0*osg::PI); // Convert to radians
+      currStar.dec = (float)(dec*osg::PI / 180.0); // Degrees to radians
+      currStar.mag = mag;
+      currStar.colorindex = colorindex;
+
+      // Get current star location, color, and size
+      osg::Vec4 &currColor = parsedStar.color;
+      SkySphere::StarToPoint(currStar, parsedStar.vert, currColor); // Size in currColor[3]
+
+      // Linearly interpolate star size between specified bounds
+      float ratio = 0.0;
+      if (_maxRawSize != _minRawSize)
+      {
+        ratio = (currColor[3] - _minRawSize) / (_maxRawSize - _minRawSize); // Interpolation size ratio
+        currColor[3] = _minPixSize + ratio*(_maxPixSize - _minPixSize);
+      }
+      else // All stars are same raw size, so make them all the same pixel size
+      {
+        currColor[3] = _minPixSize;
+      }
+
+      // Dim star color according to its size ratio
+      // With this, big stars have their full color, but small stars are dimmed towards black
+      float dimRatio = std::max(_minDimRatio, ratio);
+      currColor[0] *= dimRatio;
+      currColor[1] *= dimRatio;
+      currColor[2] *= dimRatio;
+
+      parsedStar.mag = mag;
+      stars.push_back(parsedStar);
+    }
+  }
+
+  std::vector<std::vector<ParsedStar> > _chunks; // Stars parsed from each chunk
+
+private:
+  double _ra_limit;
+  float _minMag, _maxMag;
+  unsigned int _maxNumStars;
+  float _minPixSize, _maxPixSize, _minDimRatio;
+  float _minRawSize, _maxRawSize;
+};
+
+bool SkySphere::readStarCatalog(const std::string &fullFile, StarStats &stats)
+{
+  // Read the star catalog file
+  TextParser parser;
+  if(fullFile.empty() || !parser.readFile(fullFile))
   {
     std::cerr<< "OpenFrames::SkySphere ERROR: Could not open file " << _starCatalogFile << std::endl;
     return false;
@@ -224,8 +403,10 @@ bool SkySphere::processStars()
   // Assumed that right ascension label is "ra_(maxval)" where "(maxval)" is a double precision value (usually 24.0 or 360.0)
   const double ra_limit_default = 24.0;
   double ra_limit = ra_limit_default; // Right ascension assumed in hours unless specified in starfile header
+  const char *pos = parser.begin();
+  const char *lineBegin, *lineEnd;
   std::string line;
-  std::getline(starfile, line); // Get header line as string
+  if(TextParser::nextLine(pos, parser.end(), lineBegin, lineEnd)) line.assign(lineBegin, lineEnd); // Get header line as string
   std::istringstream ss_header(line);
   std::string ra_string;
   ss_header >> ra_string; // Extract first "word" as right ascension label
@@ -252,100 +433,239 @@ bool SkySphere::processStars()
      }
   }
 
-  // Find the scale needed to ensure all stars are in the right pixel size range
-  float maxRawSize = getStarPixelSizeFromMagnitude(_minMag); // minimum magnitude = maximum size
-  float minRawSize = getStarPixelSizeFromMagnitude(_maxMag);
-
-  // Loop over all stars
-  double ra, dec; // Doubles for intermediate position calculations
-  float mag, colorindex;
-  unsigned int numStars = 0;
-  float maxSize = 0.0, minSize = 10000.0; // Largest/smallest pixel sizes of processed stars
-  float maxMag = 0.0, minMag = 10000.0; // Largest/smallest magnitudes of processed stars
-  Star currStar;
-  osg::Vec3Array *vertices;
-  osg::Vec4Array *colors;
-  osg::Vec3 currVert;
-  osg::Vec4 currColor;
-  unsigned int currBin;
-  while(starfile && (numStars < _maxNumStars))
+  // Parse stars in parallel
+  StarChunkParser starParser(ra_limit, _minMag, _maxMag, _maxNumStars, _minPixSize, _maxPixSize, _minDimRatio);
+  parser.parseChunks(pos, parser.end(), starParser);
+
+  // Merge stars from all chunks in file order, up to the maximum number of stars
+  stats.numStars = 0;
+  stats.maxSize = 0.0; stats.minSize = 10000.0; // Largest/smallest pixel sizes of processed stars
+  stats.maxMag = 0.0; stats.minMag = 10000.0; // Largest/smallest magnitudes of processed stars
+  std::vector<std::pair<float, const ParsedStar*> > magnitudes; // Magnitude of each star
+  for(unsigned int i = 0; (i < starParser._chunks.size()) && (stats.numStars < _maxNumStars); ++i)
   {
-    // Get line
-    std::getline(starfile, line);
-    std::istringstream ss(line);
-
-    // Extract star info
-    ss >> ra >> dec;
-    ss >> mag;
-    ss >> colorindex;
-    if(ss.fail()) colorindex = 0.0;
-
-    // Filter by magnitude
-    if((mag < _minMag) || (mag > _maxMag)) continue;
-
-    // Prepare star data for processing
-    currStar.ra = (float)(ra / ra_limit * 2.0*osg::PI); // Convert to radians
-    currStar.dec = (float)(dec*osg::PI / 180.0); // Degrees to radians
-    currStar.mag = mag;
-    currStar.colorindex = colorindex;
-
-    // Get current star location, color, and size
-    StarToPoint(currStar, currVert, currColor); // Size in currColor[3]
-
-    // Linearly interpolate star size between specified bounds
-    float ratio = 0.0;
-    if (maxRawSize != minRawSize)
-    {
-      ratio = (currColor[3] - minRawSize) / (maxRawSize - minRawSize); // Interpolation size ratio
-      currColor[3] = _minPixSize + ratio*(_maxPixSize - _minPixSize);
-    }
-    else // All stars are same raw size, so make them all the same pixel size
+    const std::vector<ParsedStar> &chunk = starParser._chunks[i];
+    for(unsigned int j = 0; (j < chunk.size()) && (stats.numStars < _maxNumStars); ++j)
     {
-      currColor[3] = _minPixSize;
+      const ParsedStar &star = chunk[j];
+      magnitudes.push_back(std::make_pair(star.mag, &star));
+
+      // Update statistics
+      ++stats.numStars;
+      if(star.mag > stats.maxMag) stats.maxMag = star.mag;
+      if(star.mag < stats.minMag) stats.minMag = star.mag;
+      if(star.color[3] > stats.maxSize) stats.maxSize = star.color[3];
+      if(star.color[3] < stats.minSize) stats.minSize = star.color[3];
     }
+  }
 
-    // Dim star color according to its size ratio
-    // With this, big stars have their full color, but small stars are dimmed towards black
-    float dimRatio = std::max(_minDimRatio, ratio);
-    currColor[0] *= dimRatio;
-    currColor[1] *= dimRatio;
-    currColor[2] *= dimRatio;
-
-    //if(currStar.dec > 89.2*osg::PI/180.0) currColor[3] = 20.0; // Debugging: Make polar stars huge
-
-    // Place star in the appropriate bin according to its location
-    currBin = getStarBin(currVert);
-    vertices = static_cast<osg::Vec3Array*>(_starBinGeoms[currBin]->getVertexArray());
-    colors = static_cast<osg::Vec4Array*>(_starBinGeoms[currBin]->getColorArray());
-    vertices->push_back(currVert);
-    colors->push_back(currColor);
-
-    // Update statistics
-    ++numStars;
-    if(mag > maxMag) maxMag = mag;
-    if(mag < minMag) minMag = mag;
-    if(currColor[3] > maxSize) maxSize = currColor[3];
-    if(currColor[3] < minSize) minSize = currColor[3];
+  // Add stars to tiles from brightest to dimmest, so that bright stars are
+  // placed in coarse tiles and each tile's stars are sorted by magnitude.
+  // Stable sort keeps equal-magnitude stars in file order.
+  std::stable_sort(magnitudes.begin(), magnitudes.end(), compareMagnitudes);
+  for(unsigned int i = 0; i < magnitudes.size(); ++i)
+  {
+    addStarToTiles(magnitudes[i].second->vert, magnitudes[i].second->color);
   }
 
-  starfile.close(); // Close star database file
+  return true;
+}
 
-  OSG_NOTICE<< std::setprecision(2) << std::fixed << "OpenFrames plotting " << numStars << " stars in magnitude range [" << minMag << "," << maxMag << "], and pixel size range [" << minSize << "," << maxSize << "]" << std::endl;
+// Star cache file layout: StarCacheHeader, catalog path, then for each tile
+// (parents before children) its StarCacheTile followed by its vertices and colors
+namespace
+{
+  const char starCacheMagic[8] = {'O', 'F', 'S', 'T', 'A', 'R', 'S', '\0'};
+  const uint32_t starCacheVersion = 2;
 
-  // Tell all star bins to draw their stars
-  for(unsigned int i = 0; i < _starBinGeoms.size(); ++i)
+  struct StarCacheHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t maxTileLevel, maxStarsPerTile;
+    uint32_t numTiles;
+
+    // Star catalog and parameters used to process stars
+    int64_t catalogSize, catalogTime;
+    float minMag, maxMag;
+    uint32_t maxNumStars;
+    float minPixSize, maxPixSize, minDimRatio;
+    uint32_t pathLength;
+
+    // Statistics of processed stars
+    uint32_t numStars;
+    float statMinMag, statMaxMag, statMinSize, statMaxSize;
+  };
+
+  struct StarCacheTile
   {
-    vertices = static_cast<osg::Vec3Array*>(_starBinGeoms[i]->getVertexArray());
-    unsigned int currBinSize = vertices->size();
+    uint32_t face, level, s, t;
+    uint32_t numStars;
+  };
 
-#ifdef OF_DEBUG
-    std::cout<< "Star Bin " << i << " has " << currBinSize << " stars" << std::endl;
+  // Get a file's size and modification time
+  bool getFileInfo(const std::string &file, int64_t &size, int64_t &time)
+  {
+    struct stat info;
+    if(stat(file.c_str(), &info) != 0) return false;
+    size = info.st_size;
+    time = info.st_mtime;
+    return true;
+  }
+}
+
+/** Get the per-user directory for star cache files, or empty string if unknown */
+static std::string getUserStarCacheDirectory()
+{
+  const char *dir;
+#if defined(_WIN32)
+  if((dir = std::getenv("LOCALAPPDATA")) && (*dir != '\0')) return osgDB::concatPaths(dir, "OpenFrames");
+#elif defined(__APPLE__)
+  if((dir = std::getenv("HOME")) && (*dir != '\0')) return osgDB::concatPaths(dir, "Library/Caches/OpenFrames");
+#else
+  if((dir = std::getenv("XDG_CACHE_HOME")) && (*dir != '\0')) return osgDB::concatPaths(dir, "OpenFrames");
+  if((dir = std::getenv("HOME")) && (*dir != '\0')) return osgDB::concatPaths(dir, ".cache/OpenFrames");
 #endif
+  return std::string();
+}
+
+std::string SkySphere::getStarCacheFile(const std::string &fullFile) const
+{
+  if(!_useStarCache || fullFile.empty()) return std::string();
+
+  // Name cache after the catalog, with a hash of its full path so that
+  // catalogs with the same name can share a cache directory
+  std::ostringstream name;
+  name << osgDB::getStrippedName(fullFile) << '_' << std::hex << std::hash<std::string>()(fullFile) << ".ofstars";
+
+  // Without a cache directory, don't write the cache to e.g. the working directory
+  std::string dir = _starCacheDirectory.empty() ? getUserStarCacheDirectory() : _starCacheDirectory;
+  if(dir.empty()) return std::string();
+  else return osgDB::concatPaths(dir, name.str());
+}
+
+bool SkySphere::readStarCache(const std::string &cacheFile, const std::string &fullFile, StarStats &stats)
+{
+  std::ifstream cache(cacheFile, std::ios::binary);
+  if(!cache.is_open()) return false;
+
+  // Make sure cache matches the current star catalog and parameters
+  StarCacheHeader header;
+  int64_t catalogSize, catalogTime;
+  if(!cache.read((char*)&header, sizeof(header)) ||
+     !getFileInfo(fullFile, catalogSize, catalogTime) ||
+     (std::memcmp(header.magic, starCacheMagic, sizeof(starCacheMagic)) != 0) ||
+     (header.version != starCacheVersion) || (header.maxTileLevel != _maxStarTileLevel) || (header.maxStarsPerTile != _maxStarsPerTile) ||
+     (header.catalogSize != catalogSize) || (header.catalogTime != catalogTime) ||
+     (header.minMag != _minMag) || (header.maxMag != _maxMag) ||
+     (header.maxNumStars != _maxNumStars) || (header.minPixSize != _minPixSize) ||
+     (header.maxPixSize != _maxPixSize) || (header.minDimRatio != _minDimRatio) ||
+     (header.pathLength != fullFile.size()))
+    return false;
+
+  std::string path(header.pathLength, '\0');
+  if(!cache.read(&path[0], path.size()) || (path != fullFile)) return false;
+
+  // Read each tile's vertices and colors directly into its arrays
+  clearStars();
+  StarCacheTile tileInfo;
+  for(unsigned int i = 0; i < header.numTiles; ++i)
+  {
+    bool valid = cache.read((char*)&tileInfo, sizeof(tileInfo)) &&
+                 (tileInfo.face < 6) && (tileInfo.level <= _maxStarTileLevel) &&
+                 (tileInfo.s < (1u << tileInfo.level)) && (tileInfo.t < (1u << tileInfo.level));
+    if(valid && (tileInfo.numStars > 0))
+    {
+      StarTile &tile = _starTiles[getOrCreateStarTile(tileInfo.face, tileInfo.level, tileInfo.s, tileInfo.t)];
+      tile._vertices->resize(tileInfo.numStars);
+      tile._colors->resize(tileInfo.numStars);
+      valid = cache.read((char*)&(*tile._vertices)[0], tileInfo.numStars*sizeof(osg::Vec3)) &&
+              cache.read((char*)&(*tile._colors)[0], tileInfo.numStars*sizeof(osg::Vec4));
+    }
+
+    if(!valid)
+    {
+      OSG_WARN<< "OpenFrames::SkySphere WARNING: Star cache " << cacheFile << " is incomplete, reloading star catalog." << std::endl;
+      clearStars();
+      return false;
+    }
+  }
+
+  stats.numStars = header.numStars;
+  stats.minMag = header.statMinMag;
+  stats.maxMag = header.statMaxMag;
+  stats.minSize = header.statMinSize;
+  stats.maxSize = header.statMaxSize;
+  return true;
+}
+
+bool SkySphere::writeStarCache(const std::string &cacheFile, const std::string &fullFile, const StarStats &stats) const
+{
+  StarCacheHeader header;
+  std::memset(&header, 0, sizeof(header));
+  if(!getFileInfo(fullFile, header.catalogSize, header.catalogTime)) return false;
+  std::memcpy(header.magic, starCacheMagic, sizeof(starCacheMagic));
+  header.version = starCacheVersion;
+  header.maxTileLevel = _maxStarTileLevel;
+  header.maxStarsPerTile = _maxStarsPerTile;
+  header.numTiles = _starTiles.size();
+  header.minMag = _minMag;
+  header.maxMag = _maxMag;
+  header.maxNumStars = _maxNumStars;
+  header.minPixSize = _minPixSize;
+  header.maxPixSize = _maxPixSize;
+  header.minDimRatio = _minDimRatio;
+  header.pathLength = fullFile.size();
+  header.numStars = stats.numStars;
+  header.statMinMag = stats.minMag;
+  header.statMaxMag = stats.maxMag;
+  header.statMinSize = stats.minSize;
+  header.statMaxSize = stats.maxSize;
+
+  // Write to a temporary file that replaces the cache when complete, so that
+  // a partially written cache is never read
+  std::string tempFile = cacheFile + ".tmp";
+  osgDB::makeDirectoryForFile(cacheFile);
+  {
+    std::ofstream cache(tempFile, std::ios::binary | std::ios::trunc);
+    if(!cache.is_open())
+    {
+      OSG_INFO<< "OpenFrames::SkySphere: Could not write star cache " << cacheFile << std::endl;
+      return false;
+    }
+
+    cache.write((const char*)&header, sizeof(header));
+    cache.write(fullFile.data(), fullFile.size());
+    StarCacheTile tileInfo;
+    for(unsigned int i = 0; i < _starTiles.size(); ++i)
+    {
+      const StarTile &tile = _starTiles[i];
+      tileInfo.face = tile._face;
+      tileInfo.level = tile._level;
+      tileInfo.s = tile._s;
+      tileInfo.t = tile._t;
+      tileInfo.numStars = tile._vertices->size();
+      cache.write((const char*)&tileInfo, sizeof(tileInfo));
+      if(tileInfo.numStars == 0) continue;
+      cache.write((const char*)&(*tile._vertices)[0], tileInfo.numStars*sizeof(osg::Vec3));
+      cache.write((const char*)&(*tile._colors)[0], tileInfo.numStars*sizeof(osg::Vec4));
+    }
 
-    if(currBinSize > 0)
-      _starBinGeoms[i]->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, currBinSize));
+    if(!cache.good())
+    {
+      cache.close();
+      std::remove(tempFile.c_str());
+      OSG_INFO<< "OpenFrames::SkySphere: Could not write star cache " << cacheFile << std::endl;
+      return false;
+    }
   }
 
+  std::remove(cacheFile.c_str());
+  if(std::rename(tempFile.c_str(), cacheFile.c_str()) != 0)
+  {
+    std::remove(tempFile.c_str());
+    return false;
+  }
   return true;
 }
 
@@ -404,17 +724,15 @@ void SkySphere::StarToPoint(const Star &star, osg::Vec3 &pos, osg::Vec4 &color)
 }
 
 // Map point on unit sphere to point on unit cube, then map that point
-// to a star bin number. This allows spatial grouping of stars so that
-// they can be culled when not in view.
+// to coordinates on a cube face. This allows spatial grouping of stars
+// into tiles so that they can be culled when not in view.
 // This algorithm does an inverse mapping of the simple cube->sphere
 // mapping that normalizes cube points onto the unit sphere. This mapping
 // does not produce evenly-spaced points, but is much better than
 // tesselating a sphere by latitude/longitude. Alternative algorithms
 // can be investigated in the future.
-unsigned int SkySphere::getStarBin(const osg::Vec3 &p)
+void SkySphere::getStarFaceCoords(const osg::Vec3 &p, unsigned int &face, float &s, float &t)
 {
-  unsigned int face; // Cube face
-  float s, t; // Star coordinates on a cube face
   float planedist;
 
   const float &x = p[0];
@@ -467,36 +785,120 @@ unsigned int SkySphere::getStarBin(const osg::Vec3 &p)
   t = (t + 1.0)*0.5;
   if(s < 0) s = 0.0;
   if(t < 0) t = 0.0;
+  if(s > 1) s = 1.0;
+  if(t > 1) t = 1.0;
+}
 
-  // Bins are arranged on a uniform grid within a plane
-  float inversespacing = 1.0/(float)_starBinSpacing;
-  unsigned int s_bin = (unsigned int)(s/inversespacing);
-  unsigned int t_bin = (unsigned int)(t/inversespacing);
-  if(s_bin == _starBinSpacing) --s_bin;
-  if(t_bin == _starBinSpacing) --t_bin;
+// Map s-t coordinates in range [-1, 1] on a cube face to a point on the unit sphere
+// This is the inverse of the mapping in SkySphere::getStarFaceCoords()
+static osg::Vec3 faceCoordsToPoint(unsigned int face, float s, float t)
+{
+  osg::Vec3 p;
+  switch(face)
+  {
+    case 0: p.set(1.0, s, t); break;
+    case 1: p.set(-1.0, s, t); break;
+    case 2: p.set(s, 1.0, t); break;
+    case 3: p.set(s, -1.0, t); break;
+    case 4: p.set(s, t, 1.0); break;
+    default: p.set(s, t, -1.0); break;
+  }
+  p.normalize();
+  return p;
+}
 
-  // Compute bin number as n-adic expansion in base _starBinSpacing
-  unsigned int bin = s_bin + t_bin*_starBinSpacing + face*_starBinSpacing*_starBinSpacing;
+unsigned int SkySphere::getOrCreateStarTile(unsigned int face, unsigned int level, unsigned int s, unsigned int t)
+{
+  // Top-level tiles are added to the root, and other tiles to their parent
+  int parent = -1;
+  int *index;
+  if(level == 0) index = &_starFaceTiles[face];
+  else
+  {
+    parent = getOrCreateStarTile(face, level - 1, s/2, t/2);
+    index = &_starTiles[parent]._children[(s & 1) + 2*(t & 1)];
+  }
+  if(*index >= 0) return *index;
+
+  StarTile tile;
+  tile._face = face;
+  tile._level = level;
+  tile._s = s;
+  tile._t = t;
+  for(unsigned int i = 0; i < 4; ++i) tile._children[i] = -1;
+
+  // Create geometry for the tile's stars
+  tile._vertices = new osg::Vec3Array();
+  tile._colors = new osg::Vec4Array();
+  tile._colors->setBinding(osg::Array::BIND_PER_VERTEX);
+  tile._drawArrays = new osg::DrawArrays(GL_POINTS, 0, 0);
+  osg::Geometry *geom = tile._geom = new osg::Geometry;
+  geom->setName("StarFieldDrawable");
+  geom->setUseDisplayList(false);
+  geom->setUseVertexBufferObjects(true);
+  geom->getOrCreateVertexBufferObject()->setUsage(GL_STATIC_DRAW);
+  geom->setVertexArray(tile._vertices);
+  geom->setColorArray(tile._colors);
+  geom->addPrimitiveSet(tile._drawArrays);
+  osg::Geode *geode = new osg::Geode;
+  geode->addDrawable(geom);
+
+  // Tile's bound covers its whole region of the sky, not just its stars, so
+  // that its on-screen size determines whether child tiles are drawn
+  osg::BoundingSphere bound;
+  float size = 2.0/(float)(1u << level);
+  for(unsigned int i = 0; i <= 2; ++i)
+  {
+    for(unsigned int j = 0; j <= 2; ++j)
+    {
+      bound.expandBy(faceCoordsToPoint(face, (s + 0.5*i)*size - 1.0, (t + 0.5*j)*size - 1.0));
+    }
+  }
+
+  // Tile's stars are its first child, followed by its child tiles
+  tile._group = new osg::Group;
+  tile._group->setInitialBound(bound);
+  tile._group->setCullCallback(new StarTileCallback(this));
+  tile._group->addChild(geode);
+
+  if(parent < 0) _starTileRoot->addChild(tile._group);
+  else _starTiles[parent]._group->addChild(tile._group);
 
-  return bin;
+  // Note that index may be invalidated when the tile list grows
+  int newIndex = _starTiles.size();
+  *index = newIndex;
+  _starTiles.push_back(tile);
+  return newIndex;
 }
 
-void SkySphere::clearStars()
+void SkySphere::addStarToTiles(const osg::Vec3 &pos, const osg::Vec4 &color)
 {
-  osg::Vec3Array *vertices;
-  osg::Vec4Array *colors;
+  unsigned int face;
+  float s, t;
+  getStarFaceCoords(pos, face, s, t);
 
-  // Clear star geometry data
-  for(unsigned int i = 0; i < _starBinGeoms.size(); ++i)
+  // Descend the star's quadtree path until a tile has room for it
+  for(unsigned int level = 0; ; ++level)
   {
-    vertices = static_cast<osg::Vec3Array*>(_starBinGeoms[i]->getVertexArray());
-    colors = static_cast<osg::Vec4Array*>(_starBinGeoms[i]->getColorArray());
-    vertices->clear();
-    vertices->dirty();
-    colors->clear();
-    colors->dirty();
-    _starBinGeoms[i]->removePrimitiveSet(0, _starBinGeoms[i]->getNumPrimitiveSets());
+    unsigned int numTiles = 1u << level; // Tile rows (and columns) at this level
+    unsigned int s_tile = std::min((unsigned int)(s*numTiles), numTiles - 1);
+    unsigned int t_tile = std::min((unsigned int)(t*numTiles), numTiles - 1);
+    StarTile &tile = _starTiles[getOrCreateStarTile(face, level, s_tile, t_tile)];
+    if((tile._vertices->size() < _maxStarsPerTile) || (level >= _maxStarTileLevel))
+    {
+      tile._vertices->push_back(pos);
+      tile._colors->push_back(color);
+      return;
+    }
   }
 }
 
+void SkySphere::clearStars()
+{
+  // Remove all star tiles
+  _starTileRoot->removeChildren(0, _starTileRoot->getNumChildren());
+  _starTiles.clear();
+  for(unsigned int i = 0; i < 6; ++i) _starFaceTiles[i] = -1;
+}
+
 } // !namespace OpenFrames
@@ -19,6 +19,7 @@
  */
 
 #include <OpenFrames/Sphere.hpp>
+#include <OpenFrames/DepthPartitioner.hpp>
 #include <osg/Geode>
 #include <osg/PolygonOffset>
 #include <osg/Shape>
@@ -134,6 +135,11 @@ namespace OpenFrames
     _geode->setName(_name);
     _geode->addDrawable(_sphereSD);
     
+    // With reversed depth, farther fragments have smaller depth values, so flip the offset
+    osg::StateSet *reversedSS = new osg::StateSet;
+    reversedSS->setAttribute(new osg::PolygonOffset(-1, -1), osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+    _geode->setCullCallback(new ReversedZStateCallback(reversedSS));
+    
     // Add the sphere to its transform
     _sphereXform = new FrameTransform;
     _sphereXform->addChild(_geode);
@@ -0,0 +1,242 @@
+/***********************************
+ Copyright 2019 Ravishankar Mathur
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ ***********************************/
+
+
+/** \file TextParser.cpp
+ * TextParser-class function definitions.
+ */
+
+#include <OpenFrames/TextParser.hpp>
+#include <OpenThreads/Thread>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <locale>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <locale.h>
+#elif defined(__APPLE__)
+#include <xlocale.h>
+#else
+#include <locale.h>
+#endif
+
+namespace OpenFrames
+{
+  /** Whitespace that separates values within a line */
+  static inline bool isSpace(char c)
+  {
+    return (c == ' ') || (c == '\t') || (c == '\r');
+  }
+
+#if defined(_WIN32)
+  typedef _locale_t CLocale;
+#else
+  typedef locale_t CLocale;
+#endif
+
+  /** Get the "C" locale, so that numbers are parsed the same regardless of the
+      global locale (e.g. one that uses commas as decimal separators) */
+  static CLocale getCLocale()
+  {
+#if defined(_WIN32)
+    static CLocale locale = _create_locale(LC_NUMERIC, "C");
+#else
+    static CLocale locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+#endif
+    return locale;
+  }
+
+  /** Parse a number that fills the token [token, token+length), independent of the
+      global locale. The token must be followed by a character that can't continue it. */
+  static bool parseToken(const char *token, size_t length, double &value)
+  {
+    CLocale locale = getCLocale();
+    if(locale)
+    {
+      char *numEnd;
+#if defined(_WIN32)
+      value = _strtod_l(token, &numEnd, locale);
+#else
+      value = strtod_l(token, &numEnd, locale);
+#endif
+      return (numEnd != token) && ((size_t)(numEnd - token) == length);
+    }
+
+    // Fall back to a stream with the classic locale if the C locale isn't available
+    std::istringstream stream(std::string(token, length));
+    stream.imbue(std::locale::classic());
+    stream >> value;
+    return !stream.fail() && stream.eof();
+  }
+
+  /*******************************************************/
+  /** Parses one chunk of text */
+  class ChunkThread : public OpenThreads::Thread
+  {
+  public:
+    ChunkThread(TextParser::ChunkParser &parser, unsigned int chunkNum, const char *begin, const char *end)
+      : _parser(parser), _chunkNum(chunkNum), _begin(begin), _end(end)
+    {}
+
+    /** Inherited from OpenThreads::Thread. Called on thread launch. */
+    virtual void run()
+    {
+      _parser.parseChunk(_chunkNum, _begin, _end);
+    }
+
+  private:
+    TextParser::ChunkParser &_parser;
+    unsigned int _chunkNum;
+    const char *_begin, *_end;
+  };
+
+  /*******************************************************/
+  TextParser::TextParser()
+    : _numThreads(0), _minChunkSize(1 << 18)
+  {}
+
+  /*******************************************************/
+  TextParser::~TextParser() {}
+
+  /*******************************************************/
+  bool TextParser::readFile(const std::string &fileName)
+  {
+    _text.clear();
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if(!file.is_open()) return false;
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    if(size < 0) return false;
+    file.seekg(0, std::ios::beg);
+
+    _text.resize((size_t)size);
+    if((size > 0) && !file.read(&_text[0], size))
+    {
+      _text.clear();
+      return false;
+    }
+    return true;
+  }
+
+  /*******************************************************/
+  unsigned int TextParser::parseChunks(const char *begin, const char *end, ChunkParser &parser) const
+  {
+    // Use one chunk per thread, with at least the minimum chunk size
+    size_t size = (end > begin) ? (end - begin) : 0;
+    unsigned int numThreads = (_numThreads > 0) ? _numThreads : OpenThreads::GetNumberOfProcessors();
+    size_t maxChunks = size/std::max(_minChunkSize, 1u);
+    unsigned int numChunks = (unsigned int)std::max((size_t)1, std::min((size_t)std::max(numThreads, 1u), maxChunks));
+
+    // Split text into chunks of about equal size, extending each chunk to
+    // the end of its last line
+    std::vector<const char*> bounds(numChunks + 1);
+    bounds[0] = begin;
+    for(unsigned int i = 1; i < numChunks; ++i)
+    {
+      const char *pos = std::max(begin + i*(size/numChunks), bounds[i-1]);
+      pos = std::find(pos, end, '\n');
+      bounds[i] = (pos == end) ? end : pos + 1;
+    }
+    bounds[numChunks] = std::max(end, begin);
+
+    parser.beginChunks(numChunks);
+
+    // Parse the first chunk in this thread, and the others in worker threads.
+    // Chunks whose threads can't be started are also parsed in this thread.
+    std::vector<ChunkThread*> threads;
+    std::vector<unsigned int> localChunks(1, 0);
+    for(unsigned int i = 1; i < numChunks; ++i)
+    {
+      ChunkThread *thread = new ChunkThread(parser, i, bounds[i], bounds[i+1]);
+      if(thread->start() == 0) threads.push_back(thread);
+      else
+      {
+        delete thread;
+        localChunks.push_back(i);
+      }
+    }
+    for(unsigned int i = 0; i < localChunks.size(); ++i)
+    {
+      unsigned int chunkNum = localChunks[i];
+      parser.parseChunk(chunkNum, bounds[chunkNum], bounds[chunkNum+1]);
+    }
+
+    for(unsigned int i = 0; i < threads.size(); ++i)
+    {
+      threads[i]->join();
+      delete threads[i];
+    }
+
+    return numChunks;
+  }
+
+  /*******************************************************/
+  bool TextParser::nextLine(const char *&pos, const char *end, const char *&lineBegin, const char *&lineEnd)
+  {
+    if(pos >= end) return false;
+
+    lineBegin = pos;
+    lineEnd = std::find(pos, end, '\n');
+    pos = (lineEnd == end) ? end : lineEnd + 1;
+
+    // Exclude carriage return of Windows line endings
+    if((lineEnd > lineBegin) && (*(lineEnd - 1) == '\r')) --lineEnd;
+    return true;
+  }
+
+  /*******************************************************/
+  bool TextParser::parseNumber(const char *&pos, const char *end, double &value)
+  {
+    // Skip leading whitespace, but don't continue onto the next line
+    while((pos < end) && isSpace(*pos)) ++pos;
+    if((pos >= end) || (*pos == '\n')) return false;
+
+    // Copy the token if it could run past the end of the text, since strtod
+    // requires a terminated string
+    const char *tokenEnd = pos;
+    while((tokenEnd < end) && !isSpace(*tokenEnd) && (*tokenEnd != '\n')) ++tokenEnd;
+    char buffer[64];
+    const char *token = pos;
+    if(tokenEnd == end)
+    {
+      size_t length = tokenEnd - pos;
+      if(length >= sizeof(buffer)) return false;
+      std::copy(pos, tokenEnd, buffer);
+      buffer[length] = '\0';
+      token = buffer;
+    }
+
+    // Number must fill the whole token
+    if(!parseToken(token, tokenEnd - pos, value)) return false;
+
+    pos = tokenEnd;
+    return true;
+  }
+
+  /*******************************************************/
+  bool TextParser::parseNumber(const char *&pos, const char *end, float &value)
+  {
+    double temp;
+    if(!parseNumber(pos, end, temp)) return false;
+    value = (float)temp;
+    return true;
+  }
+
+} // !namespace OpenFrames
@@ -19,6 +19,7 @@
  */
 
 #include <OpenFrames/Trajectory.hpp>
+#include <OpenThreads/Atomic>
 #include <math.h>
 #include <climits>
 #include <cfloat>
@@ -28,6 +29,9 @@
 
 namespace OpenFrames {
 
+// Incremented whenever any Trajectory informs its subscribers
+static OpenThreads::Atomic globalGeneration;
+
 Trajectory::Trajectory(unsigned int dof, unsigned int nopt )
 {
   _autoInformSubscribers = true;
@@ -502,6 +506,8 @@ void Trajectory::removeSubscriber(TrajectorySubscriber* subscriber) const
 
 void Trajectory::informSubscribers()
 {
+  ++globalGeneration;
+
   for(SubscriberArray::iterator i = _subscribers.begin(); i != _subscribers.end(); ++i)
   {
     // Inform artist that data has been cleared
@@ -514,6 +520,11 @@ void Trajectory::informSubscribers()
   _dataCleared = false; // Reset flag
 }
   
+unsigned int Trajectory::getGlobalGeneration()
+{
+  return globalGeneration;
+}
+
 void Trajectory::lockData(DataLockType lockType) const
 {
     if (lockType == READ_LOCK) _readWriteMutex.readLock();
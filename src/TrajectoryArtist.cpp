@@ -60,6 +60,40 @@ static const char *OFTA_VertSource = {
   "}\n"
 };
 
+// Implement vertex shader for Rendering Relative to Center using GPU
+// Vertices are single-precision offsets from their chunk's center, so only
+// the center needs to be rendered relative to the eye
+static const char *OFTA_RTCVertSource = {
+  "#version 120\n"
+  "uniform mat4 osg_ProjectionMatrix;\n"
+
+  // ModelView matrix with zero translation component
+  "uniform mat4 of_RTEModelViewMatrix;\n"
+
+  // High/low parts of modelview matrix translation
+  "uniform vec3 of_ModelViewEyeHigh;\n"
+  "uniform vec3 of_ModelViewEyeLow;\n"
+
+  // High/low parts of chunk center
+  "uniform vec3 of_ChunkCenterHigh;\n"
+  "uniform vec3 of_ChunkCenterLow;\n"
+
+  "void main(void)\n"
+  "{\n"
+     // Center - eye, computed the same way as vertex - eye for RTE
+  "  vec3 t1 = of_ChunkCenterLow - of_ModelViewEyeLow;\n"
+  "  vec3 e = t1 - of_ChunkCenterLow;\n"
+  "  vec3 t2 = ((-of_ModelViewEyeLow - e) + (of_ChunkCenterLow - (t1 - e))) + of_ChunkCenterHigh - of_ModelViewEyeHigh;\n"
+  "  vec3 diffHigh = t1 + t2;\n"
+  "  vec3 diffLow = t2 - (diffHigh - t1);\n"
+
+     // Vertex position is its offset from the chunk center
+  "  gl_Position = osg_ProjectionMatrix*of_RTEModelViewMatrix*vec4((diffHigh+diffLow) + gl_Vertex.xyz, 1.0);\n"
+  "  gl_FrontColor = gl_Color;\n"
+  "  gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+  "}\n"
+};
+
 TrajectoryArtist::TrajectoryArtist() 
 {
   // Create vertex shader
@@ -78,6 +112,17 @@ TrajectoryArtist::TrajectoryArtist()
   getOrCreateStateSet()->setAttribute(_program);
 }
 
+osg::Program* TrajectoryArtist::getRTCProgram()
+{
+  if(!_rtcProgram.valid())
+  {
+    _rtcProgram = new osg::Program;
+    _rtcProgram->setName("OFTrajectoryArtist_RTCShaderProgram");
+    _rtcProgram->addShader(new osg::Shader(osg::Shader::VERTEX, OFTA_RTCVertSource));
+  }
+  return _rtcProgram.get();
+}
+
 // Not using the copy constructor
 TrajectoryArtist::TrajectoryArtist( const TrajectoryArtist &ta, const osg::CopyOp& copyop )
 {}
@@ -23,13 +23,61 @@
 #include <OpenThreads/ScopedLock>
 #include <osg/NodeVisitor>
 #include <climits>
+#include <cfloat>
+#include <cmath>
 #include <algorithm>
 
 namespace OpenFrames
 {
 
+/** Quaternion product a*b using the Hamilton convention, on (x,y,z,w)
+    quaternions as stored in a Trajectory */
+static osg::Quat quatMult(const osg::Quat &a, const osg::Quat &b)
+{
+  return osg::Quat(a.w()*b.x() + a.x()*b.w() + a.y()*b.z() - a.z()*b.y(),
+                   a.w()*b.y() - a.x()*b.z() + a.y()*b.w() + a.z()*b.x(),
+                   a.w()*b.z() + a.x()*b.y() - a.y()*b.x() + a.z()*b.w(),
+                   a.w()*b.w() - a.x()*b.x() - a.y()*b.y() - a.z()*b.z());
+}
+
+/** Logarithm of a unit quaternion, returned as the vector part of the
+    resulting pure quaternion */
+static osg::Vec3d quatLog(const osg::Quat &q)
+{
+  osg::Vec3d v(q.x(), q.y(), q.z());
+  double sinTheta = v.length();
+  if(sinTheta < 1.0e-12) return v; // theta ~ sin(theta) for small angles
+  double theta = std::atan2(sinTheta, q.w());
+  return v*(theta/sinTheta);
+}
+
+/** Exponential of a pure quaternion, given by its vector part */
+static osg::Quat quatExp(const osg::Vec3d &v)
+{
+  double theta = v.length();
+  if(theta < 1.0e-12) return osg::Quat(v.x(), v.y(), v.z(), 1.0); // sin(theta) ~ theta for small angles
+  double s = std::sin(theta)/theta;
+  return osg::Quat(v.x()*s, v.y()*s, v.z()*s, std::cos(theta));
+}
+
+/** Compute the SQUAD control point for attitude q, given the attitudes
+    before and after it */
+static osg::Quat squadControlPoint(const osg::Quat &qPrev, const osg::Quat &q, const osg::Quat &qNext)
+{
+  osg::Quat qInv = q.inverse();
+  osg::Vec3d logSum = quatLog(quatMult(qInv, qNext)) + quatLog(quatMult(qInv, qPrev));
+  return quatMult(q, quatExp(logSum*(-0.25)));
+}
+
 TrajectoryFollower::TrajectoryFollower(Trajectory *traj)
-  : _usingDefaultData(true)
+  : _posInterp(LINEAR),
+    _attInterp(SLERP),
+    _velOpt(1),
+    _lagrangeOrder(3),
+    _extrapType(VELOCITY_EXTRAPOLATION),
+    _extrapHorizon(1.0),
+    _extrapBlendTime(0.1),
+    _usingDefaultData(true)
 {
 	setTrajectory(traj);
   
@@ -73,6 +121,9 @@ void TrajectoryFollower::setTrajectory(Trajectory *traj)
     traj->addSubscriber(this);
   }
   
+  // Index new trajectory by its time range
+  _rebuildTimeIndex();
+  
   // Set default data sources if needed
   if(_usingDefaultData) setDefaultData();
   
@@ -96,6 +147,10 @@ void TrajectoryFollower::addTrajectory(Trajectory *traj)
   _trajList.push_back(traj);
   traj->addSubscriber(this);
   
+  // Index new trajectory by its time range
+  unsigned int pos = _insertTimeInterval(traj);
+  if(pos != UINT_MAX) _updateMaxTimes(pos);
+  
   // Set default data sources if needed
   if(_usingDefaultData) setDefaultData();
   
@@ -120,6 +175,7 @@ void TrajectoryFollower::removeTrajectory(Trajectory *traj)
     }
     
     _trajList.clear();
+    _rebuildTimeIndex();
   }
   else // Stop following specified trajectory
   {
@@ -128,6 +184,11 @@ void TrajectoryFollower::removeTrajectory(Trajectory *traj)
     {
       (*i)->removeSubscriber(this);
       _trajList.erase(i);
+
+      // Remove trajectory from time index
+      unsigned int pos = _removeTimeInterval(traj);
+      if(pos != UINT_MAX) _updateMaxTimes(pos);
+      _startTimes.erase(traj);
     }
   }
   
@@ -141,6 +202,48 @@ void TrajectoryFollower::removeTrajectory(Trajectory *traj)
   _needsUpdate = true;
 }
   
+void TrajectoryFollower::setPositionInterpolation(PositionInterpolation interp)
+{
+  _posInterp = interp;
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::setVelocityOptional(unsigned int opt)
+{
+  _velOpt = opt;
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::setLagrangeOrder(unsigned int order)
+{
+  _lagrangeOrder = (order == 0) ? 1 : order;
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::setExtrapolationType(ExtrapolationType type)
+{
+  _extrapType = type;
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::setExtrapolationHorizon(double horizon)
+{
+  _extrapHorizon = std::max(horizon, 0.0);
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::setExtrapolationBlendTime(double blendTime)
+{
+  _extrapBlendTime = std::max(blendTime, 0.0);
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::setAttitudeInterpolation(AttitudeInterpolation interp)
+{
+  _attInterp = interp;
+  _needsUpdate = true;
+}
+
 bool TrajectoryFollower::setXData(const Trajectory::DataSource &src)
 {
 	if(_dataSource[0] == src) return _dataValid; // No changes to be made
@@ -227,6 +330,22 @@ void TrajectoryFollower::setOffsetTime(double offsetTime)
 	_needsUpdate = true;
 }
 
+void TrajectoryFollower::dataCleared(const Trajectory* traj)
+{
+  // Time range of the trajectory will be reindexed at the next update
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_changedMutex);
+  _changedTrajs.insert(traj);
+  _needsUpdate = true;
+}
+
+void TrajectoryFollower::dataAdded(const Trajectory* traj)
+{
+  // Time range of the trajectory will be reindexed at the next update
+  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_changedMutex);
+  _changedTrajs.insert(traj);
+  _needsUpdate = true;
+}
+
 bool TrajectoryFollower::run(osg::Object* object, osg::Object* data)
 {
   osg::NodeVisitor *nv = data ? data->asNodeVisitor() : 0;
@@ -249,11 +368,8 @@ bool TrajectoryFollower::run(osg::Object* object, osg::Object* data)
       if(_followTime) time = _lastSimTime + _timeVal;
       else time = _timeVal;
       
-      // Prevent trajectories from being modified while reading them
-      for(auto traj : _trajList)
-      {
-        traj->lockData();
-      }
+      // Reindex time ranges of trajectories that have changed
+      _updateTimeIndex();
       
       // Compute adjusted time based on follow mode
       _lastAdjustedTime = _computeTime(time);
@@ -261,11 +377,8 @@ bool TrajectoryFollower::run(osg::Object* object, osg::Object* data)
       // Choose trajectory based on adjusted time
       _follow = _chooseTrajectory(_lastAdjustedTime);
       
-      // Unlock all trajectories except the one being followed
-      for(auto traj : _trajList)
-      {
-        if(traj.get() != _follow.get()) traj->unlockData();
-      }
+      // Prevent followed trajectory from being modified while reading it
+      _follow->lockData();
       
       // Apply new position/attitude to the FrameTransform
       FrameTransform *ft = static_cast<FrameTransform*>(object);
@@ -296,26 +409,15 @@ bool TrajectoryFollower::run(osg::Object* object, osg::Object* data)
 
 double TrajectoryFollower::_computeTime(double time)
 {
-  // LIMIT mode: don't wrap time
-  if(_mode == LIMIT) return time;
+  // LIMIT and EXTRAPOLATE modes: don't wrap time
+  if(_mode != LOOP) return time;
   
-  // Compute start and end times over all trajectories
-  double t0 = DBL_MAX;
-  double tf = -DBL_MAX;
-  for(auto traj : _trajList)
-  {
-    // Get current trajectory's start & end time
-    double traj_t0, traj_tf;
-    if(!traj->getTimeRange(traj_t0, traj_tf)) continue;
-    if(traj_t0 > traj_tf) std::swap(traj_t0, traj_tf); // Enforce t0<=tf
-
-    // Update global start & end times
-    if(traj_t0 < t0) t0 = traj_t0;
-    if(traj_tf > tf) tf = traj_tf;
-  }
-
   // Make sure valid trajectories were found
-  if((t0 == DBL_MAX) || (tf == -DBL_MAX)) return time;
+  if(_timeIndex.empty()) return time;
+
+  // Start and end times over all trajectories come from the time index
+  double t0 = _timeIndex.front()._t0;
+  double tf = _timeIndex.back()._maxTf;
 
   // If [t0, tf] range is too small, then just use t0
   if(tf - t0 <= 8.0*DBL_MIN) return t0;
@@ -330,30 +432,166 @@ Trajectory* TrajectoryFollower::_chooseTrajectory(double time)
   // If there is only one trajectory in the list, then use it
   if(_trajList.size() == 1) return _trajList[0];
 
+  // If no trajectories have data, then just use the first one
+  if(_timeIndex.empty()) return _trajList[0];
+
   // If current trajectory contains given time, then continue using it
-  if(_follow.valid() && (_follow->getTimeDistance(time) <= 0.0)) return _follow.get();
+  if(_follow.valid())
+  {
+    unsigned int pos = _findTimeInterval(_follow.get());
+    if((pos != UINT_MAX) && (_timeIndex[pos]._t0 <= time) && (time <= _timeIndex[pos]._tf))
+      return _follow.get();
+  }
 
-  // Find first trajectory that contains given time
-  double minTimeDistance = DBL_MAX;
-  Trajectory* minTimeDistanceTraj = _trajList[0];
-  for(auto traj : _trajList)
+  // Find first interval that starts after given time
+  TimeIndex::const_iterator next = std::upper_bound(_timeIndex.begin(), _timeIndex.end(), time,
+                                                    [](double t, const TimeInterval &ti) { return t < ti._t0; });
+
+  // Given time is before all trajectories, so use the earliest one
+  if(next == _timeIndex.begin()) return next->_traj;
+
+  // All intervals up to and including the previous one start at or before the
+  // given time, so the one with the latest end time contains it if any do
+  const TimeInterval &prev = *(next - 1);
+  if(prev._maxTf >= time) return _timeIndex[prev._maxTfIndex]._traj;
+
+  // No trajectories contain given time, so use the closest trajectory
+  if((next == _timeIndex.end()) || (time - prev._maxTf <= next->_t0 - time))
+    return _timeIndex[prev._maxTfIndex]._traj;
+  else return next->_traj;
+}
+
+void TrajectoryFollower::_rebuildTimeIndex()
+{
+  // Changes to individual trajectories are superseded by the rebuild
   {
-    // Get distance from given time to current trajectory time range
-    double dist = traj->getTimeDistance(time);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_changedMutex);
+    _changedTrajs.clear();
+  }
 
-    // Use trajectory if it contains given time
-    if(dist <= 0.0) return traj;
+  _timeIndex.clear();
+  _startTimes.clear();
 
-    // Otherwise save this as a candidate for "closest" trajectory
-    else if(dist < minTimeDistance)
+  // Index each nonempty trajectory by its time range
+  TimeInterval interval;
+  for(auto traj : _trajList)
+  {
+    if(_readTimeInterval(traj, interval))
     {
-      minTimeDistance = dist;
-      minTimeDistanceTraj = traj;
+      _timeIndex.push_back(interval);
+      _startTimes[traj] = interval._t0;
     }
+    else _startTimes[traj] = DBL_MAX;
   }
 
-  // No trajectories contain given time, so use the closest trajectory
-  return minTimeDistanceTraj;
+  // Sort by start time, keeping trajectories with equal start times in followed order
+  std::stable_sort(_timeIndex.begin(), _timeIndex.end(),
+                   [](const TimeInterval &a, const TimeInterval &b) { return a._t0 < b._t0; });
+  _updateMaxTimes(0);
+}
+
+void TrajectoryFollower::_updateTimeIndex()
+{
+  // Get trajectories that have changed since the last update
+  TrajSet changed;
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_changedMutex);
+    if(_changedTrajs.empty()) return;
+    changed.swap(_changedTrajs);
+  }
+
+  // Reindex each changed trajectory
+  unsigned int start = UINT_MAX;
+  for(auto traj : changed)
+  {
+    // Ignore trajectories that are no longer being followed
+    if(_startTimes.find(traj) == _startTimes.end()) continue;
+
+    // Followed trajectories are stored as non-const in _trajList
+    unsigned int removePos = _removeTimeInterval(traj);
+    unsigned int insertPos = _insertTimeInterval(const_cast<Trajectory*>(traj));
+    start = std::min(start, std::min(removePos, insertPos));
+  }
+
+  if(start != UINT_MAX) _updateMaxTimes(start);
+}
+
+bool TrajectoryFollower::_readTimeInterval(Trajectory *traj, TimeInterval &interval) const
+{
+  traj->lockData();
+  bool valid = traj->getTimeRange(interval._t0, interval._tf);
+  traj->unlockData();
+  if(!valid) return false;
+
+  if(interval._t0 > interval._tf) std::swap(interval._t0, interval._tf); // Enforce t0<=tf
+  interval._traj = traj;
+  return true;
+}
+
+unsigned int TrajectoryFollower::_insertTimeInterval(Trajectory *traj)
+{
+  TimeInterval interval;
+  if(!_readTimeInterval(traj, interval))
+  {
+    _startTimes[traj] = DBL_MAX; // Empty trajectories are not indexed
+    return UINT_MAX;
+  }
+
+  // Insert after all intervals with the same or earlier start time
+  TimeIndex::iterator i = std::upper_bound(_timeIndex.begin(), _timeIndex.end(), interval._t0,
+                                           [](double t, const TimeInterval &ti) { return t < ti._t0; });
+  unsigned int pos = i - _timeIndex.begin();
+  _timeIndex.insert(i, interval);
+  _startTimes[traj] = interval._t0;
+
+  return pos;
+}
+
+unsigned int TrajectoryFollower::_removeTimeInterval(const Trajectory *traj)
+{
+  unsigned int pos = _findTimeInterval(traj);
+  if(pos == UINT_MAX) return UINT_MAX;
+
+  _timeIndex.erase(_timeIndex.begin() + pos);
+  _startTimes[traj] = DBL_MAX;
+
+  return pos;
+}
+
+unsigned int TrajectoryFollower::_findTimeInterval(const Trajectory *traj) const
+{
+  // Get the start time with which the trajectory was indexed
+  TrajStartTimes::const_iterator st = _startTimes.find(traj);
+  if((st == _startTimes.end()) || (st->second == DBL_MAX)) return UINT_MAX;
+
+  // Search intervals with the trajectory's start time
+  TimeIndex::const_iterator i = std::lower_bound(_timeIndex.begin(), _timeIndex.end(), st->second,
+                                                 [](const TimeInterval &ti, double t) { return ti._t0 < t; });
+  for(; (i != _timeIndex.end()) && (i->_t0 == st->second); ++i)
+  {
+    if(i->_traj == traj) return i - _timeIndex.begin();
+  }
+
+  return UINT_MAX;
+}
+
+void TrajectoryFollower::_updateMaxTimes(unsigned int start)
+{
+  // Max end time of an interval also includes all preceding intervals
+  for(unsigned int i = start; i < _timeIndex.size(); ++i)
+  {
+    TimeInterval &curr = _timeIndex[i];
+    if((i > 0) && (_timeIndex[i-1]._maxTf > curr._tf))
+    {
+      curr._maxTf = _timeIndex[i-1]._maxTf;
+      curr._maxTfIndex = _timeIndex[i-1]._maxTfIndex;
+    }
+    else
+    {
+      curr._maxTf = curr._tf;
+      curr._maxTfIndex = i;
+    }
+  }
 }
 
 bool TrajectoryFollower::_updateState(double time, TrajectoryFollower::FollowData data)
@@ -383,6 +621,7 @@ bool TrajectoryFollower::_updateState(double time, TrajectoryFollower::FollowDat
 
   // Find requested time in the Trajectory
   val = _follow->getTimeIndex(time, index);
+  bool extrapolated = false; // Whether state is extrapolated past last point
 
   if(val >= 0) // Time not out of range, so interpolate
   {
@@ -399,26 +638,43 @@ bool TrajectoryFollower::_updateState(double time, TrajectoryFollower::FollowDat
       if((index+1 < (int)numPoints) && (times[index] != times[index+1]))
       {
         // Get second interpolation point and do the interpolation
+        double frac = (time - times[index])/(times[index+1] - times[index]);
         if(data == POSITION)
         {
-          _follow->getPoint(index+1, _dataSource, _v2._v);
-          double frac = (time - times[index])/(times[index+1] - times[index]);
-          _v1 = _v1 + (_v2-_v1)*frac; // Linear interpolation for position
+          // Use higher-order interpolation if requested and possible
+          bool interpolated = false;
+          if(_posInterp == HERMITE)
+            interpolated = _interpolateHermite(index, time, times);
+          else if(_posInterp == LAGRANGE)
+            interpolated = _interpolateLagrange(index, time, numPoints, times);
+
+          if(!interpolated)
+          {
+            _follow->getPoint(index+1, _dataSource, _v2._v);
+            _v1 = _v1 + (_v2-_v1)*frac; // Linear interpolation for position
+          }
+        }
+        else if(_attInterp == SQUAD)
+        {
+          _interpolateSquad(index, frac, numPoints); // Spherical cubic interpolation for attitude
         }
         else
         {
           _follow->getAttitude(index+1, _a2[0], _a2[1], _a2[2], _a2[3]);
-          double frac = (time - times[index])/(times[index+1] - times[index]);
           _a1.slerp(frac, _a1, _a2); // Spherical interpolation for attitude
         }
       }
     }
-    else // Otherwise use last available point
+    else // Otherwise use last available point, or extrapolate past it
     {
-      if(data == POSITION)
-        _follow->getPoint(numPoints-1, _dataSource, _v1._v);
-      else
-        _follow->getAttitude(numPoints-1, _a1[0], _a1[1], _a1[2], _a1[3]);
+      if(_mode == EXTRAPOLATE) extrapolated = _extrapolate(time, numPoints, times, data);
+      if(!extrapolated)
+      {
+        if(data == POSITION)
+          _follow->getPoint(numPoints-1, _dataSource, _v1._v);
+        else
+          _follow->getAttitude(numPoints-1, _a1[0], _a1[1], _a1[2], _a1[3]);
+      }
     }
   }
   else if(val == -1) // Time out of range
@@ -432,10 +688,14 @@ bool TrajectoryFollower::_updateState(double time, TrajectoryFollower::FollowDat
     }
     else // Requested time after last time
     {
-      if(data == POSITION)
-        _follow->getPoint(numPoints-1, _dataSource, _v1._v);
-      else
-        _follow->getAttitude(numPoints-1, _a1[0], _a1[1], _a1[2], _a1[3]);
+      if(_mode == EXTRAPOLATE) extrapolated = _extrapolate(time, numPoints, times, data);
+      if(!extrapolated)
+      {
+        if(data == POSITION)
+          _follow->getPoint(numPoints-1, _dataSource, _v1._v);
+        else
+          _follow->getAttitude(numPoints-1, _a1[0], _a1[1], _a1[2], _a1[3]);
+      }
     }
   }
   else if(val == -2) // Error in search (endless iterations)
@@ -449,7 +709,205 @@ bool TrajectoryFollower::_updateState(double time, TrajectoryFollower::FollowDat
     return false;
   }
   
+  // Smoothly transition from extrapolated state when new points arrive
+  if(_mode == EXTRAPOLATE) _blendExtrapolation(time, numPoints, extrapolated, data);
+  
   return true; // State successfully computed
 }
+
+bool TrajectoryFollower::_interpolateHermite(int index, double time, const Trajectory::DataArray &times)
+{
+  Trajectory::DataSource velSource[3];
+  if(!_getVelocitySource(velSource)) return false;
+
+  // Get positions and velocities at both ends of the interval
+  osg::Vec3d p0, p1, vel0, vel1;
+  _follow->getPoint(index, _dataSource, p0._v);
+  _follow->getPoint(index+1, _dataSource, p1._v);
+  _follow->getPoint(index, velSource, vel0._v);
+  _follow->getPoint(index+1, velSource, vel1._v);
+
+  // Cubic Hermite basis functions, with velocities scaled to the interval length
+  const double dt = times[index+1] - times[index];
+  const double s = (time - times[index])/dt;
+  const double s2 = s*s;
+  const double s3 = s2*s;
+  _v1 = p0*(2.0*s3 - 3.0*s2 + 1.0) + vel0*(dt*(s3 - 2.0*s2 + s))
+      + p1*(3.0*s2 - 2.0*s3) + vel1*(dt*(s3 - s2));
+
+  return true;
+}
+
+bool TrajectoryFollower::_interpolateLagrange(int index, double time, unsigned int numPoints, const Trajectory::DataArray &times)
+{
+  // Number of points used for interpolation, which can't exceed the number of
+  // available points. Two points is the same as linear interpolation.
+  const int numInterp = std::min(_lagrangeOrder + 1, numPoints);
+  if(numInterp < 3) return false;
+
+  // Center the interpolation points on [index, index+1], but keep them
+  // within the trajectory's bounds
+  int start = index - (numInterp-1)/2;
+  start = std::max(0, std::min(start, (int)numPoints - numInterp));
+
+  return _evaluateLagrange(start, numInterp, time, times);
+}
+
+bool TrajectoryFollower::_evaluateLagrange(int start, int numInterp, double time, const Trajectory::DataArray &times)
+{
+  // Sum the points weighted by their Lagrange basis polynomials
+  osg::Vec3d pos, point;
+  for(int j = start; j < start + numInterp; ++j)
+  {
+    double basis = 1.0;
+    for(int k = start; k < start + numInterp; ++k)
+    {
+      if(k == j) continue;
+      if(times[j] == times[k]) return false; // Repeated times can't be interpolated
+      basis *= (time - times[k])/(times[j] - times[k]);
+    }
+
+    _follow->getPoint(j, _dataSource, point._v);
+    pos += point*basis;
+  }
+
+  _v1 = pos;
+  return true;
+}
+
+void TrajectoryFollower::_interpolateSquad(int index, double frac, unsigned int numPoints)
+{
+  // Get attitudes around the interval [index, index+1], repeating
+  // the end attitudes at the trajectory's bounds
+  osg::Quat q0, q1, q2, q3;
+  int i0 = (index > 0) ? index-1 : index;
+  int i3 = (index+2 < (int)numPoints) ? index+2 : index+1;
+  _follow->getAttitude(i0, q0[0], q0[1], q0[2], q0[3]);
+  _follow->getAttitude(index, q1[0], q1[1], q1[2], q1[3]);
+  _follow->getAttitude(index+1, q2[0], q2[1], q2[2], q2[3]);
+  _follow->getAttitude(i3, q3[0], q3[1], q3[2], q3[3]);
+
+  // Keep neighboring attitudes in the same hemisphere so that the
+  // shortest rotation between them is used
+  if(q0.asVec4()*q1.asVec4() < 0.0) q0 = -q0;
+  if(q1.asVec4()*q2.asVec4() < 0.0) q2 = -q2;
+  if(q2.asVec4()*q3.asVec4() < 0.0) q3 = -q3;
+
+  // Intermediate control points at each end of the interval
+  osg::Quat s1 = squadControlPoint(q0, q1, q2);
+  osg::Quat s2 = squadControlPoint(q1, q2, q3);
+
+  // Spherical cubic interpolation between q1 and q2
+  osg::Quat a, b;
+  a.slerp(frac, q1, q2);
+  b.slerp(frac, s1, s2);
+  _a1.slerp(2.0*frac*(1.0 - frac), a, b);
+}
+  
+bool TrajectoryFollower::_getVelocitySource(Trajectory::DataSource velSource[]) const
+{
+  // Velocity comes from the same elements as position, but in the velocity optional
+  for(int i = 0; i < 3; ++i)
+  {
+    velSource[i] = _dataSource[i];
+    if(_dataSource[i]._src == Trajectory::POSOPT) velSource[i]._opt = _velOpt;
+    else if(_dataSource[i]._src != Trajectory::ZERO) return false; // Velocity not available
+  }
+  return ((_velOpt != 0) && _follow->verifyData(velSource));
+}
+
+bool TrajectoryFollower::_extrapolate(double time, unsigned int numPoints, const Trajectory::DataArray &times, FollowData data)
+{
+  // Extrapolation needs the last two points to have distinct times
+  const int last = numPoints - 1;
+  if((last < 1) || (times[last] == times[last-1])) return false;
+
+  // Limit extrapolation to the horizon past the last point
+  const double tLast = times[last];
+  const double dtLast = tLast - times[last-1];
+  double dt = time - tLast;
+  if(std::abs(dt) > _extrapHorizon) dt = (dt > 0.0) ? _extrapHorizon : -_extrapHorizon;
+
+  if(data == POSITION)
+  {
+    // Use velocity optional if available, otherwise difference of last two points
+    Trajectory::DataSource velSource[3];
+    if(_getVelocitySource(velSource))
+      _follow->getPoint(last, velSource, _extrapVel._v);
+    else
+    {
+      _follow->getPoint(last-1, _dataSource, _v2._v);
+      _follow->getPoint(last, _dataSource, _v1._v);
+      _extrapVel = (_v1 - _v2)/dtLast;
+    }
+
+    // Polynomial through the last points, falling back to velocity if needed
+    bool extrapolated = false;
+    if(_extrapType == POLYNOMIAL_EXTRAPOLATION)
+    {
+      const int numInterp = std::min(_lagrangeOrder + 1, numPoints);
+      if(numInterp >= 3)
+        extrapolated = _evaluateLagrange(numPoints - numInterp, numInterp, tLast + dt, times);
+    }
+
+    if(!extrapolated)
+    {
+      _follow->getPoint(last, _dataSource, _v1._v);
+      _v1 += _extrapVel*dt;
+    }
+  }
+  else
+  {
+    // Continue rotating at the rate between the last two attitudes
+    _follow->getAttitude(last-1, _a2[0], _a2[1], _a2[2], _a2[3]);
+    _follow->getAttitude(last, _a1[0], _a1[1], _a1[2], _a1[3]);
+    _a1.slerp(1.0 + dt/dtLast, _a2, _a1);
+  }
+
+  return true;
+}
+
+void TrajectoryFollower::_blendExtrapolation(double time, unsigned int numPoints, bool extrapolated, FollowData data)
+{
+  ExtrapolationState &state = (data == POSITION) ? _posExtrap : _attExtrap;
+
+  // New points arrived while extrapolating, so start blending from the
+  // previously extrapolated state to the new state
+  const bool startBlend = state._extrapolated && (numPoints != state._numPoints) && (_extrapBlendTime > 0.0);
+  if(startBlend) state._blendStart = time;
+
+  // Blend weight smoothly decreases from 1 to 0 over the blend time
+  double weight = 0.0;
+  if(_extrapBlendTime > 0.0)
+  {
+    double s = (time - state._blendStart)/_extrapBlendTime;
+    if((s >= 0.0) && (s < 1.0)) weight = 1.0 - s*s*(3.0 - 2.0*s);
+  }
+
+  if(data == POSITION)
+  {
+    // Offset from new position to previous position, projected to the current time
+    if(startBlend) _posOffset = _prevPos + _prevVel*(time - state._time) - _v1;
+    if(weight > 0.0) _v1 += _posOffset*weight;
+    _prevPos = _v1;
+    _prevVel = _extrapVel;
+  }
+  else
+  {
+    // Rotation from new attitude to previous attitude
+    if(startBlend) _attOffset = quatMult(_prevAtt, _a1.inverse());
+    if(weight > 0.0)
+    {
+      osg::Quat offset;
+      offset.slerp(weight, osg::Quat(), _attOffset);
+      _a1 = quatMult(offset, _a1);
+    }
+    _prevAtt = _a1;
+  }
+
+  state._extrapolated = extrapolated;
+  state._numPoints = numPoints;
+  state._time = time;
+}
   
 } // !namespace OpenFrames
@@ -97,19 +97,65 @@ bool TransformAccumulator::isValid()
 /** Get the transform from the origin frame to its root frame */
 osg::Matrixd& TransformAccumulator::getLocalToWorld()
 {
-	_transformVisitor->_coordMode = TransformVisitor::LOCAL_TO_WORLD;
-	_transformVisitor->accumulate(_lookAtPath->getFramePath());
-
-	return _transformVisitor->_matrix;
+	_matrix = _accumulate(_localToWorld, TransformVisitor::LOCAL_TO_WORLD);
+	return _matrix;
 }
 
 /** Get the transform from the root frame to the origin frame */
 osg::Matrixd& TransformAccumulator::getWorldToLocal()
 {
-	_transformVisitor->_coordMode = TransformVisitor::WORLD_TO_LOCAL;
-	_transformVisitor->accumulate(_lookAtPath->getFramePath());
+	_matrix = _accumulate(_worldToLocal, TransformVisitor::WORLD_TO_LOCAL);
+	return _matrix;
+}
 
-	return _transformVisitor->_matrix;
+/** Recompute cached transforms starting at the first changed frame in the path */
+const osg::Matrixd& TransformAccumulator::_accumulate(TransformCache &cache, TransformVisitor::CoordMode mode)
+{
+	static const osg::Matrixd identity;
+	const FramePath &framePath = _lookAtPath->getFramePath();
+	unsigned int numFrames = framePath.size();
+
+	  // Get generations before checking transforms, so that any changes made
+	  // during this call cause the next call to check transforms again
+	unsigned int globalGeneration = FrameTransform::getGlobalGeneration();
+	unsigned int pathGeneration = _lookAtPath->getPathGeneration();
+
+	  // A different frame path invalidates all cached transforms
+	if( cache._valid && (cache._pathGeneration != pathGeneration) )
+	  cache._valid = false;
+
+	  // No FrameTransform has changed since the cached transforms were computed
+	if( cache._valid && (cache._globalGeneration == globalGeneration) )
+	  return (numFrames == 0) ? identity : cache._matrices.back();
+
+	  // Find first frame whose transform has changed
+	unsigned int start = 0;
+	if( cache._valid )
+	{
+	  while( (start < numFrames) && 
+	         (framePath[start]->getTransform()->getGeneration() == cache._generations[start]) )
+	    ++start;
+	}
+
+	cache._matrices.resize(numFrames);
+	cache._generations.resize(numFrames);
+
+	  // Accumulate transforms from the first changed frame onwards
+	_transformVisitor->_coordMode = mode;
+	_transformVisitor->_matrix = (start == 0) ? identity : cache._matrices[start-1];
+	for( unsigned int i = start; i < numFrames; ++i )
+	{
+	  FrameTransform *xform = framePath[i]->getTransform();
+	  cache._generations[i] = xform->getGeneration();
+	  _transformVisitor->apply(*xform); // Applies even if frame is hidden
+	  cache._matrices[i] = _transformVisitor->_matrix;
+	}
+
+	cache._pathGeneration = pathGeneration;
+	cache._globalGeneration = globalGeneration;
+	cache._valid = true;
+
+	return (numFrames == 0) ? identity : cache._matrices.back();
 }
 
 } // !namespace OpenFrames
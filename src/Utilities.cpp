@@ -19,6 +19,9 @@
  */
 
 #include <OpenFrames/Utilities.hpp>
+#include <OpenThreads/ScopedLock>
+#include <algorithm>
+#include <cmath>
 
 namespace OpenFrames
 {
@@ -50,6 +53,29 @@ namespace OpenFrames
     }
   }
 
+  /**********************************************/
+  bool makeReversedZProjection(osg::Matrix& proj, const double &zNear)
+  {
+    double left, right, bottom, top, oldNear, oldFar;
+    
+    // Orthographic projections have no perspective divide to reverse
+    double epsilon = 1.0e-6;
+    if (fabs(proj(0, 3)) < epsilon &&
+        fabs(proj(1, 3)) < epsilon &&
+        fabs(proj(2, 3)) < epsilon) return false;
+    
+    // Move the near plane while keeping the same field of view
+    proj.getFrustum(left, right, bottom, top, oldNear, oldFar);
+    const double nz = zNear / oldNear;
+    proj.makeFrustum(left*nz, right*nz, bottom*nz, top*nz, zNear, 2.0*zNear);
+    
+    // Clip-space z is the constant zNear and clip-space w is the eye distance,
+    // so depth is zNear/distance after the perspective divide
+    proj(0, 2) = proj(1, 2) = proj(2, 2) = 0.0;
+    proj(3, 2) = zNear;
+    return true;
+  }
+
   /*******************************************************/
   osg::Viewport* getMainViewport(osg::View *view)
   {
@@ -91,15 +117,82 @@ namespace OpenFrames
     return gc;
   }
   
+  /*******************************************************/
+  void LockStats::reset()
+  {
+    _numAcquisitions = _numHolds = 0;
+    _totalWait = _maxWait = _totalHold = _maxHold = 0.0;
+    std::fill(_waitHist, _waitHist + NUM_BINS, 0);
+    std::fill(_holdHist, _holdHist + NUM_BINS, 0);
+  }
+
+  /*******************************************************/
+  void LockStats::addWait(double t)
+  {
+    ++_numAcquisitions;
+    _totalWait += t;
+    _maxWait = std::max(_maxWait, t);
+    ++_waitHist[getBin(t)];
+  }
+
+  /*******************************************************/
+  void LockStats::addHold(double t)
+  {
+    ++_numHolds;
+    _totalHold += t;
+    _maxHold = std::max(_maxHold, t);
+    ++_holdHist[getBin(t)];
+  }
+
+  /*******************************************************/
+  unsigned int LockStats::getBin(double t)
+  {
+    double us = t*1.0e6;
+    if(us < 1.0) return 0;
+
+    int exp;
+    std::frexp(us, &exp); // us = m*2^exp with m in [0.5, 1), so bin = exp
+    return std::min((unsigned int)exp, (unsigned int)(NUM_BINS - 1));
+  }
+
+  /*******************************************************/
+  double LockStats::getBinLimit(unsigned int bin)
+  {
+    return std::ldexp(1.0e-6, bin);
+  }
+
+  /*******************************************************/
+  double LockStats::_getPercentile(const unsigned int hist[], unsigned int count, double p)
+  {
+    if(count == 0) return 0.0;
+
+    // Find the bin where the cumulative count reaches the percentile
+    double target = std::max(1.0, std::ceil(count*std::min(std::max(p, 0.0), 100.0)/100.0));
+    unsigned int sum = 0;
+    for(unsigned int i = 0; i < NUM_BINS; ++i)
+    {
+      sum += hist[i];
+      if(sum >= target) return getBinLimit(i);
+    }
+    return getBinLimit(NUM_BINS - 1);
+  }
+  
   /*******************************************************/
   int ReadWriteMutex::readLock()
   {
+    osg::Timer_t startTick = _statsEnabled ? osg::Timer::instance()->tick() : 0;
     _countLock.lock();
     while(_writerWaitCount > 0)
     {
       _turnCond.wait(&_countLock);
     }
     ++_readerCount;
+    if(_statsEnabled && (startTick != 0))
+    {
+      osg::Timer_t currTick = osg::Timer::instance()->tick();
+      _readStats.addWait(osg::Timer::instance()->delta_s(startTick, currTick));
+      if(_readerCount == 1) _readHoldStart = currTick;
+    }
     return _countLock.unlock();
   }
   
@@ -108,6 +201,11 @@ namespace OpenFrames
   {
     _countLock.lock();
     --_readerCount;
+    if((_readerCount == 0) && (_readHoldStart != 0))
+    {
+      _readStats.addHold(osg::Timer::instance()->delta_s(_readHoldStart, osg::Timer::instance()->tick()));
+      _readHoldStart = 0;
+    }
     _turnCond.broadcast();
     return _countLock.unlock();
   }
@@ -115,6 +213,7 @@ namespace OpenFrames
   /*******************************************************/
   int ReadWriteMutex::writeLock()
   {
+    osg::Timer_t startTick = _statsEnabled ? osg::Timer::instance()->tick() : 0;
     _countLock.lock();
     ++_writerWaitCount;
     while((_writerCount > 0) || (_readerCount > 0))
@@ -122,6 +221,11 @@ namespace OpenFrames
       _turnCond.wait(&_countLock);
     }
     ++_writerCount;
+    if(_statsEnabled && (startTick != 0))
+    {
+      _writeHoldStart = osg::Timer::instance()->tick();
+      _writeStats.addWait(osg::Timer::instance()->delta_s(startTick, _writeHoldStart));
+    }
     return _countLock.unlock();
   }
   
@@ -131,8 +235,38 @@ namespace OpenFrames
     _countLock.lock();
     --_writerWaitCount;
     --_writerCount;
+    if(_writeHoldStart != 0)
+    {
+      _writeStats.addHold(osg::Timer::instance()->delta_s(_writeHoldStart, osg::Timer::instance()->tick()));
+      _writeHoldStart = 0;
+    }
     _turnCond.broadcast();
     return _countLock.unlock();
   }
+
+  /*******************************************************/
+  void ReadWriteMutex::setStatsEnabled(bool enable)
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_countLock);
+    _statsEnabled = enable;
+
+    // Don't record holds that started while stats were enabled
+    if(!enable) _readHoldStart = _writeHoldStart = 0;
+  }
+
+  /*******************************************************/
+  LockStats ReadWriteMutex::getStats(LockType type) const
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_countLock);
+    return (type == READ) ? _readStats : _writeStats;
+  }
+
+  /*******************************************************/
+  void ReadWriteMutex::resetStats()
+  {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_countLock);
+    _readStats.reset();
+    _writeStats.reset();
+  }
   
 } // !namespace OpenFrames
@@ -51,7 +51,8 @@ Vector::Vector( const osg::Vec3d& vec )
 	// Enable transparency and color blending
 	osg::StateSet *ss = _vec->getOrCreateStateSet();
 	osg::BlendFunc *bf = new osg::BlendFunc();
-	bf->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
+	bf->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA,
+	                osg::BlendFunc::ONE, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
 	ss->setAttributeAndModes(bf);
 	ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
 
@@ -20,10 +20,17 @@
 
 #include <OpenFrames/WindowProxy.hpp>
 #include <OpenFrames/FramerateLimiter.hpp>
+#include <OpenFrames/FrameTransform.hpp>
+#include <OpenFrames/Trajectory.hpp>
 #include <OpenFrames/Utilities.hpp>
 #include <osg/GraphicsContext>
 #include <osg/PointSprite>
+#include <osg/Stats>
+#include <osgDB/FileNameUtils>
 #include <osgGA/GUIEventHandler>
+#include <OpenThreads/Block>
+#include <OpenThreads/ScopedLock>
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -469,11 +476,116 @@ namespace OpenFrames
     WindowProxy* _windowProxy;
   };
   
+  /**
+   GraphicsWindow that renders to an offscreen pixel buffer (pbuffer). This lets
+   the WindowProxy treat an offscreen context just like an on-screen window.
+   */
+  class OffscreenGraphics : public osgViewer::GraphicsWindow
+  {
+  public:
+    OffscreenGraphics(osg::GraphicsContext *pbuffer)
+    : _pbuffer(pbuffer)
+    {
+      _traits = new GraphicsContext::Traits(*pbuffer->getTraits());
+
+      // Track OpenGL state with a new State, so that GL objects are managed by this
+      // context. The pbuffer keeps its own State, which is never used to draw.
+      osg::State* state = new osg::State;
+      setState(state);
+      state->setGraphicsContext(this);
+      state->setContextID(osg::GraphicsContext::createNewContextID());
+    }
+
+    virtual bool isSameKindAs(const Object* object) const { return dynamic_cast<const OffscreenGraphics*>(object)!=0; }
+    virtual const char* libraryName() const { return "OpenFrames"; }
+    virtual const char* className() const { return "OffscreenGraphics"; }
+
+    /** Inherited from GraphicsWindow, these functions forward context management to the pbuffer */
+    virtual bool valid() const { return _pbuffer->valid(); }
+    virtual bool realizeImplementation() { return _pbuffer->realizeImplementation(); }
+    virtual bool isRealizedImplementation() const { return _pbuffer->isRealizedImplementation(); }
+    virtual void closeImplementation() { _pbuffer->closeImplementation(); }
+    virtual bool makeCurrentImplementation() { return _pbuffer->makeCurrentImplementation(); }
+    virtual bool releaseContextImplementation() { return _pbuffer->releaseContextImplementation(); }
+    virtual void swapBuffersImplementation() { _pbuffer->swapBuffersImplementation(); }
+
+    /** Offscreen contexts have no focus or window to raise */
+    virtual void grabFocus() {}
+    virtual void grabFocusIfPointerInWindow() {}
+    virtual void raiseWindow() {}
+
+  protected:
+    virtual ~OffscreenGraphics() {}
+
+    osg::ref_ptr<osg::GraphicsContext> _pbuffer;
+  };
+
+  /**
+   Captures the finished frame and measures time taken to swap buffers, using
+   another swap callback if one exists. Also signals when a frame has been swapped,
+   for threading models that draw in a separate thread.
+   */
+  class TimedSwapCallback : public osg::GraphicsContext::SwapCallback
+  {
+  public:
+    TimedSwapCallback(osg::GraphicsContext::SwapCallback *swapCallback, FrameCapture *frameCapture)
+    : _swapCallback(swapCallback), _frameCapture(frameCapture), _swapTime(0.0)
+    {}
+
+    virtual void swapBuffersImplementation(osg::GraphicsContext *gc)
+    {
+      // Capture all RenderRectangles before the back buffer is swapped
+      _frameCapture->capture(gc);
+
+      osg::Timer_t startTick = osg::Timer::instance()->tick();
+      if(_swapCallback.valid()) _swapCallback->swapBuffersImplementation(gc);
+      else gc->swapBuffersImplementation();
+      double swapTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+      {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_swapMutex);
+        _swapTime += swapTime;
+      }
+      _frameDone.release();
+    }
+
+    // Get and clear the time spent swapping buffers since the last reset
+    double getSwapTime()
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_swapMutex);
+      return _swapTime;
+    }
+    void resetSwapTime()
+    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_swapMutex);
+      _swapTime = 0.0;
+    }
+
+    // Clear the swapped signal before rendering a frame
+    void resetFrameDone() { _frameDone.reset(); }
+
+    // Wait until the frame has been swapped, or until the timeout (msec) expires
+    void waitForFrameDone(unsigned long timeout) { _frameDone.block(timeout); }
+
+  protected:
+    virtual ~TimedSwapCallback() {}
+
+    osg::ref_ptr<osg::GraphicsContext::SwapCallback> _swapCallback;
+    osg::ref_ptr<FrameCapture> _frameCapture;
+    OpenThreads::Block _frameDone;
+    double _swapTime; // Time spent swapping buffers, may be updated by a draw thread
+    OpenThreads::Mutex _swapMutex;
+  };
+  
   WindowProxy::WindowProxy( int x, int y, unsigned int width, unsigned int height,
                            unsigned int nrow, unsigned int ncol, bool embedded, bool useVR )
   : _winID(0), _nRow(0), _nCol(0), _isEmbedded(embedded),
+  _isOffscreen(false), _maxFrames(0),
+  _renderOnDemand(false), _redrawRequested(1), _partitionsDirty(0),
+  _scenesGeneration(0), _transformGeneration(0), _trajectoryGeneration(0),
+  _frameTimingEnabled(false), _throttleTime(0.0), _timingTextTick(0),
   _animationState(IDLE), _pauseAnimation(false),
-  _timePaused(false), _useVR(useVR)
+  _timePaused(false), _fixedTimeStep(0.0), _numTimeSteps(0), _useVR(useVR),
+  _threadingModel(osgViewer::ViewerBase::SingleThreaded)
   {
     // Input value checks
     if(x < 0) x = 0;
@@ -490,6 +602,8 @@ namespace OpenFrames
     _statsHandler = new osgViewer::StatsHandler;
     _screenCaptureHandler = new osgViewer::ScreenCaptureHandler;
     _screenCaptureHandler->setKeyEventToggleContinuousCapture(0); // Disable continuous capture
+    _frameTiming = new FrameTimingStats;
+    _frameCapture = new FrameCapture;
     
     setWindowName("OpenFrames Window");
     
@@ -567,6 +681,43 @@ namespace OpenFrames
     else _embeddedGraphics->setWindowName(name);
   }
   
+  void WindowProxy::setOffscreen(bool offscreen)
+  {
+    if(_animationState != IDLE)
+    {
+      OSG_WARN << "WindowProxy::setOffscreen must be called before animation starts." << std::endl;
+    }
+    else if(offscreen && (_isEmbedded || _useVR))
+    {
+      OSG_WARN << "WindowProxy::setOffscreen not available for embedded or VR windows." << std::endl;
+    }
+    else _isOffscreen = offscreen;
+  }
+
+  void WindowProxy::setThreadingModel(osgViewer::ViewerBase::ThreadingModel model)
+  {
+    if(model == osgViewer::ViewerBase::AutomaticSelection)
+    {
+      model = _viewer->suggestBestThreadingModel();
+    }
+
+    // Embedded contexts are made current by the user's own windowing thread, and
+    // VR buffers are submitted from the rendering thread
+    if((model != osgViewer::ViewerBase::SingleThreaded) && (_isEmbedded || _useVR))
+    {
+      OSG_WARN << "WindowProxy::setThreadingModel: Embedded and VR windows are always single-threaded." << std::endl;
+      return;
+    }
+
+    _threadingModel = model; // Applied at the start of the next frame
+  }
+
+  void WindowProxy::setRenderOnDemand(bool onDemand)
+  {
+    _renderOnDemand = onDemand;
+    requestRedraw();
+  }
+  
   std::string WindowProxy::getWindowName() const
   {
     if(_window) return _window->getWindowName();
@@ -601,6 +752,31 @@ namespace OpenFrames
       state->setContextID(osg::GraphicsContext::createNewContextID());
       _window = _embeddedGraphics.get();
     }
+    else if(_isOffscreen) // Create an offscreen pixel buffer for OpenGL graphics
+    {
+      // Get default window traits that are saved in the EmbeddedGraphics object
+      osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+      *traits = *(_embeddedGraphics->getTraits());
+      traits->readDISPLAY(); // Pixel buffers still need a display connection on X11
+      traits->windowDecoration = false;
+      traits->doubleBuffer = false; // Pixel buffers are never shown, so don't need a back buffer
+      traits->pbuffer = true;
+      traits->vsync = false;
+      traits->samples = 4; // Enable 4x MSAA
+
+      // Try creating graphics context
+      osg::GraphicsContext* gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+
+      // On error, try again without MSAA
+      if(!gc)
+      {
+        OSG_WARN << "Couldn't create 4x MSAA offscreen buffer, trying again without MSAA..." << std::endl;
+        traits->samples = 0; // Disable MSAA
+        gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+      }
+
+      if(gc && gc->getState()) _window = new OffscreenGraphics(gc);
+    }
     else // Otherwise create a new window for OpenGL graphics
     {
       // Get default window traits that are saved in the EmbeddedGraphics object (even if it is not used)
@@ -656,6 +832,10 @@ namespace OpenFrames
       
       // Disable swap buffers
       if(_useVR) _window->setSwapCallback(new OpenVRSwapBuffers(_ovrDevice, _vrTextureBuffer));
+
+      // Capture frames and measure swap time for frame timing statistics
+      _swapCallback = new TimedSwapCallback(_window->getSwapCallback(), _frameCapture.get());
+      _window->setSwapCallback(_swapCallback.get());
     }
     else
     {
@@ -694,6 +874,9 @@ namespace OpenFrames
         if(currScene) _scenes.insert(currScene);
       }
     }
+
+    // Displayed scenes may have changed
+    requestRedraw();
   }
   
   /** Get the width of the displayed window */
@@ -790,6 +973,8 @@ namespace OpenFrames
       else if(time > _maxTime) time = _maxTime;
       _currTime = _offsetTime = time;
       _Tref = osg::Timer::instance()->tick();
+      _numTimeSteps = 0;
+      requestRedraw();
     }
   }
   
@@ -826,6 +1011,13 @@ namespace OpenFrames
     }
   }
   
+  /** Change fixed time step */
+  void WindowProxy::setFixedTimeStep(double dt)
+  {
+    _fixedTimeStep = (dt > 0.0) ? dt : 0.0;
+    setTime(_currTime);
+  }
+  
   /** Change time scale */
   void WindowProxy::setTimeScale(double tscale)
   {
@@ -1004,15 +1196,22 @@ namespace OpenFrames
     // suck up time on Proc0
     _viewer->setProcessorAffinity(OpenThreads::Affinity());
     
-    // Finally set threading model
+    // Finally set threading model. Threads are started when the viewer is realized.
     _viewer->setUseConfigureAffinity(false); // Already called configureAffinity
-    _viewer->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+    _viewer->setThreadingModel(_threadingModel);
     
     // Controls the framerate while graphics are paused
     FramerateLimiter pauseLimiter(10.0);
     
+    // Time (sec) to sleep between checks for changes while rendering on demand.
+    // Doubles while nothing changes, up to the maximum.
+    const double minIdleWait = 0.01, maxIdleWait = 0.1;
+    double idleWait = minIdleWait;
+    
     // Set the reference time
     _Tref = osg::Timer::instance()->tick();
+    _numTimeSteps = 0;
+    unsigned int numFrames = 0;
     
     // Initialize animation state
     _animationState = _pauseAnimation ? PAUSED : ANIMATING;
@@ -1020,6 +1219,9 @@ namespace OpenFrames
     // Loop until the user asks us to quit
     while(!_viewer->done())
     {
+      // Apply threading model changes from the thread that owns the viewer
+      if(_viewer->getThreadingModel() != _threadingModel) _viewer->setThreadingModel(_threadingModel);
+
       if(_pauseAnimation)
       {
         _animationState = PAUSED;
@@ -1029,11 +1231,34 @@ namespace OpenFrames
       {
         _animationState = ANIMATING;
 
-        // Pause to achieve desired framerate
-        _frameThrottle.frame();
+        // Pause to achieve desired framerate, unless rendering offscreen as fast as possible
+        if(!_isOffscreen)
+        {
+          osg::Timer_t throttleTick = osg::Timer::instance()->tick();
+          _frameThrottle.frame();
+          _throttleTime = osg::Timer::instance()->delta_s(throttleTick, osg::Timer::instance()->tick());
+        }
+
+        // Skip frames that would look the same as the previous one, sleeping until a
+        // redraw is requested or it's time to check for other changes. The block is
+        // reset before checking so that requests made during the check aren't missed.
+        if(_renderOnDemand)
+        {
+          _redrawBlock.reset();
+          if(!checkNeedToDoFrame())
+          {
+            _redrawBlock.block((unsigned long)(idleWait*1000.0));
+            idleWait = std::min(2.0*idleWait, maxIdleWait);
+            continue;
+          }
+          idleWait = minIdleWait;
+        }
         
         // Do one frame: check events, update objects, render scene
         frame();
+
+        // Stop after the maximum number of frames
+        if((_maxFrames > 0) && (++numFrames >= _maxFrames)) shutdown();
       }
     }
     
@@ -1041,6 +1266,15 @@ namespace OpenFrames
     // not done, then the graphics context will be released when this
     // WindowProxy is destroyed. This could result in a seg fault if
     // the context is already destroyed before OSG can release it.
+    // Rendering threads are stopped first so that this thread can use the context.
+    // Captured frames still in PBOs are read before the PBOs are deleted.
+    _viewer->stopThreading();
+    _frameCapture->stop();
+    if(_window->makeCurrent())
+    {
+      _frameCapture->capture(_window.get());
+      _frameCapture->releaseGLObjects(_window.get());
+    }
     _window->close();
     
     // Shutdown OpenVR if needed
@@ -1052,36 +1286,216 @@ namespace OpenFrames
   /** Handle one frame of animation, including event handling */
   void WindowProxy::frame()
   {
-    // Use simulation time from synchonized WindowProxy
-    if(_timeSyncWinProxy.valid())
+    const osg::Timer *timer = osg::Timer::instance();
+    osg::Timer_t startTick = timer->tick();
+
+    // Lock all scenes so that they aren't modified while being drawn. Double-buffered
+    // scenes aren't locked, and instead swap in states that were staged since the
+    // previous frame.
+    _scenesLocked.resize(_scenes.size());
+    unsigned int sceneIndex = 0;
+    for(SceneSet::iterator sceneIter = _scenes.begin(); sceneIter != _scenes.end(); ++sceneIter, ++sceneIndex)
     {
-      _currTime = _timeSyncWinProxy->getTime();
+      _scenesLocked[sceneIndex] = (*sceneIter)->beginRender();
     }
-    
-    // Otherwise compute current simulation time if not paused
-    else if(!_timePaused)
+    osg::Timer_t lockTick = timer->tick();
+
+    // Compute current simulation time
+    _currTime = computeFrameTime();
+    if(!_timeSyncWinProxy.valid() && !_timePaused && (_fixedTimeStep > 0.0)) ++_numTimeSteps;
+
+    // Remember scene state drawn in this frame, for render-on-demand. Changes made
+    // from now on, including by this frame's update traversal, cause another frame.
+    _scenesGeneration = getScenesGeneration();
+    _transformGeneration = FrameTransform::getGlobalGeneration();
+    _trajectoryGeneration = Trajectory::getGlobalGeneration();
+    if(_partitionsDirty.exchange(0) != 0)
     {
-      double dt = osg::Timer::instance()->delta_s(_Tref, osg::Timer::instance()->tick());
-      _currTime = _offsetTime + dt*_timeScale;
-      if(_currTime < _minTime) _currTime = _minTime;
-      else if(_currTime > _maxTime) _currTime = _maxTime;
+      for(unsigned int i = 0; i < _renderList.size(); ++i)
+      {
+        _renderList[i]->getDepthPartitioner()->getCallback()->dirtyCache();
+      }
     }
+
+    // Draw threads can still be drawing when the viewer's frame returns, and scene
+    // objects aren't necessarily DYNAMIC, so keep scenes locked until the frame is swapped
+    osgViewer::ViewerBase::ThreadingModel threadingModel = _viewer->getThreadingModel();
+    bool waitForDraw = _viewer->areThreadsRunning() &&
+      ((threadingModel == osgViewer::ViewerBase::DrawThreadPerContext) ||
+       (threadingModel == osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext));
+    if(waitForDraw) _swapCallback->resetFrameDone();
+
+    // The first frame also initializes the viewer, so don't split it into timed phases
+    bool timeFrame = _frameTimingEnabled && !_viewer->done() &&
+                     (_viewer->getFrameStamp()->getFrameNumber() > 0);
+    FrameTimingStats::FrameTiming timing;
     
-    // Lock all scenes so that they aren't modified while being drawn
-    for(SceneSet::iterator sceneIter = _scenes.begin(); sceneIter != _scenes.end(); ++sceneIter)
+    // Process events, then update, cull, and draw all scenes
+    if(timeFrame)
     {
-      (*sceneIter)->lock(FrameManager::LOW_PRIORITY);
+      updateFrameTimingText();
+      timedViewerFrame(timing);
     }
+    else _viewer->frame(_currTime);
     
-    // Process events, then update, cull, and draw all scenes
-    _viewer->frame(_currTime);
+    // Wait with a timeout, in case the draw thread skips the swap (e.g. window closing)
+    if(waitForDraw) _swapCallback->waitForFrameDone(1000);
     
     // Unlock all scenes so that they can be modified
-    for(SceneSet::iterator sceneIter = _scenes.begin(); sceneIter != _scenes.end(); ++sceneIter)
+    sceneIndex = 0;
+    for(SceneSet::iterator sceneIter = _scenes.begin(); sceneIter != _scenes.end(); ++sceneIter, ++sceneIndex)
     {
-      (*sceneIter)->unlock(FrameManager::LOW_PRIORITY);
+      (*sceneIter)->endRender(_scenesLocked[sceneIndex]);
+    }
+
+    // Save frame timing, with unmeasured time attributed to the OTHER phase
+    if(timeFrame)
+    {
+      timing._times[FrameTimingStats::THROTTLE] = _throttleTime;
+      timing._times[FrameTimingStats::LOCK] = timer->delta_s(startTick, lockTick);
+      timing._times[FrameTimingStats::SWAP] = _swapCallback->getSwapTime(); // Draw threads have swapped by now
+      timing._times[FrameTimingStats::TOTAL] = _throttleTime + timer->delta_s(startTick, timer->tick());
+
+      double other = timing._times[FrameTimingStats::TOTAL];
+      for(unsigned int i = 0; i < FrameTimingStats::OTHER; ++i) other -= timing._times[i];
+      timing._times[FrameTimingStats::OTHER] = std::max(other, 0.0);
+
+      _frameTiming->addFrame(timing);
     }
   }
+
+  /** Compute simulation time of the next frame, without changing the current time */
+  double WindowProxy::computeFrameTime() const
+  {
+    // Use simulation time from synchonized WindowProxy
+    if(_timeSyncWinProxy.valid()) return _timeSyncWinProxy->getTime();
+
+    // Time doesn't change while paused
+    if(_timePaused) return _currTime;
+
+    // Fixed time steps are counted rather than accumulated, so that the
+    // same frame always gets exactly the same time
+    const osg::Timer *timer = osg::Timer::instance();
+    double dt;
+    if(_fixedTimeStep > 0.0) dt = _numTimeSteps*_fixedTimeStep;
+    else dt = timer->delta_s(_Tref, timer->tick());
+
+    double time = _offsetTime + dt*_timeScale;
+    if(time < _minTime) time = _minTime;
+    else if(time > _maxTime) time = _maxTime;
+    return time;
+  }
+
+  /** Sum of generation counters of all scenes, which changes if any scene changes */
+  unsigned int WindowProxy::getScenesGeneration() const
+  {
+    unsigned int generation = 0;
+    for(SceneSet::const_iterator sceneIter = _scenes.begin(); sceneIter != _scenes.end(); ++sceneIter)
+    {
+      generation += (*sceneIter)->getGeneration();
+    }
+    return generation;
+  }
+
+  /** Determine whether anything changed since the previous frame was rendered */
+  bool WindowProxy::checkNeedToDoFrame()
+  {
+    // Explicitly requested, e.g. the first frame or changed time
+    if(_redrawRequested.exchange(0) != 0) return true;
+
+    // VR headsets and frame capture need every frame
+    if(_useVR || _frameCapture->hasPendingFrames()) return true;
+
+    // Requested by OSG, e.g. by a thrown camera manipulator or an animating view transition
+    if(_viewer->getRequestRedraw() || _viewer->getRequestContinousUpdate()) return true;
+
+    // Simulation time advanced
+    if(computeFrameTime() != _currTime) return true;
+
+    // Scene modified
+    if(getScenesGeneration() != _scenesGeneration) return true;
+    if(FrameTransform::getGlobalGeneration() != _transformGeneration) return true;
+    if(Trajectory::getGlobalGeneration() != _trajectoryGeneration) return true;
+
+    // Poll the windowing system for input events, including resizes and exposures
+    return _viewer->checkEvents();
+  }
+
+  /** Do the same work as osgViewer::ViewerBase::frame(), but time each phase */
+  void WindowProxy::timedViewerFrame(FrameTimingStats::FrameTiming &timing)
+  {
+    const osg::Timer *timer = osg::Timer::instance();
+
+    // Make sure all cameras record their cull and draw times, including
+    // depth partitioning cameras that may have been created since the last frame
+    osgViewer::ViewerBase::Cameras cameras;
+    _viewer->getCameras(cameras);
+    for(osgViewer::ViewerBase::Cameras::iterator camIter = cameras.begin(); camIter != cameras.end(); ++camIter)
+    {
+      if(!(*camIter)->getStats()) (*camIter)->setStats(new osg::Stats("Camera"));
+      (*camIter)->getStats()->collectStats("rendering", true);
+    }
+
+    _swapCallback->resetSwapTime();
+    _viewer->advance(_currTime);
+
+    osg::Timer_t eventTick = timer->tick();
+    _viewer->eventTraversal();
+    osg::Timer_t updateTick = timer->tick();
+    _viewer->updateTraversal();
+    osg::Timer_t renderTick = timer->tick();
+    _viewer->renderingTraversals();
+
+    // Depth partitioning is done during the update traversal
+    double dpTime = 0.0;
+    for(unsigned int i = 0; i < _renderList.size(); ++i)
+    {
+      dpTime += _renderList[i]->getDepthPartitioner()->getCallback()->getPartitionTime();
+    }
+
+    // Sum cull and draw times of all cameras rendered this frame
+    unsigned int frameNumber = _viewer->getFrameStamp()->getFrameNumber();
+    double cullTime = 0.0, drawTime = 0.0, camTime;
+    _viewer->getCameras(cameras);
+    for(osgViewer::ViewerBase::Cameras::iterator camIter = cameras.begin(); camIter != cameras.end(); ++camIter)
+    {
+      osg::Stats *stats = (*camIter)->getStats();
+      if(!stats) continue;
+      if(stats->getAttribute(frameNumber, "Cull traversal time taken", camTime)) cullTime += camTime;
+      if(stats->getAttribute(frameNumber, "Draw traversal time taken", camTime)) drawTime += camTime;
+    }
+
+    timing._frameNumber = frameNumber;
+    timing._times[FrameTimingStats::EVENT] = timer->delta_s(eventTick, updateTick);
+    timing._times[FrameTimingStats::UPDATE] = std::max(timer->delta_s(updateTick, renderTick) - dpTime, 0.0);
+    timing._times[FrameTimingStats::DEPTH_PARTITION] = dpTime;
+    timing._times[FrameTimingStats::CULL] = cullTime;
+    timing._times[FrameTimingStats::DRAW] = drawTime;
+  }
+
+  /** Show latest frame timing statistics on RenderRectangles that display them */
+  void WindowProxy::updateFrameTimingText()
+  {
+    // Computing percentiles requires sorting all stored frames, so limit update rate
+    osg::Timer_t currTick = osg::Timer::instance()->tick();
+    if(osg::Timer::instance()->delta_s(_timingTextTick, currTick) < 0.5) return;
+    _timingTextTick = currTick;
+
+    std::string summary;
+    for(unsigned int i = 0; i < _renderList.size(); ++i)
+    {
+      if(!_renderList[i]->getShowFrameTiming()) continue;
+      if(summary.empty()) summary = _frameTiming->getSummary();
+      _renderList[i]->setFrameTimingText(summary);
+    }
+  }
+
+  /** Write frame timing statistics to a JSON or CSV file */
+  bool WindowProxy::writeFrameTiming(const std::string& fname) const
+  {
+    if(osgDB::getLowerCaseFileExtension(fname) == "json") return _frameTiming->writeJSON(fname);
+    else return _frameTiming->writeCSV(fname);
+  }
   
   /** Print info about this window to std::cout */
   void WindowProxy::printInfo()
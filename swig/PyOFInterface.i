@@ -29,7 +29,18 @@
 %apply int* OUTPUT {int* valid};
 %apply bool* OUTPUT {bool* valid};
 %apply int* OUTPUT {int* numchildren};
-%apply int* OUTPUT {double* retvar};
+%apply unsigned int* OUTPUT {unsigned int* retvar};
+%apply double* OUTPUT {double* retvar};
+
+// Lock histograms are returned as lists of 32 bins (see LockStats::NUM_BINS)
+%typemap(in, numinputs=0) unsigned int retarray[] (unsigned int temp[32]) {
+    $1 = temp;
+}
+%typemap(argout) unsigned int retarray[] {
+    PyObject *list = PyList_New(32);
+    for(int i = 0; i < 32; ++i) PyList_SetItem(list, i, PyLong_FromUnsignedLong($1[i]));
+    $result = SWIG_Python_AppendOutput($result, list);
+}
 
 // Blanket apply INPUT type handling to other pointers (except char *)
 %apply int* INPUT {int*};
@@ -44,6 +55,15 @@ void offrame_getattitude(double* retvar, double* retvar, double* retvar, double*
 void ofmodel_getmodelposition(double* retvar, double* retvar, double* retvar);
 void ofmodel_getmodelscale(double* retvar, double* retvar, double* retvar);
 void ofmodel_getmodelpivot(double* retvar, double* retvar, double* retvar);
+void ofwin_getframeintervals(unsigned int* retvar, double* retvar, double* retvar, double* retvar);
+void ofwin_getframetiming(int* phase, double* retvar, double* retvar, double* retvar);
+void ofwin_getcapturestats(unsigned int* retvar, unsigned int* retvar, unsigned int* retvar);
+void offm_getlockstats(int* priority, unsigned int* retvar, double* retvar, double* retvar,
+                       double* retvar, double* retvar);
+void offm_getlockhistograms(int* priority, unsigned int retarray[], unsigned int retarray[]);
+void oftraj_getlockstats(int* lockType, unsigned int* retvar, double* retvar, double* retvar,
+                         double* retvar, double* retvar);
+void oftraj_getlockhistograms(int* lockType, unsigned int retarray[], unsigned int retarray[]);
 
 // Ignore redefinition of the above functions
 %ignore offrame_getposition(double*, double*, double*);
@@ -51,6 +71,13 @@ void ofmodel_getmodelpivot(double* retvar, double* retvar, double* retvar);
 %ignore ofmodel_getmodelposition(double*, double*, double*);
 %ignore ofmodel_getmodelscale(double*, double*, double*);
 %ignore ofmodel_getmodelpivot(double*, double*, double*);
+%ignore ofwin_getframeintervals(unsigned int*, double*, double*, double*);
+%ignore ofwin_getframetiming(int*, double*, double*, double*);
+%ignore ofwin_getcapturestats(unsigned int*, unsigned int*, unsigned int*);
+%ignore offm_getlockstats(int*, unsigned int*, double*, double*, double*, double*);
+%ignore offm_getlockhistograms(int*, unsigned int[], unsigned int[]);
+%ignore oftraj_getlockstats(int*, unsigned int*, double*, double*, double*, double*);
+%ignore oftraj_getlockhistograms(int*, unsigned int[], unsigned int[]);
 
 // Include all interfaces in the header
 %include "OpenFrames/OF_Interface.h"